@@ -0,0 +1,190 @@
+/*
+  ==============================================================================
+
+    AllocationGuard.cpp
+
+  ==============================================================================
+*/
+
+#include "AllocationGuard.h"
+
+#if KLIP_DETECT_AUDIO_THREAD_ALLOCATIONS
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// glibc lets an executable replace malloc and friends and still reach its own
+// allocator through the __libc_* entry points. Not under the sanitizers, which
+// replace them too.
+#if defined(__GLIBC__) && ! defined(__SANITIZE_ADDRESS__) && ! defined(__SANITIZE_THREAD__)
+ #define KLIP_ALLOCATION_GUARD_HOOKS_MALLOC 1
+#else
+ #define KLIP_ALLOCATION_GUARD_HOOKS_MALLOC 0
+#endif
+
+#if KLIP_ALLOCATION_GUARD_HOOKS_MALLOC
+#include <malloc.h>
+
+extern "C" {
+    void* __libc_malloc(std::size_t);
+    void* __libc_calloc(std::size_t, std::size_t);
+    void* __libc_realloc(void*, std::size_t);
+    void* __libc_memalign(std::size_t, std::size_t);
+    void* __libc_valloc(std::size_t);
+    void* __libc_pvalloc(std::size_t);
+    void __libc_free(void*);
+}
+#endif
+
+namespace {
+    // Constant-initialised, so reading it never allocates, even from inside malloc
+    thread_local int guardDepth = 0;
+    std::atomic<int> violations { 0 };
+
+    void countAllocation() {
+        if (guardDepth > 0)
+            violations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void* tryAllocate(std::size_t size) {
+        // With malloc hooked, malloc itself counts
+       #if ! KLIP_ALLOCATION_GUARD_HOOKS_MALLOC
+        countAllocation();
+       #endif
+        return std::malloc(size != 0 ? size : 1);
+    }
+
+    void* allocate(std::size_t size) {
+        if (void* pointer = tryAllocate(size))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    // Over-aligned types: malloc'd with room to align, the malloc'd pointer kept
+    // just below the aligned one for the matching delete. Same on every platform,
+    // so there's no aligned_alloc/_aligned_malloc split to keep in sync.
+    void* tryAllocateAligned(std::size_t size, std::align_val_t alignment) {
+        const auto align = static_cast<std::size_t>(alignment);
+        void* raw = tryAllocate(size + align + sizeof(void*));
+        if (raw == nullptr)
+            return nullptr;
+
+        const auto address = (reinterpret_cast<std::uintptr_t>(raw) + sizeof(void*) + align - 1) & ~static_cast<std::uintptr_t>(align - 1);
+        void* aligned = reinterpret_cast<void*>(address);
+        std::memcpy(static_cast<char*>(aligned) - sizeof(void*), &raw, sizeof(void*));
+        return aligned;
+    }
+
+    void* allocateAligned(std::size_t size, std::align_val_t alignment) {
+        if (void* pointer = tryAllocateAligned(size, alignment))
+            return pointer;
+
+        throw std::bad_alloc();
+    }
+
+    void freeAligned(void* pointer) {
+        if (pointer == nullptr)
+            return;
+
+        void* raw;
+        std::memcpy(&raw, static_cast<char*>(pointer) - sizeof(void*), sizeof(void*));
+        std::free(raw);
+    }
+}
+
+ScopedAllocationGuard::ScopedAllocationGuard() { ++guardDepth; }
+ScopedAllocationGuard::~ScopedAllocationGuard() { --guardDepth; }
+
+int ScopedAllocationGuard::getViolationCount() {
+    return violations.load(std::memory_order_relaxed);
+}
+
+// Every replaceable form, so nothing reaches the heap uncounted: plain, nothrow,
+// over-aligned (DspArena users, juce::dsp SIMD containers) and aligned nothrow.
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return tryAllocate(size); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return tryAllocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tryAllocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return tryAllocateAligned(size, alignment); }
+
+void operator delete(void* pointer) noexcept { std::free(pointer); }
+void operator delete[](void* pointer) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { std::free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { std::free(pointer); }
+void operator delete(void* pointer, std::align_val_t) noexcept { freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t) noexcept { freeAligned(pointer); }
+void operator delete(void* pointer, std::size_t, std::align_val_t) noexcept { freeAligned(pointer); }
+void operator delete[](void* pointer, std::size_t, std::align_val_t) noexcept { freeAligned(pointer); }
+void operator delete(void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(pointer); }
+void operator delete[](void* pointer, std::align_val_t, const std::nothrow_t&) noexcept { freeAligned(pointer); }
+
+#if KLIP_ALLOCATION_GUARD_HOOKS_MALLOC
+// The C allocator, for juce::HeapBlock, AudioBuffer and anything else that
+// skips operator new. Same declarations (and exception specs) as <stdlib.h>.
+extern "C" {
+    void* malloc(std::size_t size) noexcept {
+        countAllocation();
+        return __libc_malloc(size);
+    }
+
+    void* calloc(std::size_t count, std::size_t size) noexcept {
+        countAllocation();
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* pointer, std::size_t size) noexcept {
+        if (size != 0)
+            countAllocation();
+        return __libc_realloc(pointer, size);
+    }
+
+    void free(void* pointer) noexcept {
+        __libc_free(pointer);
+    }
+
+    void* aligned_alloc(std::size_t alignment, std::size_t size) noexcept {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    void* memalign(std::size_t alignment, std::size_t size) noexcept {
+        countAllocation();
+        return __libc_memalign(alignment, size);
+    }
+
+    int posix_memalign(void** result, std::size_t alignment, std::size_t size) noexcept {
+        if (alignment < sizeof(void*) || (alignment & (alignment - 1)) != 0)
+            return EINVAL;
+
+        countAllocation();
+        void* pointer = __libc_memalign(alignment, size);
+        if (pointer == nullptr)
+            return ENOMEM;
+
+        *result = pointer;
+        return 0;
+    }
+
+    void* valloc(std::size_t size) noexcept {
+        countAllocation();
+        return __libc_valloc(size);
+    }
+
+    void* pvalloc(std::size_t size) noexcept {
+        countAllocation();
+        return __libc_pvalloc(size);
+    }
+}
+#endif
+
+#endif
@@ -0,0 +1,45 @@
+/*
+  ==============================================================================
+
+    AllocationGuard.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Check for heap use on the audio thread. Builds that define
+// KLIP_DETECT_AUDIO_THREAD_ALLOCATIONS=1 (the tools and the processor test,
+// never the plugin) link AllocationGuard.cpp, which replaces every form of the
+// global operator new (plain, nothrow, over-aligned) and counts every
+// allocation made while a ScopedAllocationGuard is alive on that thread.
+//
+// On glibc it replaces malloc, calloc, realloc and the aligned variants too, so
+// juce::HeapBlock and AudioBuffer storage count as well. Elsewhere (macOS,
+// Windows, sanitizer builds) only operator new is seen.
+// Everywhere else the guard is an empty object.
+
+#if KLIP_DETECT_AUDIO_THREAD_ALLOCATIONS
+
+class ScopedAllocationGuard {
+public:
+    ScopedAllocationGuard();
+    ~ScopedAllocationGuard();
+
+    // Allocations seen inside any guard since the process started.
+    static int getViolationCount();
+
+private:
+    ScopedAllocationGuard(const ScopedAllocationGuard&) = delete;
+    ScopedAllocationGuard& operator=(const ScopedAllocationGuard&) = delete;
+};
+
+#else
+
+class ScopedAllocationGuard {
+public:
+    ScopedAllocationGuard() {}
+    static int getViolationCount() { return 0; }
+};
+
+#endif
@@ -0,0 +1,37 @@
+/*
+  ==============================================================================
+
+    BackgroundBuilder.cpp
+
+  ==============================================================================
+*/
+
+#include "BackgroundBuilder.h"
+
+BackgroundBuilder::BackgroundBuilder() : juce::Thread("Klip background builder") {
+    startThread(juce::Thread::Priority::background);
+}
+
+BackgroundBuilder::~BackgroundBuilder() {
+    stopThread(2000);
+}
+
+void BackgroundBuilder::add(Client* client) {
+    const juce::ScopedLock sl(lock);
+    clients.add(client);
+}
+
+void BackgroundBuilder::remove(Client* client) {
+    const juce::ScopedLock sl(lock);
+    clients.removeFirstMatchingValue(client);
+}
+
+void BackgroundBuilder::run() {
+    while (! threadShouldExit()) {
+        wait(20);
+
+        const juce::ScopedLock sl(lock);
+        for (auto* client : clients)
+            client->buildRequestedSubsystems();
+    }
+}
@@ -0,0 +1,43 @@
+/*
+  ==============================================================================
+
+    BackgroundBuilder.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+// One thread for every processor in the process that builds the subsystems an
+// instance only needs once a feature is switched on. The audio thread raises
+// a flag in its client; the thread calls buildRequestedSubsystems() on every
+// client in turn, and the client publishes what it built with an atomic.
+//
+// Polls rather than being signalled, like the flight recorder's writer:
+// notify() can lock and the requests come from the audio thread.
+class BackgroundBuilder : private juce::Thread {
+public:
+    class Client {
+    public:
+        virtual ~Client() = default;
+
+        // Builder thread. Cheap when nothing was requested.
+        virtual void buildRequestedSubsystems() = 0;
+    };
+
+    BackgroundBuilder();
+    ~BackgroundBuilder() override;
+
+    // Message thread. remove() waits for a build in progress on that client.
+    void add(Client* client);
+    void remove(Client* client);
+
+private:
+    void run() override;
+
+    juce::CriticalSection lock;
+    juce::Array<Client*> clients;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(BackgroundBuilder)
+};
@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    BlockDelayLine.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include "DspArena.h"
+
+// Whole-sample delay for up to maxChannels channels, used to line paths up
+// with a known latency. The ring buffers come from the instance arena and are
+// sized for the largest delay in allocateFrom(); setDelay() never allocates.
+class BlockDelayLine {
+public:
+    static constexpr int maxChannels = 2;
+
+    BlockDelayLine() = default;
+    ~BlockDelayLine() = default;
+
+    void allocateFrom(DspArena& arena, int maximumDelay) {
+        capacity = std::max(0, maximumDelay) + 1;
+        for (auto& ring : rings)
+            ring = arena.allocate<float>(static_cast<size_t>(capacity));
+
+        delay = std::min(delay, capacity - 1);
+        writeIndex = 0;
+    }
+
+    // Clears the ring when the delay changes, so old material can't jump out,
+    // unless the line keeps its history: then only the read position moves.
+    void setDelay(int newDelay) {
+        newDelay = std::clamp(newDelay, 0, capacity - 1);
+        if (newDelay != delay) {
+            delay = newDelay;
+            if (! historyKept)
+                reset();
+        }
+    }
+
+    // For paths that must not drop out when the delay changes: the ring is
+    // written even at zero delay, so it always holds the last
+    // getMaximumDelay() samples and a new delay reads them straight away.
+    void setKeepsHistory(bool shouldKeepHistory) { historyKept = shouldKeepHistory; }
+
+    int getDelay() const { return delay; }
+    int getMaximumDelay() const { return capacity - 1; }
+
+    void reset() {
+        for (auto* ring : rings)
+            if (ring != nullptr)
+                std::fill(ring, ring + capacity, 0.0f);
+
+        writeIndex = 0;
+    }
+
+    void process(float* const* channels, int numChannels, int numSamples) {
+        assert(numChannels <= maxChannels);
+        if ((delay == 0 && ! historyKept) || rings[0] == nullptr)
+            return;
+
+        int write = writeIndex;
+        for (int channel = 0; channel < std::min(numChannels, maxChannels); ++channel) {
+            float* ring = rings[channel];
+            float* data = channels[channel];
+            write = writeIndex;
+            int read = write - delay;
+            if (read < 0)
+                read += capacity;
+
+            for (int i = 0; i < numSamples; ++i) {
+                ring[write] = data[i];
+                data[i] = ring[read];
+                if (++write == capacity) write = 0;
+                if (++read == capacity) read = 0;
+            }
+        }
+
+        writeIndex = write;
+    }
+
+private:
+    float* rings[maxChannels] = {};
+    int capacity = 1;
+    int delay = 0;
+    int writeIndex = 0;
+    bool historyKept = false;
+};
@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    ClipKernels.cpp
+
+  ==============================================================================
+*/
+
+#include "ClipKernels.h"
+#include <cmath>
+#include <initializer_list>
+
+#if defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+ #include <intrin.h>
+#elif defined (__linux__) && defined (__arm__)
+ #include <sys/auxv.h>
+ #include <asm/hwcap.h>
+#endif
+
+namespace ClipKernels
+{
+    const LookupTables& getLookupTables()
+    {
+        static const LookupTables tables = [] {
+            LookupTables t;
+
+            for (int i = 0; i < LookupTables::size + 2; ++i) {
+                const float u = LookupTables::expRange * static_cast<float>(i) / LookupTables::size;
+                const float d = LookupTables::logRange * static_cast<float>(i) / LookupTables::size;
+                t.expDecay[i] = 1.0f - std::exp(-3.0f * u);
+                t.log1p[i] = std::log(1.0f + d);
+            }
+
+            return t;
+        }();
+
+        return tables;
+    }
+
+    // No JUCE here (the DSP library doesn't depend on it): the compiler builtins
+    // on GCC/Clang, CPUID plus XGETBV on MSVC. Both check that the OS saves the
+    // AVX/AVX-512 registers, not just that the CPU has them.
+   #if defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+    static bool cpuHasFeatures (int leaf, int subleaf, int reg, unsigned int mask)
+    {
+        int info[4] = {};
+        __cpuidex (info, leaf, subleaf);
+        return (static_cast<unsigned int> (info[reg]) & mask) == mask;
+    }
+
+    static bool osSavesState (unsigned long long mask)
+    {
+        return cpuHasFeatures (1, 0, 2, 1u << 27) && (_xgetbv (0) & mask) == mask; // OSXSAVE
+    }
+   #endif
+
+    static bool cpuSupports (Isa isa)
+    {
+        switch (isa)
+        {
+        case Isa::Baseline: return true;
+
+       #if (defined (__GNUC__) || defined (__clang__)) && (defined (__x86_64__) || defined (__i386__))
+        case Isa::AVX2:     return __builtin_cpu_supports ("avx2") && __builtin_cpu_supports ("fma");
+        case Isa::AVX512:   return __builtin_cpu_supports ("avx512f") && __builtin_cpu_supports ("avx512vl")
+                                && __builtin_cpu_supports ("avx512dq") && __builtin_cpu_supports ("avx512bw");
+       #elif defined (_MSC_VER) && (defined (_M_X64) || defined (_M_IX86))
+        case Isa::AVX2:     return osSavesState (0x6) && cpuHasFeatures (7, 0, 1, 1u << 5) && cpuHasFeatures (1, 0, 2, 1u << 12);
+        case Isa::AVX512:   return osSavesState (0xe6) && cpuHasFeatures (7, 0, 1, (1u << 16) | (1u << 17) | (1u << 30) | (1u << 31));
+       #endif
+
+       #if defined (__aarch64__) || defined (_M_ARM64) || defined (__ARM_NEON)
+        case Isa::NEON:     return true;
+       #elif defined (__linux__) && defined (__arm__)
+        case Isa::NEON:     return (getauxval (AT_HWCAP) & HWCAP_NEON) != 0;
+       #endif
+
+        default:            return false;
+        }
+    }
+
+    const Table* getForIsa (Isa isa)
+    {
+        if (! cpuSupports (isa))
+            return nullptr;
+
+        switch (isa)
+        {
+        case Isa::Baseline: return &sse2::getTable();
+       #if KLIP_KERNELS_AVX2
+        case Isa::AVX2:     return &avx2::getTable();
+       #endif
+       #if KLIP_KERNELS_AVX512
+        case Isa::AVX512:   return &avx512::getTable();
+       #endif
+       #if KLIP_KERNELS_NEON
+        case Isa::NEON:     return &neon::getTable();
+       #endif
+        default:            return nullptr;
+        }
+    }
+
+    static const Table& selectTable()
+    {
+        for (auto isa : { Isa::AVX512, Isa::AVX2, Isa::NEON })
+            if (auto* table = getForIsa (isa))
+                return *table;
+
+        return sse2::getTable();
+    }
+
+    const Table& get()
+    {
+        // Function-local static: selected on first use (plugin load) and thread-safe.
+        static const Table& selected = selectTable();
+        return selected;
+    }
+}
@@ -0,0 +1,181 @@
+/*
+  ==============================================================================
+
+    ClipKernels.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstdint>
+
+// Block kernels for the clip curves and the filters that run in front of them.
+// The same source (ClipKernelsImpl.h) is compiled once per instruction set and
+// the best table for the running CPU is picked the first time get() is called.
+// This header must stay free of JUCE so the ISA translation units only see
+// code that was compiled with their own flags.
+
+namespace ClipKernels
+{
+    // The transcendental parts of the Exponential and Asymmetric curves sampled on
+    // a uniform grid. Neither depends on the threshold, so one copy built on first
+    // use serves every instance (see getLookupTables()). Linear interpolation keeps
+    // the error below 7e-5 for 1 - exp(-3u) and 3.1e-5 for log(1 + d); inputs past
+    // the range read the last entry.
+    struct LookupTables
+    {
+        static constexpr int size = 1024;
+        static constexpr float expRange = 8.0f;  // 1 - exp(-3u), u in [0, 8]
+        static constexpr float logRange = 16.0f; // log(1 + d),   d in [0, 16]
+
+        // Two guard entries past `size` so interpolation never reads out of bounds.
+        float expDecay[size + 2];
+        float log1p[size + 2];
+    };
+
+    const LookupTables& getLookupTables();
+
+    // A user transfer curve as compiled by CustomCurve: numSegments cubics on a
+    // uniform grid over |x| / threshold in [0, inputRange], odd-symmetric. The
+    // scaled input is the segment index, so evaluating it is a clamp, one load of
+    // four coefficients and a Horner step. Entry numSegments is a constant guard
+    // that holds the end value for inputs past the range (and for NaN).
+    struct CurveSegments
+    {
+        static constexpr int numSegments = 128;
+        static constexpr float inputRange = 4.0f;
+
+        // c0 + u * (c1 + u * (c2 + u * c3)) with u in [0, 1) across the segment,
+        // in units of the threshold
+        float coefficients[numSegments + 1][4];
+    };
+
+    // Curve parameters shared by every kernel. kneeWidth (0..1, fraction of the
+    // threshold) only affects the polynomial soft-knee curves, segments only the
+    // custom curve (hard clip while it's null).
+    struct CurveShape
+    {
+        float threshold;
+        float kneeWidth;
+        const CurveSegments* segments = nullptr;
+    };
+
+    // The filter kernels run up to filterLanes channels side by side. Blocks are
+    // interleaved frame by frame (channel 0..3 of sample 0, then of sample 1, ...)
+    // so every step of the recurrence is one vector operation across channels.
+    // Each lane has its own coefficients; unused lanes just carry zeros.
+    static constexpr int filterLanes = 4;
+
+    // Topology-preserving (trapezoidal) one-pole, per lane with integrator state s:
+    //   v = (x - s) * g,  lp = v + s,  s = lp + v,  y = inputGain * x + lowPassGain * lp
+    // g = G / (1 + G) with G = tan (pi * fc / fs).
+    struct OnePoleCoefficients
+    {
+        float g[filterLanes];
+        float inputGain[filterLanes];
+        float lowPassGain[filterLanes];
+    };
+
+    // TPT state-variable biquad, per lane with states ic1, ic2:
+    //   v3 = x - ic2,  v1 = a1 * ic1 + a2 * v3,  v2 = ic2 + a2 * ic1 + a3 * v3
+    //   ic1 = 2 * v1 - ic1,  ic2 = 2 * v2 - ic2,  y = m0 * x + m1 * v1 + m2 * v2
+    struct SvfCoefficients
+    {
+        float a1[filterLanes], a2[filterLanes], a3[filterLanes];
+        float m0[filterLanes], m1[filterLanes], m2[filterLanes];
+    };
+
+    // Dual-envelope transient detector, per lane with a fast peak follower f and a
+    // slow follower s of f, sharing one release:
+    //   p = |x|,  f += (p - f) * (p > f ? fastAttack : release),  s += (f - s) * (f > s ? slowAttack : release)
+    //   y = clamp (sensitivity * (f - s) / f, 0, 1)
+    // s catches up with f on steady material (y near 0) and lags behind it on
+    // every attack; on a decay s is above f and y is 0.
+    struct TransientCoefficients
+    {
+        float fastAttack[filterLanes], slowAttack[filterLanes], release[filterLanes];
+        float sensitivity[filterLanes];
+    };
+
+    // Output quantiser with error-feedback noise shaping, per lane (channel):
+    //   v = x * scale - sum_k h[k] * e[n - 1 - k],  q = round (v + d),  e[n] = q - v
+    //   y = clamp (q, minimum, maximum) / scale
+    // d is TPDF dither in LSBs, so the noise spectrum is the TPDF floor shaped by
+    // 1 - H(z). x * scale is first limited to twice the output range (NaN to the
+    // top), which keeps the fed-back error within +-1.5 LSB.
+    static constexpr int maxNoiseShaperOrder = 9;
+
+    struct QuantiserCoefficients
+    {
+        int order;                      // taps in use, 0 is plain TPDF
+        float h[maxNoiseShaperOrder];
+        float scale, inverseScale;      // 2^(bits - 1) and 1 / scale
+        float minimum, maximum;         // output range in LSBs
+    };
+
+    // ditherNoise runs this many independent xorshift32 generators side by side,
+    // stream j producing samples j, j + ditherStreams, j + 2 * ditherStreams, ...
+    static constexpr int ditherStreams = 16;
+
+    enum class Isa
+    {
+        Baseline, // SSE2 on x86-64, plain C++ elsewhere
+        AVX2,
+        AVX512,
+        NEON
+    };
+
+    struct Table
+    {
+        const char* name;
+        Isa isa;
+
+        // Applies Clipping::ClipType `clipType` in place. Samples closer to zero than
+        // 1e-8 are flushed to zero, as Clipping::processSample does.
+        void (*clip) (float* data, int numSamples, int clipType, const CurveShape& shape);
+
+        // Same as clip, but Exponential and Asymmetric read exp/log from `tables`.
+        void (*clipLookup) (float* data, int numSamples, int clipType, const CurveShape& shape, const LookupTables& tables);
+
+        // dest[i] = source[i] + (dest[i] - source[i]) * min (1, startMix + (i + 1) * mixStep)
+        void (*crossfade) (float* dest, const float* source, int numSamples, float startMix, float mixStep);
+
+        // dest[i] = dest[i] + (source[i] - dest[i]) * weights[i]
+        void (*blend) (float* dest, const float* source, const float* weights, int numSamples);
+
+        // In place on `numFrames` interleaved frames of filterLanes samples.
+        // state holds filterLanes floats for onePole and 2 * filterLanes for svf.
+        void (*onePole) (float* frames, int numFrames, const OnePoleCoefficients& coefficients, float* state);
+        void (*svf) (float* frames, int numFrames, const SvfCoefficients& coefficients, float* state);
+
+        // In place on interleaved frames like the filters: samples in, transient
+        // weights (0..1) out. state holds 2 * filterLanes floats.
+        void (*transientWeights) (float* frames, int numFrames, const TransientCoefficients& coefficients, float* state);
+
+        // TPDF noise in LSBs (-1..1), the difference of two uniforms per sample.
+        // numSamples must be a multiple of ditherStreams; state holds one word per stream.
+        void (*ditherNoise) (float* noise, int numSamples, uint32_t* state);
+
+        // In place on interleaved frames like the filters, `noise` interleaved the
+        // same way. errors holds maxNoiseShaperOrder * filterLanes floats, newest first.
+        void (*quantise) (float* frames, const float* noise, int numFrames, const QuantiserCoefficients& coefficients, float* errors);
+    };
+
+    // Table selected for this CPU, chosen once per process.
+    const Table& get();
+
+    // Table for a specific instruction set, or nullptr if it was not compiled in
+    // or the CPU cannot run it. Used by the benchmark to compare variants.
+    const Table* getForIsa (Isa isa);
+
+    namespace sse2   { const Table& getTable(); }
+   #if KLIP_KERNELS_AVX2
+    namespace avx2   { const Table& getTable(); }
+   #endif
+   #if KLIP_KERNELS_AVX512
+    namespace avx512 { const Table& getTable(); }
+   #endif
+   #if KLIP_KERNELS_NEON
+    namespace neon   { const Table& getTable(); }
+   #endif
+}
@@ -0,0 +1,864 @@
+/*
+  ==============================================================================
+
+    ClipKernelsImpl.h
+
+  ==============================================================================
+*/
+
+// No include guard on purpose: every ClipKernels_<ISA>.cpp defines
+// KLIP_KERNEL_NAMESPACE, KLIP_KERNEL_NAME and KLIP_KERNEL_ISA and then includes
+// this file, so the loops below are compiled once per instruction set.
+//
+// Everything here lives in an anonymous namespace and avoids std::min/std::max,
+// std::exp and the other inline functions of the standard headers: unoptimised
+// builds emit those as weak symbols in every kernel translation unit, and if the
+// linker kept the AVX2-compiled copy the baseline path would fault on older CPUs.
+// The math goes through the internal kernelExp/kernelLog/... below instead.
+
+#include <cmath>
+#include <cstring>
+#include "ClipKernels.h"
+
+#if defined (__AVX2__)
+ #include <immintrin.h>
+#elif defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+ #include <arm_neon.h>
+#endif
+
+#if ! defined (KLIP_KERNEL_NAMESPACE) || ! defined (KLIP_KERNEL_NAME) || ! defined (KLIP_KERNEL_ISA)
+ #error "Define KLIP_KERNEL_NAMESPACE, KLIP_KERNEL_NAME and KLIP_KERNEL_ISA before including ClipKernelsImpl.h"
+#endif
+
+namespace ClipKernels
+{
+namespace KLIP_KERNEL_NAMESPACE
+{
+namespace
+{
+    // Internal linkage, so each ISA keeps its own. The builtins compile to an
+    // instruction or a call to the C library, never to a shared inline function.
+   #if defined (__GNUC__) || defined (__clang__)
+    inline float kernelExp (float x)  { return __builtin_expf (x); }
+    inline float kernelLog (float x)  { return __builtin_logf (x); }
+    inline float kernelAbs (float x)  { return __builtin_fabsf (x); }
+    inline float kernelSqrt (float x) { return __builtin_sqrtf (x); }
+   #else
+    inline float kernelExp (float x)  { return ::expf (x); }
+    inline float kernelLog (float x)  { return ::logf (x); }
+    inline float kernelAbs (float x)  { return ::fabsf (x); }
+    inline float kernelSqrt (float x) { return ::sqrtf (x); }
+   #endif
+
+    inline bool kernelSignBit (float x)
+    {
+        uint32_t bits;
+        std::memcpy (&bits, &x, sizeof (bits));
+        return (bits >> 31) != 0;
+    }
+
+    // The curves are written as selects rather than if/else so the compiler can
+    // if-convert and vectorise them; they match Clipping::processClip.
+    struct SoftCurve
+    {
+        float t;
+
+        // t * (1.5u - 0.5u^3) with u = x / t, saturating at t beyond |u| = 1
+        inline float apply (float x) const
+        {
+            const float normalised = x / t;
+            const float u = normalised > 1.0f ? 1.0f : (normalised < -1.0f ? -1.0f : normalised);
+            return t * u * (1.5f - 0.5f * u * u);
+        }
+    };
+
+    struct HardCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            return x > t ? t : (x < -t ? -t : x);
+        }
+    };
+
+    struct LinearCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float above = t + 0.5f * (x - t);
+            const float below = -t + 0.5f * (x + t);
+            return x > t ? above : (x < -t ? below : x);
+        }
+    };
+
+    struct ExponentialCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float above = t + (1.0f - kernelExp (-((x - t) / t) * 3.0f)) * (t / 4.0f);
+            const float below = -t - (1.0f - kernelExp (((x + t) / t) * 3.0f)) * (t / 4.0f);
+            return x > t ? above : (x < -t ? below : x);
+        }
+    };
+
+    struct AsymmetricCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            // Clamp the log arguments so the unused branch never produces NaN.
+            const float overshoot = x - t > 0.0f ? x - t : 0.0f;
+            const float undershoot = -x - t > 0.0f ? -x - t : 0.0f;
+            const float above = t + kernelLog (1.0f + overshoot) / 0.69314718f;
+            const float below = -t - kernelLog (1.0f + undershoot) / 1.09861229f;
+            return x > t ? above : (x < -t ? below : x);
+        }
+    };
+
+    //==============================================================================
+    // Approximations for the saturating curves. All of them use only +, *, /,
+    // sqrt, compares and integer conversion so every ISA can vectorise them.
+    // Errors are absolute, measured against the double-precision function over
+    // |x / threshold| <= 20 and scaled by the threshold.
+
+    // Nearest integer of x as float, for |x| < 2^31.
+    inline float roundToWhole (float x)
+    {
+        return static_cast<float> (static_cast<int> (x + (x >= 0.0f ? 0.5f : -0.5f)));
+    }
+
+    // 2^x: exponent from the integer part, degree-6 polynomial on [-0.5, 0.5].
+    // Relative error < 9e-7.
+    inline float exp2Approx (float x)
+    {
+        x = x > 126.0f ? 126.0f : (x < -126.0f ? -126.0f : x);
+        const float whole = roundToWhole (x);
+        const float f = x - whole;
+        const float p = 1.0f + f * (0.69314718f + f * (0.24022651f + f * (0.05550411f
+                          + f * (0.00961813f + f * (0.00133336f + f * 0.00015404f)))));
+
+        const int bits = (static_cast<int> (whole) + 127) << 23;
+        float scale;
+        std::memcpy (&scale, &bits, sizeof (scale));
+        return p * scale;
+    }
+
+    // t * tanh (x / t) through tanh(u) = 1 - 2 / (e^2u + 1). Max error 2.1e-7 * t.
+    struct TanhCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float e = exp2Approx (2.88539008f * (x / t)); // 2 / ln(2)
+            return t * (1.0f - 2.0f / (e + 1.0f));
+        }
+    };
+
+    // t * 2/pi * atan (pi/2 * x / t): unity slope at zero, ceiling at t. atan uses
+    // atan(u) = pi/2 - atan(1/u) for |u| > 1 and a degree-11 odd minimax
+    // polynomial on [0, 1]. Max error 1.2e-6 * t.
+    struct ArctanCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float u = 1.57079633f * x / t;
+            const float a = kernelAbs (u);
+            const float z = a > 1.0f ? 1.0f / a : a;
+            const float z2 = z * z;
+            const float p = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f
+                              + z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+            const float r = (a > 1.0f ? 1.57079633f - p : p) * (t * 0.63661977f);
+            return u < 0.0f ? -r : r;
+        }
+    };
+
+    // x / sqrt (1 + (x/t)^2). Exact up to float rounding (hardware sqrt).
+    struct AlgebraicCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float u = x / t;
+            return x / kernelSqrt (1.0f + u * u);
+        }
+    };
+
+    // Linear up to a = t (1 - knee), then a polynomial knee that reaches t with zero
+    // slope and stays there. Cubic: y = a + w (d - d^3/3), C1 at both ends.
+    // Quintic: y = a + w (d - 2d^3/3 + d^5/5), C2 at both ends. d = (|x| - a) / w,
+    // w chosen so the knee ends exactly at t. Exact polynomials.
+    struct CubicKneeCurve
+    {
+        float kneeStart, width;
+
+        static CubicKneeCurve make (const CurveShape& shape)
+        {
+            const float knee = shape.kneeWidth < 0.01f ? 0.01f : (shape.kneeWidth > 1.0f ? 1.0f : shape.kneeWidth);
+            return { shape.threshold * (1.0f - knee), 1.5f * shape.threshold * knee };
+        }
+
+        inline float apply (float x) const
+        {
+            const float a = kernelAbs (x);
+            const float rawD = (a - kneeStart) / width;
+            const float d = rawD > 1.0f ? 1.0f : rawD;
+            const float y = a > kneeStart ? kneeStart + width * (d - d * d * d * (1.0f / 3.0f)) : a;
+            return x < 0.0f ? -y : y;
+        }
+    };
+
+    struct QuinticKneeCurve
+    {
+        float kneeStart, width;
+
+        static QuinticKneeCurve make (const CurveShape& shape)
+        {
+            const float knee = shape.kneeWidth < 0.01f ? 0.01f : (shape.kneeWidth > 1.0f ? 1.0f : shape.kneeWidth);
+            return { shape.threshold * (1.0f - knee), 1.875f * shape.threshold * knee };
+        }
+
+        inline float apply (float x) const
+        {
+            const float a = kernelAbs (x);
+            const float rawD = (a - kneeStart) / width;
+            const float d = rawD > 1.0f ? 1.0f : rawD;
+            const float d2 = d * d;
+            const float y = a > kneeStart ? kneeStart + width * d * (1.0f + d2 * (-2.0f / 3.0f + d2 * 0.2f)) : a;
+            return x < 0.0f ? -y : y;
+        }
+    };
+
+    // t * sin (x / t): unity slope at zero, peaks at t and folds back beyond it.
+    // The phase is wrapped to a quarter period, then a degree-11 Taylor polynomial
+    // on [-pi/2, pi/2]. Max error 1.5e-6 * t.
+    struct SineFoldCurve
+    {
+        float t;
+
+        inline float apply (float x) const
+        {
+            const float cycles = x / (6.28318531f * t);
+            float p = cycles - roundToWhole (cycles);           // [-0.5, 0.5]
+            p = p > 0.25f ? 0.5f - p : (p < -0.25f ? -0.5f - p : p); // [-0.25, 0.25]
+
+            const float r = 6.28318531f * p;
+            const float r2 = r * r;
+            return t * r * (1.0f + r2 * (-1.6666667e-1f + r2 * (8.3333333e-3f + r2 * (-1.9841270e-4f
+                             + r2 * (2.7557319e-6f + r2 * -2.5052108e-8f)))));
+        }
+    };
+
+    struct SegmentCurve
+    {
+        float t;
+        float positionScale;
+        const float (*coefficients)[4];
+
+        static SegmentCurve make (const CurveShape& shape)
+        {
+            const float scale = static_cast<float> (CurveSegments::numSegments) / CurveSegments::inputRange;
+            return { shape.threshold, scale / shape.threshold, shape.segments->coefficients };
+        }
+
+        inline float apply (float x) const
+        {
+            const float maxPosition = static_cast<float> (CurveSegments::numSegments);
+            const float position = kernelAbs (x) * positionScale;
+            const float clamped = position < maxPosition ? position : maxPosition;
+            const int index = static_cast<int> (clamped);
+            const float u = clamped - static_cast<float> (index);
+            const float* c = coefficients[index];
+            const float y = t * (c[0] + u * (c[1] + u * (c[2] + u * c[3])));
+            return x < 0.0f ? -y : y;
+        }
+    };
+
+    //==============================================================================
+    // Linear interpolation in a LookupTables array; `position` is in table steps.
+    inline float interpolate (const float* table, float position)
+    {
+        const float maxPosition = static_cast<float> (LookupTables::size);
+        const float clamped = position < maxPosition ? position : maxPosition;
+        const int index = static_cast<int> (clamped);
+        const float fraction = clamped - static_cast<float> (index);
+        return table[index] + fraction * (table[index + 1] - table[index]);
+    }
+
+    struct ExponentialLookupCurve
+    {
+        float t;
+        const float* table;
+
+        inline float apply (float x) const
+        {
+            const float scale = static_cast<float> (LookupTables::size) / LookupTables::expRange;
+            const float over = (x - t) / t;
+            const float under = (-x - t) / t;
+            const float above = t + interpolate (table, (over > 0.0f ? over : 0.0f) * scale) * (t / 4.0f);
+            const float below = -t - interpolate (table, (under > 0.0f ? under : 0.0f) * scale) * (t / 4.0f);
+            return x > t ? above : (x < -t ? below : x);
+        }
+    };
+
+    struct AsymmetricLookupCurve
+    {
+        float t;
+        const float* table;
+
+        inline float apply (float x) const
+        {
+            const float scale = static_cast<float> (LookupTables::size) / LookupTables::logRange;
+            const float overshoot = x - t > 0.0f ? x - t : 0.0f;
+            const float undershoot = -x - t > 0.0f ? -x - t : 0.0f;
+            const float above = t + interpolate (table, overshoot * scale) / 0.69314718f;
+            const float below = -t - interpolate (table, undershoot * scale) / 1.09861229f;
+            return x > t ? above : (x < -t ? below : x);
+        }
+    };
+
+    //==============================================================================
+    template <typename Curve>
+    void applyCurve (float* data, int numSamples, const Curve curve)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float x = data[i];
+            const float y = curve.apply (x);
+            data[i] = kernelAbs (x) < 1.0e-8f ? 0.0f : y;
+        }
+    }
+
+    void applySegmentCurve (float* data, int numSamples, const SegmentCurve curve);
+
+    void clip (float* data, int numSamples, int clipType, const CurveShape& shape)
+    {
+        const float t = shape.threshold;
+
+        switch (clipType)
+        {
+        case 0:  applyCurve (data, numSamples, SoftCurve { t }); break;
+        case 1:  applyCurve (data, numSamples, HardCurve { t }); break;
+        case 2:  applyCurve (data, numSamples, LinearCurve { t }); break;
+        case 3:  applyCurve (data, numSamples, ExponentialCurve { t }); break;
+        case 4:  applyCurve (data, numSamples, AsymmetricCurve { t }); break;
+        case 6:  applyCurve (data, numSamples, TanhCurve { t }); break;
+        case 7:  applyCurve (data, numSamples, ArctanCurve { t }); break;
+        case 8:  applyCurve (data, numSamples, AlgebraicCurve { t }); break;
+        case 9:  applyCurve (data, numSamples, CubicKneeCurve::make (shape)); break;
+        case 10: applyCurve (data, numSamples, QuinticKneeCurve::make (shape)); break;
+        case 11: applyCurve (data, numSamples, SineFoldCurve { t }); break;
+        case 12:
+            if (shape.segments != nullptr)
+                applySegmentCurve (data, numSamples, SegmentCurve::make (shape));
+            else
+                applyCurve (data, numSamples, HardCurve { t });
+            break;
+
+        default:
+            for (int i = 0; i < numSamples; ++i)
+                data[i] = kernelAbs (data[i]) < 1.0e-8f ? 0.0f : data[i];
+            break;
+        }
+    }
+
+    void clipLookup (float* data, int numSamples, int clipType, const CurveShape& shape, const LookupTables& tables)
+    {
+        switch (clipType)
+        {
+        case 3:  applyCurve (data, numSamples, ExponentialLookupCurve { shape.threshold, tables.expDecay }); break;
+        case 4:  applyCurve (data, numSamples, AsymmetricLookupCurve { shape.threshold, tables.log1p }); break;
+        default: clip (data, numSamples, clipType, shape); break;
+        }
+    }
+
+    void crossfade (float* dest, const float* source, int numSamples, float startMix, float mixStep)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const float ramp = startMix + static_cast<float> (i + 1) * mixStep;
+            const float mix = ramp < 1.0f ? ramp : 1.0f;
+            dest[i] = source[i] + (dest[i] - source[i]) * mix;
+        }
+    }
+
+    void blend (float* dest, const float* source, const float* weights, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i)
+            dest[i] += (source[i] - dest[i]) * weights[i];
+    }
+
+    // The filter recurrences carry their state from one frame to the next, which
+    // the auto-vectoriser won't pack across lanes, so they use one 128-bit vector
+    // per frame explicitly (filterLanes == 4). In the AVX2/AVX-512 units the same
+    // intrinsics come out VEX/EVEX encoded.
+   #if defined (__SSE2__) || defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2)
+    struct LaneVector
+    {
+        __m128 v;
+
+        static inline LaneVector load (const float* p)         { return { _mm_loadu_ps (p) }; }
+        inline void store (float* p) const                     { _mm_storeu_ps (p, v); }
+        inline LaneVector operator+ (LaneVector other) const   { return { _mm_add_ps (v, other.v) }; }
+        inline LaneVector operator- (LaneVector other) const   { return { _mm_sub_ps (v, other.v) }; }
+        inline LaneVector operator* (LaneVector other) const   { return { _mm_mul_ps (v, other.v) }; }
+        inline LaneVector operator/ (LaneVector other) const   { return { _mm_div_ps (v, other.v) }; }
+
+        static inline LaneVector broadcast (float x)           { return { _mm_set1_ps (x) }; }
+        // Round to nearest even (MXCSR default), |v| < 2^31
+        inline LaneVector round() const                        { return { _mm_cvtepi32_ps (_mm_cvtps_epi32 (v)) }; }
+        // NaN lanes come out as `high`
+        inline LaneVector clamp (LaneVector low, LaneVector high) const { return { _mm_max_ps (_mm_min_ps (v, high.v), low.v) }; }
+
+        inline LaneVector abs() const                          { return { _mm_andnot_ps (_mm_set1_ps (-0.0f), v) }; }
+        // Negated in the lanes where `other` is negative (copysign for v >= 0)
+        inline LaneVector flipSign (LaneVector other) const    { return { _mm_xor_ps (v, _mm_and_ps (other.v, _mm_set1_ps (-0.0f))) }; }
+        inline LaneVector zeroWhereBelow (LaneVector test, float limit) const
+        {
+            return { _mm_andnot_ps (_mm_cmplt_ps (test.v, _mm_set1_ps (limit)), v) };
+        }
+        // This vector in the lanes where test > limit, `otherwise` in the rest
+        inline LaneVector whereGreater (LaneVector test, LaneVector limit, LaneVector otherwise) const
+        {
+            const __m128 mask = _mm_cmpgt_ps (test.v, limit.v);
+            return { _mm_or_ps (_mm_and_ps (mask, v), _mm_andnot_ps (mask, otherwise.v)) };
+        }
+
+        // Reads row floor (v) of `rows` for every lane (v >= 0) and transposes, so
+        // columns[k] holds entry k of each lane's row. Returns v - floor (v).
+        inline LaneVector lookupRows (const float (*rows)[4], LaneVector* columns) const
+        {
+            const __m128i index = _mm_cvttps_epi32 (v);
+            __m128 r0 = _mm_loadu_ps (rows[_mm_cvtsi128_si32 (index)]);
+            __m128 r1 = _mm_loadu_ps (rows[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (index, 1))]);
+            __m128 r2 = _mm_loadu_ps (rows[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (index, 2))]);
+            __m128 r3 = _mm_loadu_ps (rows[_mm_cvtsi128_si32 (_mm_shuffle_epi32 (index, 3))]);
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+            columns[0] = { r0 };
+            columns[1] = { r1 };
+            columns[2] = { r2 };
+            columns[3] = { r3 };
+            return { _mm_sub_ps (v, _mm_cvtepi32_ps (index)) };
+        }
+    };
+   #elif defined (__ARM_NEON) || defined (__ARM_NEON__)
+    struct LaneVector
+    {
+        float32x4_t v;
+
+        static inline LaneVector load (const float* p)         { return { vld1q_f32 (p) }; }
+        inline void store (float* p) const                     { vst1q_f32 (p, v); }
+        inline LaneVector operator+ (LaneVector other) const   { return { vaddq_f32 (v, other.v) }; }
+        inline LaneVector operator- (LaneVector other) const   { return { vsubq_f32 (v, other.v) }; }
+        inline LaneVector operator* (LaneVector other) const   { return { vmulq_f32 (v, other.v) }; }
+
+        static inline LaneVector broadcast (float x)           { return { vdupq_n_f32 (x) }; }
+       #if defined (__aarch64__) || defined (_M_ARM64)
+        inline LaneVector operator/ (LaneVector other) const   { return { vdivq_f32 (v, other.v) }; }
+        inline LaneVector round() const                        { return { vrndnq_f32 (v) }; }
+       #else
+        inline LaneVector operator/ (LaneVector other) const
+        {
+            // No divide on ARMv7: reciprocal estimate and two Newton-Raphson steps
+            float32x4_t r = vrecpeq_f32 (other.v);
+            r = vmulq_f32 (vrecpsq_f32 (other.v, r), r);
+            r = vmulq_f32 (vrecpsq_f32 (other.v, r), r);
+            return { vmulq_f32 (v, r) };
+        }
+        inline LaneVector round() const
+        {
+            // vcvtq truncates: add 0.5 with the sign of v first (ties away from zero)
+            const float32x4_t half = vbslq_f32 (vdupq_n_u32 (0x80000000u), v, vdupq_n_f32 (0.5f));
+            return { vcvtq_f32_s32 (vcvtq_s32_f32 (vaddq_f32 (v, half))) };
+        }
+       #endif
+        // NaN lanes come out as `high`
+        inline LaneVector clamp (LaneVector low, LaneVector high) const
+        {
+            const uint32x4_t ordered = vceqq_f32 (v, v);
+            return { vmaxq_f32 (vminq_f32 (vbslq_f32 (ordered, v, high.v), high.v), low.v) };
+        }
+
+        inline LaneVector abs() const                          { return { vabsq_f32 (v) }; }
+        inline LaneVector flipSign (LaneVector other) const
+        {
+            const uint32x4_t sign = vandq_u32 (vreinterpretq_u32_f32 (other.v), vdupq_n_u32 (0x80000000u));
+            return { vreinterpretq_f32_u32 (veorq_u32 (vreinterpretq_u32_f32 (v), sign)) };
+        }
+        inline LaneVector zeroWhereBelow (LaneVector test, float limit) const
+        {
+            return { vreinterpretq_f32_u32 (vbicq_u32 (vreinterpretq_u32_f32 (v), vcltq_f32 (test.v, vdupq_n_f32 (limit)))) };
+        }
+        inline LaneVector whereGreater (LaneVector test, LaneVector limit, LaneVector otherwise) const
+        {
+            return { vbslq_f32 (vcgtq_f32 (test.v, limit.v), v, otherwise.v) };
+        }
+
+        inline LaneVector lookupRows (const float (*rows)[4], LaneVector* columns) const
+        {
+            const int32x4_t index = vcvtq_s32_f32 (v);
+            const float32x4_t r0 = vld1q_f32 (rows[vgetq_lane_s32 (index, 0)]);
+            const float32x4_t r1 = vld1q_f32 (rows[vgetq_lane_s32 (index, 1)]);
+            const float32x4_t r2 = vld1q_f32 (rows[vgetq_lane_s32 (index, 2)]);
+            const float32x4_t r3 = vld1q_f32 (rows[vgetq_lane_s32 (index, 3)]);
+
+            // vtrnq pairs up entries 0/2 and 1/3 of two rows; the halves then combine
+            const float32x4x2_t low = vtrnq_f32 (r0, r1);
+            const float32x4x2_t high = vtrnq_f32 (r2, r3);
+            columns[0] = { vcombine_f32 (vget_low_f32 (low.val[0]), vget_low_f32 (high.val[0])) };
+            columns[1] = { vcombine_f32 (vget_low_f32 (low.val[1]), vget_low_f32 (high.val[1])) };
+            columns[2] = { vcombine_f32 (vget_high_f32 (low.val[0]), vget_high_f32 (high.val[0])) };
+            columns[3] = { vcombine_f32 (vget_high_f32 (low.val[1]), vget_high_f32 (high.val[1])) };
+            return { vsubq_f32 (v, vcvtq_f32_s32 (index)) };
+        }
+    };
+   #else
+    struct LaneVector
+    {
+        float v[filterLanes];
+
+        static inline LaneVector load (const float* p)
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = p[lane];
+            return result;
+        }
+
+        inline void store (float* p) const
+        {
+            for (int lane = 0; lane < filterLanes; ++lane)
+                p[lane] = v[lane];
+        }
+
+        inline LaneVector operator+ (LaneVector other) const { for (int lane = 0; lane < filterLanes; ++lane) other.v[lane] = v[lane] + other.v[lane]; return other; }
+        inline LaneVector operator- (LaneVector other) const { for (int lane = 0; lane < filterLanes; ++lane) other.v[lane] = v[lane] - other.v[lane]; return other; }
+        inline LaneVector operator* (LaneVector other) const { for (int lane = 0; lane < filterLanes; ++lane) other.v[lane] = v[lane] * other.v[lane]; return other; }
+        inline LaneVector operator/ (LaneVector other) const { for (int lane = 0; lane < filterLanes; ++lane) other.v[lane] = v[lane] / other.v[lane]; return other; }
+
+        static inline LaneVector broadcast (float x)
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = x;
+            return result;
+        }
+
+        inline LaneVector round() const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = roundToWhole (v[lane]);
+            return result;
+        }
+
+        // NaN lanes come out as `high`
+        inline LaneVector clamp (LaneVector low, LaneVector high) const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = v[lane] >= low.v[lane] ? (v[lane] <= high.v[lane] ? v[lane] : high.v[lane])
+                                                        : (v[lane] < low.v[lane] ? low.v[lane] : high.v[lane]);
+            return result;
+        }
+
+        inline LaneVector abs() const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = kernelAbs (v[lane]);
+            return result;
+        }
+
+        inline LaneVector flipSign (LaneVector other) const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = kernelSignBit (other.v[lane]) ? -v[lane] : v[lane];
+            return result;
+        }
+
+        inline LaneVector zeroWhereBelow (LaneVector test, float limit) const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = test.v[lane] < limit ? 0.0f : v[lane];
+            return result;
+        }
+
+        inline LaneVector whereGreater (LaneVector test, LaneVector limit, LaneVector otherwise) const
+        {
+            LaneVector result;
+            for (int lane = 0; lane < filterLanes; ++lane)
+                result.v[lane] = test.v[lane] > limit.v[lane] ? v[lane] : otherwise.v[lane];
+            return result;
+        }
+
+        inline LaneVector lookupRows (const float (*rows)[4], LaneVector* columns) const
+        {
+            LaneVector fraction;
+            for (int lane = 0; lane < filterLanes; ++lane)
+            {
+                const int index = static_cast<int> (v[lane]);
+                for (int k = 0; k < 4; ++k)
+                    columns[k].v[lane] = rows[index][k];
+                fraction.v[lane] = v[lane] - static_cast<float> (index);
+            }
+            return fraction;
+        }
+    };
+   #endif
+
+    static_assert (filterLanes == 4, "LaneVector holds four floats");
+
+    // Custom curve four samples at a time: the segment rows are loaded per lane and
+    // transposed, then Horner runs across the lanes. The auto-vectoriser would
+    // need gathers for this, which SSE2 and NEON don't have.
+    void applySegmentCurve (float* data, int numSamples, const SegmentCurve curve)
+    {
+        const auto t = LaneVector::broadcast (curve.t);
+        const auto positionScale = LaneVector::broadcast (curve.positionScale);
+        const auto zero = LaneVector::broadcast (0.0f);
+        const auto maxPosition = LaneVector::broadcast (static_cast<float> (CurveSegments::numSegments));
+
+        int i = 0;
+
+       #if defined (__AVX2__)
+        // Eight at a time: rows for samples 0-3 fill the low 128-bit half, 4-7 the
+        // high half, and the transpose works within each half.
+        const __m256 signMask = _mm256_set1_ps (-0.0f);
+        const __m256 t8 = _mm256_set1_ps (curve.t);
+        const __m256 positionScale8 = _mm256_set1_ps (curve.positionScale);
+        const __m256 maxPosition8 = _mm256_set1_ps (static_cast<float> (CurveSegments::numSegments));
+
+        for (; i + 8 <= numSamples; i += 8)
+        {
+            const __m256 x = _mm256_loadu_ps (data + i);
+            const __m256 magnitude = _mm256_andnot_ps (signMask, x);
+            const __m256 position = _mm256_max_ps (_mm256_min_ps (_mm256_mul_ps (magnitude, positionScale8), maxPosition8), _mm256_setzero_ps());
+            const __m256i index = _mm256_cvttps_epi32 (position);
+
+            alignas (32) int32_t lanes[8];
+            _mm256_store_si256 (reinterpret_cast<__m256i*> (lanes), index);
+
+            __m256 r[4];
+            for (int k = 0; k < 4; ++k)
+                r[k] = _mm256_insertf128_ps (_mm256_castps128_ps256 (_mm_loadu_ps (curve.coefficients[lanes[k]])),
+                                             _mm_loadu_ps (curve.coefficients[lanes[k + 4]]), 1);
+
+            const __m256 t0 = _mm256_unpacklo_ps (r[0], r[1]);
+            const __m256 t1 = _mm256_unpackhi_ps (r[0], r[1]);
+            const __m256 t2 = _mm256_unpacklo_ps (r[2], r[3]);
+            const __m256 t3 = _mm256_unpackhi_ps (r[2], r[3]);
+            const __m256 c0 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (1, 0, 1, 0));
+            const __m256 c1 = _mm256_shuffle_ps (t0, t2, _MM_SHUFFLE (3, 2, 3, 2));
+            const __m256 c2 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (1, 0, 1, 0));
+            const __m256 c3 = _mm256_shuffle_ps (t1, t3, _MM_SHUFFLE (3, 2, 3, 2));
+
+            const __m256 u = _mm256_sub_ps (position, _mm256_cvtepi32_ps (index));
+            __m256 y = _mm256_add_ps (c2, _mm256_mul_ps (u, c3));
+            y = _mm256_add_ps (c1, _mm256_mul_ps (u, y));
+            y = _mm256_add_ps (c0, _mm256_mul_ps (u, y));
+            y = _mm256_xor_ps (_mm256_mul_ps (t8, y), _mm256_and_ps (x, signMask));
+            y = _mm256_andnot_ps (_mm256_cmp_ps (magnitude, _mm256_set1_ps (1.0e-8f), _CMP_LT_OQ), y);
+            _mm256_storeu_ps (data + i, y);
+        }
+       #endif
+
+        for (; i + filterLanes <= numSamples; i += filterLanes)
+        {
+            const auto x = LaneVector::load (data + i);
+            const auto magnitude = x.abs();
+            const auto position = (magnitude * positionScale).clamp (zero, maxPosition);
+
+            LaneVector c[4];
+            const auto u = position.lookupRows (curve.coefficients, c);
+            const auto y = t * (c[0] + u * (c[1] + u * (c[2] + u * c[3])));
+            y.flipSign (x).zeroWhereBelow (magnitude, 1.0e-8f).store (data + i);
+        }
+
+        applyCurve (data + i, numSamples - i, curve);
+    }
+
+    void onePole (float* frames, int numFrames, const OnePoleCoefficients& c, float* state)
+    {
+        const auto g = LaneVector::load (c.g);
+        const auto inputGain = LaneVector::load (c.inputGain);
+        const auto lowPassGain = LaneVector::load (c.lowPassGain);
+        auto s = LaneVector::load (state);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float* frame = frames + i * filterLanes;
+            const auto x = LaneVector::load (frame);
+            const auto v = (x - s) * g;
+            const auto lp = v + s;
+            s = lp + v;
+            (inputGain * x + lowPassGain * lp).store (frame);
+        }
+
+        s.store (state);
+    }
+
+    void svf (float* frames, int numFrames, const SvfCoefficients& c, float* state)
+    {
+        const auto a1 = LaneVector::load (c.a1);
+        const auto a2 = LaneVector::load (c.a2);
+        const auto a3 = LaneVector::load (c.a3);
+        const auto m0 = LaneVector::load (c.m0);
+        const auto m1 = LaneVector::load (c.m1);
+        const auto m2 = LaneVector::load (c.m2);
+        auto ic1 = LaneVector::load (state);
+        auto ic2 = LaneVector::load (state + filterLanes);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float* frame = frames + i * filterLanes;
+            const auto x = LaneVector::load (frame);
+            const auto v3 = x - ic2;
+            const auto v1 = a1 * ic1 + a2 * v3;
+            const auto v2 = ic2 + a2 * ic1 + a3 * v3;
+            ic1 = v1 + v1 - ic1;
+            ic2 = v2 + v2 - ic2;
+            (m0 * x + m1 * v1 + m2 * v2).store (frame);
+        }
+
+        ic1.store (state);
+        ic2.store (state + filterLanes);
+    }
+
+    void transientWeights (float* frames, int numFrames, const TransientCoefficients& c, float* state)
+    {
+        const auto fastAttack = LaneVector::load (c.fastAttack);
+        const auto slowAttack = LaneVector::load (c.slowAttack);
+        const auto release = LaneVector::load (c.release);
+        const auto sensitivity = LaneVector::load (c.sensitivity);
+        const auto zero = LaneVector::broadcast (0.0f);
+        const auto one = LaneVector::broadcast (1.0f);
+        const auto tiny = LaneVector::broadcast (1.0e-12f); // silent lanes read 0, not 0 / 0
+        auto fast = LaneVector::load (state);
+        auto slow = LaneVector::load (state + filterLanes);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float* frame = frames + i * filterLanes;
+            const auto peak = LaneVector::load (frame).abs();
+            fast = fast + (peak - fast) * fastAttack.whereGreater (peak, fast, release);
+            slow = slow + (fast - slow) * slowAttack.whereGreater (fast, slow, release);
+            (sensitivity * (fast - slow) / (fast + tiny)).clamp (zero, one).store (frame);
+        }
+
+        fast.store (state);
+        slow.store (state + filterLanes);
+    }
+
+    // Plain loop over the streams so the compiler runs them as integer vectors.
+    // The top 24 bits of each draw go through int32 because SSE2 only converts
+    // signed integers.
+    void ditherNoise (float* noise, int numSamples, uint32_t* state)
+    {
+        constexpr float toUnit = 1.0f / 16777216.0f;
+
+        for (int start = 0; start < numSamples; start += ditherStreams)
+        {
+            float* out = noise + start;
+
+            for (int j = 0; j < ditherStreams; ++j)
+            {
+                uint32_t s = state[j];
+                s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+                const uint32_t first = s;
+                s ^= s << 13; s ^= s >> 17; s ^= s << 5;
+                state[j] = s;
+
+                out[j] = static_cast<float> (static_cast<int32_t> (first >> 8)) * toUnit
+                       - static_cast<float> (static_cast<int32_t> (s >> 8)) * toUnit;
+            }
+        }
+    }
+
+    // The error history lives in registers; Order is fixed per instantiation so
+    // the tap loops unroll and unused taps cost nothing.
+    template <int Order>
+    void quantiseWithOrder (float* frames, const float* noise, int numFrames, const QuantiserCoefficients& c, float* errors)
+    {
+        LaneVector h[Order > 0 ? Order : 1];
+        LaneVector e[Order > 0 ? Order : 1];
+        for (int k = 0; k < Order; ++k)
+        {
+            h[k] = LaneVector::broadcast (c.h[k]);
+            e[k] = LaneVector::load (errors + k * filterLanes);
+        }
+
+        const auto scale = LaneVector::broadcast (c.scale);
+        const auto inverseScale = LaneVector::broadcast (c.inverseScale);
+        const auto minimum = LaneVector::broadcast (c.minimum);
+        const auto maximum = LaneVector::broadcast (c.maximum);
+        const auto inputLow = LaneVector::broadcast (2.0f * c.minimum);
+        const auto inputHigh = LaneVector::broadcast (2.0f * c.maximum);
+
+        for (int i = 0; i < numFrames; ++i)
+        {
+            float* frame = frames + i * filterLanes;
+
+            // Only h[0] * e[0] depends on the previous frame; everything else,
+            // dither included, is summed first so the loop-carried chain stays short.
+            // Limiting the input (NaN included) keeps q - v within +-1.5 LSB.
+            auto older = (LaneVector::load (frame) * scale).clamp (inputLow, inputHigh);
+            for (int k = 1; k < Order; ++k)
+                older = older - h[k] * e[k];
+
+            const auto dithered = older + LaneVector::load (noise + i * filterLanes);
+            const auto q = Order > 0 ? (dithered - h[0] * e[0]).round() : dithered.round();
+            if (Order > 0)
+            {
+                const auto v = older - h[0] * e[0];
+                for (int k = Order - 1; k > 0; --k)
+                    e[k] = e[k - 1];
+                e[0] = q - v;
+            }
+
+            (q.clamp (minimum, maximum) * inverseScale).store (frame);
+        }
+
+        for (int k = 0; k < Order; ++k)
+            e[k].store (errors + k * filterLanes);
+    }
+
+    void quantise (float* frames, const float* noise, int numFrames, const QuantiserCoefficients& c, float* errors)
+    {
+        switch (c.order)
+        {
+        case 1:  quantiseWithOrder<1> (frames, noise, numFrames, c, errors); break;
+        case 2:  quantiseWithOrder<2> (frames, noise, numFrames, c, errors); break;
+        case 3:  quantiseWithOrder<3> (frames, noise, numFrames, c, errors); break;
+        case 4:  quantiseWithOrder<4> (frames, noise, numFrames, c, errors); break;
+        case 5:  quantiseWithOrder<5> (frames, noise, numFrames, c, errors); break;
+        case 6:  quantiseWithOrder<6> (frames, noise, numFrames, c, errors); break;
+        case 7:  quantiseWithOrder<7> (frames, noise, numFrames, c, errors); break;
+        case 8:  quantiseWithOrder<8> (frames, noise, numFrames, c, errors); break;
+        case 9:  quantiseWithOrder<9> (frames, noise, numFrames, c, errors); break;
+        default: quantiseWithOrder<0> (frames, noise, numFrames, c, errors); break;
+        }
+    }
+}
+
+const Table& getTable()
+{
+    static const Table table { KLIP_KERNEL_NAME, KLIP_KERNEL_ISA, clip, clipLookup, crossfade, blend, onePole, svf, transientWeights, ditherNoise, quantise };
+    return table;
+}
+
+} // namespace KLIP_KERNEL_NAMESPACE
+} // namespace ClipKernels
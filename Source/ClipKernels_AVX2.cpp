@@ -0,0 +1,19 @@
+/*
+  ==============================================================================
+
+    ClipKernels_AVX2.cpp
+
+  ==============================================================================
+*/
+
+// Built with -mavx2 -mfma (/arch:AVX2 on MSVC) by the CMake build only.
+
+#if KLIP_KERNELS_AVX2
+
+#define KLIP_KERNEL_NAMESPACE avx2
+#define KLIP_KERNEL_NAME      "AVX2"
+#define KLIP_KERNEL_ISA       ClipKernels::Isa::AVX2
+
+#include "ClipKernelsImpl.h"
+
+#endif
@@ -0,0 +1,20 @@
+/*
+  ==============================================================================
+
+    ClipKernels_AVX512.cpp
+
+  ==============================================================================
+*/
+
+// Built with -mavx512f -mavx512vl -mavx512dq -mavx512bw (/arch:AVX512 on MSVC)
+// by the CMake build only.
+
+#if KLIP_KERNELS_AVX512
+
+#define KLIP_KERNEL_NAMESPACE avx512
+#define KLIP_KERNEL_NAME      "AVX-512"
+#define KLIP_KERNEL_ISA       ClipKernels::Isa::AVX512
+
+#include "ClipKernelsImpl.h"
+
+#endif
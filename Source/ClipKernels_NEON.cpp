@@ -0,0 +1,20 @@
+/*
+  ==============================================================================
+
+    ClipKernels_NEON.cpp
+
+  ==============================================================================
+*/
+
+// NEON variant for ARM builds. On AArch64 NEON is part of the base ISA, so
+// this only differs from the baseline on 32-bit ARM (-mfpu=neon).
+
+#if KLIP_KERNELS_NEON
+
+#define KLIP_KERNEL_NAMESPACE neon
+#define KLIP_KERNEL_NAME      "NEON"
+#define KLIP_KERNEL_ISA       ClipKernels::Isa::NEON
+
+#include "ClipKernelsImpl.h"
+
+#endif
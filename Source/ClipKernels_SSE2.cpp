@@ -0,0 +1,16 @@
+/*
+  ==============================================================================
+
+    ClipKernels_SSE2.cpp
+
+  ==============================================================================
+*/
+
+// Baseline kernels: built with the default flags of the target, which means
+// SSE2 on x86-64 and plain scalar code elsewhere. Always compiled in.
+
+#define KLIP_KERNEL_NAMESPACE sse2
+#define KLIP_KERNEL_NAME      "SSE2"
+#define KLIP_KERNEL_ISA       ClipKernels::Isa::Baseline
+
+#include "ClipKernelsImpl.h"
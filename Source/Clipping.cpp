@@ -12,17 +12,85 @@
 
 
 void Clipping::setSampleRate(float newSampleRate) {
-    this->sampleRate = sampleRate;
+    sampleRate = newSampleRate;
     dcRemover.setSampleRate(newSampleRate);
+    pathDCRemover.setSampleRate(newSampleRate);
+    transientDetector.setSampleRate(newSampleRate);
+}
+
+void Clipping::setDCCutoff(float cutoffFrequency) {
+    dcRemover.setCutoff(cutoffFrequency);
+    pathDCRemover.setCutoff(cutoffFrequency);
+}
+
+void Clipping::prepare(double newSampleRate, int maximumBlockSize) {
+    setSampleRate(static_cast<float>(newSampleRate));
+    ownArena.layout([&](DspArena& arena) { allocateFrom(arena, newSampleRate, maximumBlockSize); });
+}
+
+void Clipping::allocateFrom(DspArena& arena, double newSampleRate, int maximumBlockSize, int maximumLookahead) {
+    const double lowFrequencyWindowSeconds = 0.05; // 50 milliseconds
+
+    transitionScratchSize = std::max(1, maximumBlockSize);
+    transitionScratch = arena.allocate<float>(static_cast<size_t>(transitionScratchSize));
+
+    // The split runs chunk by chunk too, so its buffers match the transition scratch
+    splitScratch = arena.allocate<float>(static_cast<size_t>(transitionScratchSize));
+    for (auto& weights : transientWeights)
+        weights = arena.allocate<float>(static_cast<size_t>(transitionScratchSize));
+    lookaheadDelay.allocateFrom(arena, maximumLookahead);
+
+    ringBufferCapacity = static_cast<int>(newSampleRate * lowFrequencyWindowSeconds);
+    ringBuffer = arena.allocate<float>(static_cast<size_t>(ringBufferCapacity));
+    ringBufferSize = std::min(ringBufferSize, ringBufferCapacity);
+    ringBufferIndex = 0;
+}
+
+Clipping::ClipType Clipping::getClipTypeForChoice(int choice) {
+    static constexpr ClipType choices[] = { SoftClip, HardClip, LinearClip, ExponentialClip, AsymmetricClip, TanhClip,
+                                            ArctanClip, AlgebraicClip, CubicKneeClip, QuinticKneeClip, SineFoldClip,
+                                            CustomClip };
+    return choice >= 0 && choice < static_cast<int>(std::size(choices)) ? choices[choice] : SoftClip;
 }
 
 void Clipping::setThreshold(float newThreshold) {
     threshold = newThreshold;
 }
 
+void Clipping::setKneeWidth(float newKneeWidth) {
+    kneeWidth = newKneeWidth;
+}
+
+void Clipping::setTransientSplit(bool enabled, ClipType transientType, float newTransientThreshold) {
+    // Switched on from a clean start, the detector and the delay hold no stale signal
+    if (enabled && ! splitActive) {
+        transientDetector.reset();
+        lookaheadDelay.reset();
+    }
+
+    splitActive = enabled && splitScratch != nullptr;
+    transientClipType = transientType;
+    transientThreshold = newTransientThreshold;
+}
+
+void Clipping::setUseExactCurves(bool shouldUseExactCurves) {
+    useExactCurves = shouldUseExactCurves;
+}
+
+void Clipping::reset() {
+    dcRemover.reset();
+    pathDCRemover.reset();
+    transientDetector.reset();
+    lookaheadDelay.reset();
+
+    previousClipType = currentClipType;
+    transitionState = 1.0f;
+}
+
 void Clipping::startTransitionTo(ClipType newType, float speed) {
     if (newType != currentClipType) {
-        newClipType = newType;
+        previousClipType = currentClipType;
+        currentClipType = newType;
         transitionSpeed = speed;
         transitionState = 0.0f;
     }
@@ -36,24 +104,27 @@ void Clipping::updateTransition() {
 }
 
 float Clipping::mixClippingFunctions(float input) {
+    float previousClip = processClip(input, previousClipType);
     float currentClip = processClip(input, currentClipType);
-    float newClip = processClip(input, newClipType);
-    return currentClip * (1.0f - transitionState) + newClip * transitionState;
+    return previousClip * (1.0f - transitionState) + currentClip * transitionState;
 }
 
 float Clipping::calculateLowFrequencyEnergy(float sample) {
+    if (ringBufferSize == 0)
+        return 0.0f;
+
     // Update ring buffer
     ringBuffer[ringBufferIndex] = sample;
-    ringBufferIndex = (ringBufferIndex + 1) % ringBuffer.size();
+    ringBufferIndex = (ringBufferIndex + 1) % ringBufferSize;
 
     // Apply low-pass filter to the buffer and calculate energy
     float squaredSum = 0.0f;
-    for (auto& s : ringBuffer) {
-        float filteredSample = lowPassFilter.processSample(s);
+    for (int i = 0; i < ringBufferSize; ++i) {
+        float filteredSample = lowPassFilter.processSample(0, ringBuffer[i]);
         squaredSum += filteredSample * filteredSample;
     }
 
-    return std::sqrt(squaredSum / ringBuffer.size());
+    return std::sqrt(squaredSum / ringBufferSize);
 }
 
 float Clipping::calculateDynamicGain(float lowFreqEnergy, float overallEnergy) {
@@ -74,7 +145,6 @@ float Clipping::calculateDynamicGain(float lowFreqEnergy, float overallEnergy) {
     }
 
     // Implementing a smoothing mechanism for gradual gain changes
-    static float smoothedGain = 1.0f;
     if (dynamicGain < smoothedGain) {
         smoothedGain = dynamicGain; // Quick reduction if needed
     }
@@ -82,14 +152,19 @@ float Clipping::calculateDynamicGain(float lowFreqEnergy, float overallEnergy) {
         smoothedGain += gainRecoveryRate * (dynamicGain - smoothedGain); // Gradual increase to normal gain
     }
 
-    return juce::jlimit(0.0f, 1.0f, smoothedGain); // Ensuring gain stays within bounds
+    return std::clamp(smoothedGain, 0.0f, 1.0f); // Ensuring gain stays within bounds
 }
 
 void Clipping::setupLowFrequencyAnalysis(int sampleRate, int bufferSize) {
-    auto lowPassCoeff = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 40.0f);
-    lowPassFilter.coefficients = lowPassCoeff;
-    ringBuffer.resize(bufferSize, 0.0f);
+    lowPassFilter.setup(MultiChannelFilter::LowPass, sampleRate, 40.0f);
+    lowPassFilter.reset();
+    // The ring buffer itself lives in the arena, sized in allocateFrom()
+    assert(bufferSize <= ringBufferCapacity);
+    ringBufferSize = std::clamp(bufferSize, 0, ringBufferCapacity);
+    if (ringBuffer != nullptr)
+        std::fill(ringBuffer, ringBuffer + ringBufferSize, 0.0f);
     ringBufferIndex = 0;
+    smoothedGain = 1.0f;
 }
 
 
@@ -107,7 +182,6 @@ float Clipping::processSample(float input, ClipType clipType) {
     // Se il tipo di clip  cambiato, inizia la transizione
     if (clipType != currentClipType) {
         startTransitionTo(clipType, 0.05f); // !! regolare la velocit di transizione come necessario
-        currentClipType = clipType;
     }
 
     // Aggiorna lo stato di transizione
@@ -117,6 +191,79 @@ float Clipping::processSample(float input, ClipType clipType) {
     return mixClippingFunctions(input);
 }
 
+void Clipping::processBlock(float* const* paths, int numPaths, int numSamples, ClipType clipType) {
+    assert(numPaths <= maxPaths);
+    numPaths = std::min(numPaths, maxPaths);
+
+    if (clipType != currentClipType) {
+        startTransitionTo(clipType, 0.05f);
+    }
+
+    // The transition needs a scratch copy per path, so hosts that exceed the block
+    // size announced in prepareToPlay are handled in scratch-sized chunks.
+    const int chunkSize = std::max(1, transitionScratchSize);
+    float* chunkPaths[maxPaths];
+
+    for (int start = 0; start < numSamples; start += chunkSize) {
+        for (int path = 0; path < numPaths; ++path)
+            chunkPaths[path] = paths[path] + start;
+
+        processChunk(chunkPaths, numPaths, std::min(chunkSize, numSamples - start));
+    }
+}
+
+void Clipping::processChunk(float* const* paths, int numPaths, int numSamples) {
+    const bool transitioning = transitionState < 1.0f && transitionScratch != nullptr;
+    const float startMix = transitionState;
+
+    pathDCRemover.processBlock(paths, numPaths, numSamples);
+
+    // Weights from the signal as it arrives, then the signal falls behind them by the lookahead
+    if (splitActive) {
+        transientDetector.process(paths, numPaths, numSamples, transientWeights);
+        lookaheadDelay.process(paths, numPaths, numSamples);
+    }
+
+    for (int path = 0; path < numPaths; ++path) {
+        float* data = paths[path];
+
+        if (transitioning) {
+            // Curva precedente nello scratch, curva corrente in place, poi crossfade
+            float* previous = transitionScratch;
+            std::copy(data, data + numSamples, previous);
+            applyShaping(previous, transientWeights[path], numSamples, previousClipType);
+            applyShaping(data, transientWeights[path], numSamples, currentClipType);
+            kernels->crossfade(data, previous, numSamples, startMix, transitionSpeed);
+        }
+        else {
+            applyShaping(data, transientWeights[path], numSamples, currentClipType);
+        }
+    }
+
+    if (transitioning) {
+        transitionState = std::min(1.0f, startMix + static_cast<float>(numSamples) * transitionSpeed);
+    }
+}
+
+void Clipping::applyShaping(float* data, const float* weights, int numSamples, ClipType clipType) {
+    if (! splitActive) {
+        applyCurve(data, numSamples, clipType, threshold);
+        return;
+    }
+
+    // Curva dei transienti nello scratch, curva di sustain in place, poi il mix pesato
+    std::copy(data, data + numSamples, splitScratch);
+    applyCurve(splitScratch, numSamples, transientClipType, transientThreshold);
+    applyCurve(data, numSamples, clipType, threshold);
+    kernels->blend(data, splitScratch, weights, numSamples);
+}
+
+void Clipping::applyCurve(float* data, int numSamples, ClipType clipType, float curveThreshold) {
+    if (useExactCurves)
+        kernels->clip(data, numSamples, clipType, { curveThreshold, kneeWidth, customCurve });
+    else
+        kernels->clipLookup(data, numSamples, clipType, { curveThreshold, kneeWidth, customCurve }, *lookupTables);
+}
 
 float Clipping::processClip(float input, ClipType clipType) {
     switch (clipType) {
@@ -125,6 +272,13 @@ float Clipping::processClip(float input, ClipType clipType) {
     case LinearClip: return linearClip(input);
     case ExponentialClip: return exponentialClip(input);
     case AsymmetricClip: return asymmetricClip(input);
+    case TanhClip: return tanhClip(input);
+    case ArctanClip: return arctanClip(input);
+    case AlgebraicClip: return algebraicClip(input);
+    case CubicKneeClip: return polynomialKneeClip(input, false);
+    case QuinticKneeClip: return polynomialKneeClip(input, true);
+    case SineFoldClip: return sineFoldClip(input);
+    case CustomClip: return customClip(input);
     
     default: return input;
     }
@@ -132,15 +286,9 @@ float Clipping::processClip(float input, ClipType clipType) {
 // =============================================================================================================================================
 
 float Clipping::softClip(float input) {
-    if (input > threshold) {
-        return (1.5f * input - 0.5f * input * input * input / threshold) / threshold;
-    }
-    else if (input < -threshold) {
-        return (-1.5f * input - 0.5f * input * input * input / threshold) / threshold;
-    }
-    else {
-        return input;
-    }
+    // Cubica normalizzata sulla soglia: arriva a threshold con pendenza zero a |u| = 1
+    const float u = std::clamp(input / threshold, -1.0f, 1.0f);
+    return threshold * u * (1.5f - 0.5f * u * u);
 }
 
 float Clipping::hardClip(float input) {
@@ -192,3 +340,55 @@ float Clipping::asymmetricClip(float input) {
         return input;
     }
 }
+
+// Reference versions of the saturating curves using the exact library functions;
+// the block kernels use the approximations documented in ClipKernelsImpl.h.
+
+float Clipping::tanhClip(float input) {
+    return threshold * std::tanh(input / threshold);
+}
+
+float Clipping::arctanClip(float input) {
+    const float halfPi = 1.57079632679489661923f;
+    return threshold * std::atan(halfPi * input / threshold) / halfPi;
+}
+
+float Clipping::algebraicClip(float input) {
+    const float normalised = input / threshold;
+    return input / std::sqrt(1.0f + normalised * normalised);
+}
+
+float Clipping::polynomialKneeClip(float input, bool quintic) {
+    // Lineare fino a kneeStart, poi ginocchio polinomiale che arriva a threshold con pendenza zero
+    const float knee = std::clamp(kneeWidth, 0.01f, 1.0f);
+    const float kneeStart = threshold * (1.0f - knee);
+    const float width = (quintic ? 1.875f : 1.5f) * threshold * knee;
+    const float magnitude = std::abs(input);
+
+    if (magnitude <= kneeStart) {
+        return input;
+    }
+
+    const float d = std::min((magnitude - kneeStart) / width, 1.0f);
+    const float shaped = quintic ? d - 2.0f * d * d * d / 3.0f + d * d * d * d * d / 5.0f
+                                 : d - d * d * d / 3.0f;
+    return std::copysign(kneeStart + width * shaped, input);
+}
+
+float Clipping::sineFoldClip(float input) {
+    return threshold * std::sin(input / threshold);
+}
+
+float Clipping::customClip(float input) {
+    if (customCurve == nullptr)
+        return hardClip(input);
+
+    // Same evaluation as the kernel: the scaled input picks the segment (NaN the guard)
+    using Segments = ClipKernels::CurveSegments;
+    const float scaled = std::fabs(input) * ((Segments::numSegments / Segments::inputRange) / threshold);
+    const float position = scaled < Segments::numSegments ? scaled : static_cast<float>(Segments::numSegments);
+    const int index = static_cast<int>(position);
+    const float u = position - static_cast<float>(index);
+    const float* c = customCurve->coefficients[index];
+    return std::copysign(threshold * (c[0] + u * (c[1] + u * (c[2] + u * c[3]))), input);
+}
@@ -9,8 +9,14 @@
 */
 #pragma once
 #include <algorithm>
-#include <JuceHeader.h>
+#include <cassert>
+#include <iterator>
 #include "OffsetDC.h"
+#include "MultiChannelFilter.h"
+#include "ClipKernels.h"
+#include "DspArena.h"
+#include "BlockDelayLine.h"
+#include "TransientDetector.h"
 
 class Clipping {
 public:
@@ -19,20 +25,77 @@ public:
 
      void setSampleRate(float sampleRate);
 
+     // Cutoff of the DC blocker in front of the curves, in Hz.
+     void setDCCutoff(float cutoffFrequency);
+     void prepare(double sampleRate, int maximumBlockSize);
+
+     // Takes the transition and split scratch, the low-frequency ring buffer and the
+     // lookahead delay (up to maximumLookahead samples at this instance's rate) from
+     // `arena`. prepare() does the same with a private arena for standalone use.
+     void allocateFrom(DspArena& arena, double sampleRate, int maximumBlockSize, int maximumLookahead = 0);
+
+     // Mid and side are the most paths the processor ever runs through one instance.
+     static constexpr int maxPaths = 2;
+
+    // The values are the curve indices used by ClipKernelsImpl.h, keep them in sync.
     enum ClipType {
         SoftClip,
         HardClip,
         LinearClip,
         ExponentialClip,
         AsymmetricClip,
-        SaturationClip
+        SaturationClip,
+        TanhClip,
+        ArctanClip,
+        AlgebraicClip,
+        CubicKneeClip,
+        QuinticKneeClip,
+        SineFoldClip,
+        CustomClip // user curve, see setCustomCurve()
         // Aggiungi altri tipi di clipping qui
     };
 
+    // Curve for an index of the clipType parameter (and KLIP_PARAM_CLIP_TYPE), which
+    // lists every curve but SaturationClip.
+    static ClipType getClipTypeForChoice(int choice);
+
     void setThreshold(float newThreshold);
+
+    // Knee width of the cubic/quintic soft-knee curves, as a fraction (0..1) of the threshold.
+    void setKneeWidth(float newKneeWidth);
+
+    // Table for CustomClip, compiled by CustomCurve; hard clip while it's null.
+    // Audio thread, before processing: the table must outlive the block.
+    void setCustomCurve(const ClipKernels::CurveSegments* segments) { customCurve = segments; }
+
+    // Transient-aware split: a TransientDetector weighs every sample between
+    // transient (1) and sustain (0), and the output mixes `transientType` at
+    // `transientThreshold` with the block's clip type at the main threshold by that
+    // weight. Both curves see the whole signal and only their outputs are mixed, so
+    // the output stays within the higher of the two thresholds. Off by default.
+    void setTransientSplit(bool enabled, ClipType transientType, float transientThreshold);
+    void setTransientSensitivity(float sensitivity) { transientDetector.setSensitivity(sensitivity); }
+
+    // Delays the signal behind the detector by `samples` at this instance's rate (up
+    // to allocateFrom's maximumLookahead), so the weight has risen by the time the
+    // attack reaches the curves. Only while the split is on; 0, the default, adds
+    // no latency.
+    void setTransientLookahead(int samples) { lookaheadDelay.setDelay(samples); }
+    int getTransientLookahead() const { return splitActive ? lookaheadDelay.getDelay() : 0; }
+
+    // Exact exp/log for the Exponential and Asymmetric curves, or the shared lookup
+    // tables (cheaper, ~1e-4 error) used for real-time playback.
+    void setUseExactCurves(bool shouldUseExactCurves);
+
+    // Clears filter and transition state, e.g. when the oversampling rate changes.
+    void reset();
     float processSample(float input, ClipType clipType);
     float processClip(float input, ClipType clipType);
 
+    // Block version of processSample: DC removal, clip curve and type transition for
+    // up to maxPaths buffers in place, using the kernels selected for this CPU.
+    void processBlock(float* const* paths, int numPaths, int numSamples, ClipType clipType);
+
     // smoothing transition
     void startTransitionTo(ClipType newType, float speed);
     void updateTransition();
@@ -42,19 +105,46 @@ public:
     float calculateLowFrequencyEnergy(float sample);
     float calculateDynamicGain(float lowFreqEnergy, float overallEnergy);
 private:
-    OffsetDCRemover dcRemover;
+    void processChunk(float* const* paths, int numPaths, int numSamples);
+    void applyCurve(float* data, int numSamples, ClipType clipType, float curveThreshold);
+    void applyShaping(float* data, const float* weights, int numSamples, ClipType clipType);
+
+    // Everything processBlock touches per block, kept together at the front of the object
+    const ClipKernels::Table* kernels = &ClipKernels::get();
+    const ClipKernels::LookupTables* lookupTables = &ClipKernels::getLookupTables();
+    float* transitionScratch = nullptr;
+    int transitionScratchSize = 0;
 
     float threshold = 0.0f; 
+    float kneeWidth = 0.5f;
+    const ClipKernels::CurveSegments* customCurve = nullptr;
+
+    bool splitActive = false;
+    ClipType transientClipType = HardClip;
+    float transientThreshold = 0.0f;
+    float* splitScratch = nullptr;
+    float* transientWeights[maxPaths] = {};
 
     float transitionState = 0.0f;
     float transitionSpeed = 0.05f; // Adjust this value as needed
     ClipType currentClipType = SoftClip;
-    ClipType newClipType = SoftClip;
+    ClipType previousClipType = SoftClip;
+    bool useExactCurves = true;
 
-    
-    juce::dsp::IIR::Filter<float> lowPassFilter;
-    std::vector<float> ringBuffer;
+    OffsetDCRemover pathDCRemover; // one lane per path
+    TransientDetector transientDetector;
+    BlockDelayLine lookaheadDelay;
+
+    // Per-sample path, analysis and storage
+    OffsetDCRemover dcRemover;
+    DspArena ownArena;
+
+    MultiChannelFilter lowPassFilter;
+    float* ringBuffer = nullptr;
+    int ringBufferCapacity = 0;
+    int ringBufferSize = 0;
     int ringBufferIndex = 0;
+    float smoothedGain = 1.0f;
     
   
     float softClip(float input);
@@ -62,7 +152,13 @@ private:
     float linearClip(float input);
     float exponentialClip(float input);
     float asymmetricClip(float input);
+    float tanhClip(float input);
+    float arctanClip(float input);
+    float algebraicClip(float input);
+    float polynomialKneeClip(float input, bool quintic);
+    float sineFoldClip(float input);
+    float customClip(float input);
     
-    float sampleRate;
+    float sampleRate = 44100.0f;
 };
 
@@ -0,0 +1,146 @@
+/*
+  ==============================================================================
+
+    CurveEditor.cpp
+
+  ==============================================================================
+*/
+
+#include "CurveEditor.h"
+
+CurveEditor::CurveEditor(KlipAudioProcessor& p) : processor(p) {
+    points = processor.getCustomCurvePoints();
+}
+
+void CurveEditor::refresh() {
+    if (draggedPoint >= 0)
+        return;
+
+    const auto& current = processor.getCustomCurvePoints();
+    const bool same = current.size() == points.size()
+        && std::equal(current.begin(), current.end(), points.begin(), [](const CustomCurve::Point& a, const CustomCurve::Point& b) {
+               return juce::approximatelyEqual(a.x, b.x) && juce::approximatelyEqual(a.y, b.y);
+           });
+
+    if (! same) {
+        points = current;
+        repaint();
+    }
+}
+
+juce::Rectangle<float> CurveEditor::getPlotArea() const {
+    return getLocalBounds().toFloat().reduced(pointRadius + 2.0f);
+}
+
+juce::Point<float> CurveEditor::toScreen(CustomCurve::Point point) const {
+    const auto area = getPlotArea();
+    return { area.getX() + area.getWidth() * point.x / maxInput,
+             area.getBottom() - area.getHeight() * point.y / CustomCurve::maxOutput };
+}
+
+CustomCurve::Point CurveEditor::fromScreen(juce::Point<float> position) const {
+    const auto area = getPlotArea();
+    return { juce::jlimit(0.0f, maxInput, (position.x - area.getX()) / area.getWidth() * maxInput),
+             juce::jlimit(0.0f, CustomCurve::maxOutput, (area.getBottom() - position.y) / area.getHeight() * CustomCurve::maxOutput) };
+}
+
+int CurveEditor::findPoint(juce::Point<float> position) const {
+    for (int i = 0; i < static_cast<int>(points.size()); ++i)
+        if (toScreen(points[static_cast<size_t>(i)]).getDistanceFrom(position) <= pointRadius * 2.0f)
+            return i;
+    return -1;
+}
+
+void CurveEditor::commit() {
+    processor.setCustomCurvePoints(points);
+    if (draggedPoint < 0)
+        points = processor.getCustomCurvePoints();
+    repaint();
+}
+
+void CurveEditor::paint(juce::Graphics& g) {
+    const auto area = getPlotArea();
+    g.fillAll(juce::Colours::black.withAlpha(0.3f));
+
+    // Griglia: una linea per unità di soglia, la soglia stessa più chiara
+    g.setColour(juce::Colours::white.withAlpha(0.1f));
+    for (int x = 1; x < static_cast<int>(maxInput); ++x)
+        g.drawVerticalLine(juce::roundToInt(toScreen({ static_cast<float>(x), 0.0f }).x), area.getY(), area.getBottom());
+    g.setColour(juce::Colours::white.withAlpha(0.25f));
+    g.drawHorizontalLine(juce::roundToInt(toScreen({ 0.0f, 1.0f }).y), area.getX(), area.getRight());
+    g.drawLine({ toScreen({ 0.0f, 0.0f }), toScreen({ CustomCurve::maxOutput, CustomCurve::maxOutput }) }, 1.0f);
+
+    if (points.size() < 2)
+        return;
+
+    const auto curvePoints = CustomCurve::sanitise(points);
+    juce::Path curve;
+    const int steps = juce::jmax(2, static_cast<int>(area.getWidth()));
+    for (int i = 0; i <= steps; ++i) {
+        const float x = maxInput * static_cast<float>(i) / static_cast<float>(steps);
+        const auto position = toScreen({ x, CustomCurve::evaluate(curvePoints, x) });
+        if (i == 0)
+            curve.startNewSubPath(position);
+        else
+            curve.lineTo(position);
+    }
+
+    g.setColour(juce::Colours::orange);
+    g.strokePath(curve, juce::PathStrokeType(2.0f));
+
+    g.setColour(juce::Colours::white);
+    for (const auto& point : points)
+        g.fillEllipse(juce::Rectangle<float>(pointRadius * 2.0f, pointRadius * 2.0f).withCentre(toScreen(point)));
+}
+
+void CurveEditor::mouseDown(const juce::MouseEvent& event) {
+    const int index = findPoint(event.position);
+
+    if (event.mods.isPopupMenu()) {
+        if (index > 0 && points.size() > 2) {
+            points.erase(points.begin() + index);
+            commit();
+        }
+        return;
+    }
+
+    draggedPoint = index;
+}
+
+void CurveEditor::mouseDrag(const juce::MouseEvent& event) {
+    if (draggedPoint < 0)
+        return;
+
+    const auto dragged = static_cast<size_t>(draggedPoint);
+    auto point = fromScreen(event.position);
+
+    // Il primo punto resta sull'origine; gli altri non scavalcano i vicini
+    if (dragged == 0)
+        point = { 0.0f, 0.0f };
+    else {
+        const float step = CustomCurve::gridStep;
+        const float low = points[dragged - 1].x + step;
+        const float high = dragged + 1 < points.size() ? points[dragged + 1].x - step : maxInput;
+        point.x = juce::jlimit(low, juce::jmax(low, high), point.x);
+    }
+
+    points[dragged] = point;
+    commit();
+}
+
+void CurveEditor::mouseUp(const juce::MouseEvent&) {
+    if (draggedPoint < 0)
+        return;
+
+    draggedPoint = -1;
+    points = processor.getCustomCurvePoints();
+    repaint();
+}
+
+void CurveEditor::mouseDoubleClick(const juce::MouseEvent& event) {
+    if (findPoint(event.position) >= 0 || static_cast<int>(points.size()) >= CustomCurve::maxPoints)
+        return;
+
+    points.push_back(fromScreen(event.position));
+    commit();
+}
@@ -0,0 +1,47 @@
+/*
+  ==============================================================================
+
+    CurveEditor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+// Editor for the Custom clip type: the positive half of the transfer curve,
+// input and output in units of the threshold. Drag a point to move it,
+// double-click to add one, right-click to remove one (the origin stays).
+// Every edit goes to KlipAudioProcessor::setCustomCurvePoints, which compiles
+// the curve off the audio thread.
+class CurveEditor : public juce::Component {
+public:
+    explicit CurveEditor(KlipAudioProcessor& processor);
+    ~CurveEditor() override = default;
+
+    // Picks up points changed elsewhere (state loaded by the host)
+    void refresh();
+
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent& event) override;
+    void mouseDrag(const juce::MouseEvent& event) override;
+    void mouseUp(const juce::MouseEvent& event) override;
+    void mouseDoubleClick(const juce::MouseEvent& event) override;
+
+private:
+    static constexpr float maxInput = ClipKernels::CurveSegments::inputRange;
+    static constexpr float pointRadius = 4.0f;
+
+    juce::Rectangle<float> getPlotArea() const;
+    juce::Point<float> toScreen(CustomCurve::Point point) const;
+    CustomCurve::Point fromScreen(juce::Point<float> position) const;
+    int findPoint(juce::Point<float> position) const;
+    void commit();
+
+    KlipAudioProcessor& processor;
+    std::vector<CustomCurve::Point> points;
+    int draggedPoint = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CurveEditor)
+};
@@ -0,0 +1,198 @@
+/*
+  ==============================================================================
+
+    CustomCurve.cpp
+
+  ==============================================================================
+*/
+
+#include "CustomCurve.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+    using Segments = ClipKernels::CurveSegments;
+
+    // Segment of the interpolant that starts at or before x
+    int findSegment(const std::vector<CustomCurve::Point>& points, double x) {
+        int segment = 0;
+        while (segment + 2 < static_cast<int>(points.size()) && points[segment + 1].x <= x)
+            ++segment;
+        return segment;
+    }
+
+    // Cubic Hermite on segment k at x: value and derivative
+    void evaluateSegment(const std::vector<CustomCurve::Point>& points, const std::vector<float>& slopes, int k, double x,
+                         double& value, double& derivative) {
+        const double h = points[k + 1].x - points[k].x;
+        const double t = (x - points[k].x) / h;
+        const double y0 = points[k].y, y1 = points[k + 1].y;
+        const double d0 = slopes[k], d1 = slopes[k + 1];
+        const double t2 = t * t, t3 = t2 * t;
+
+        value = (2.0 * t3 - 3.0 * t2 + 1.0) * y0 + (t3 - 2.0 * t2 + t) * h * d0
+              + (-2.0 * t3 + 3.0 * t2) * y1 + (t3 - t2) * h * d1;
+        derivative = (6.0 * t2 - 6.0 * t) / h * y0 + (3.0 * t2 - 4.0 * t + 1.0) * d0
+                   + (6.0 * t - 6.0 * t2) / h * y1 + (3.0 * t2 - 2.0 * t) * d1;
+    }
+}
+
+CustomCurve::CustomCurve() {
+    setPoints(getDefaultPoints());
+}
+
+std::vector<CustomCurve::Point> CustomCurve::getDefaultPoints() {
+    return { { 0.0f, 0.0f }, { 0.5f, 0.5f }, { 1.0f, 0.85f }, { 1.5f, 0.97f }, { 2.0f, 1.0f }, { 4.0f, 1.0f } };
+}
+
+std::vector<CustomCurve::Point> CustomCurve::sanitise(std::vector<Point> newPoints) {
+    for (auto& point : newPoints) {
+        const float x = std::isfinite(point.x) ? std::clamp(point.x, 0.0f, Segments::inputRange) : 0.0f;
+        point.x = std::round(x / gridStep) * gridStep;
+        point.y = std::isfinite(point.y) ? std::clamp(point.y, 0.0f, maxOutput) : 0.0f;
+    }
+
+    // Of several points on one grid step, the last one given wins
+    std::stable_sort(newPoints.begin(), newPoints.end(), [](const Point& a, const Point& b) { return a.x < b.x; });
+    std::vector<Point> result;
+    for (const auto& point : newPoints) {
+        if (! result.empty() && result.back().x == point.x)
+            result.back() = point;
+        else
+            result.push_back(point);
+    }
+
+    if (result.empty() || result.front().x > 0.0f)
+        result.insert(result.begin(), { 0.0f, 0.0f });
+    result.front().y = 0.0f;
+
+    if (result.size() > static_cast<size_t>(maxPoints))
+        result.resize(static_cast<size_t>(maxPoints));
+    if (result.size() < 2)
+        result.push_back({ 1.0f, 1.0f });
+
+    return result;
+}
+
+void CustomCurve::getSlopes(const std::vector<Point>& curvePoints, std::vector<float>& slopes) {
+    // Fritsch-Carlson: weighted harmonic mean of the neighbouring secants, zero
+    // at local extrema; one-sided three-point estimates at the ends, limited so
+    // they keep the secant's sign and stay within 3x of it.
+    const int n = static_cast<int>(curvePoints.size());
+    std::vector<double> widths(n - 1), secants(n - 1);
+    for (int k = 0; k < n - 1; ++k) {
+        widths[k] = curvePoints[k + 1].x - curvePoints[k].x;
+        secants[k] = (curvePoints[k + 1].y - curvePoints[k].y) / widths[k];
+    }
+
+    slopes.assign(n, 0.0f);
+    if (n == 2) {
+        slopes[0] = slopes[1] = static_cast<float>(secants[0]);
+        return;
+    }
+
+    for (int k = 1; k < n - 1; ++k) {
+        if (secants[k - 1] * secants[k] <= 0.0)
+            continue;
+
+        const double w1 = 2.0 * widths[k] + widths[k - 1];
+        const double w2 = widths[k] + 2.0 * widths[k - 1];
+        slopes[k] = static_cast<float>((w1 + w2) / (w1 / secants[k - 1] + w2 / secants[k]));
+    }
+
+    auto endSlope = [](double h0, double h1, double s0, double s1) {
+        double slope = ((2.0 * h0 + h1) * s0 - h0 * s1) / (h0 + h1);
+        if (slope * s0 <= 0.0)
+            slope = 0.0;
+        else if (s0 * s1 <= 0.0 && std::abs(slope) > std::abs(3.0 * s0))
+            slope = 3.0 * s0;
+        return static_cast<float>(slope);
+    };
+
+    slopes[0] = endSlope(widths[0], widths[1], secants[0], secants[1]);
+    slopes[n - 1] = endSlope(widths[n - 2], widths[n - 3], secants[n - 2], secants[n - 3]);
+}
+
+float CustomCurve::evaluate(const std::vector<Point>& curvePoints, float x) {
+    const float magnitude = std::abs(x);
+    if (! (magnitude < curvePoints.back().x))
+        return std::copysign(curvePoints.back().y, x);
+
+    std::vector<float> slopes;
+    getSlopes(curvePoints, slopes);
+
+    double value = 0.0, derivative = 0.0;
+    evaluateSegment(curvePoints, slopes, findSegment(curvePoints, magnitude), magnitude, value, derivative);
+    return std::copysign(static_cast<float>(value), x);
+}
+
+void CustomCurve::compile(const std::vector<Point>& curvePoints, Segments& segments) {
+    std::vector<float> slopes;
+    getSlopes(curvePoints, slopes);
+
+    const double step = gridStep;
+    const double lastX = curvePoints.back().x;
+    const float lastY = curvePoints.back().y;
+
+    for (int cell = 0; cell < Segments::numSegments; ++cell) {
+        float* c = segments.coefficients[cell];
+        const double x0 = cell * step;
+
+        if (x0 >= lastX) {
+            c[0] = lastY;
+            c[1] = c[2] = c[3] = 0.0f;
+            continue;
+        }
+
+        // The knots sit on the grid, so the whole cell is inside one segment and
+        // its cubic, rescaled to the cell, is exact.
+        const int k = findSegment(curvePoints, x0);
+        double y0, d0, y1, d1;
+        evaluateSegment(curvePoints, slopes, k, x0, y0, d0);
+        evaluateSegment(curvePoints, slopes, k, x0 + step, y1, d1);
+
+        const double m0 = d0 * step, m1 = d1 * step, rise = y1 - y0;
+        c[0] = static_cast<float>(y0);
+        c[1] = static_cast<float>(m0);
+        c[2] = static_cast<float>(3.0 * rise - 2.0 * m0 - m1);
+        c[3] = static_cast<float>(m0 + m1 - 2.0 * rise);
+    }
+
+    float* guard = segments.coefficients[Segments::numSegments];
+    guard[0] = lastY;
+    guard[1] = guard[2] = guard[3] = 0.0f;
+}
+
+void CustomCurve::setPoints(const std::vector<Point>& newPoints) {
+    const std::lock_guard<std::mutex> lock(writerLock);
+    points = sanitise(newPoints);
+
+    auto table = std::make_unique<Segments>();
+    compile(points, *table);
+    current.store(table.get());
+    tables.push_back(std::move(table));
+
+    // Free what the audio thread can no longer reach: anything that is neither
+    // current nor marked in use. acquire() rechecks `current` after marking, so a
+    // table it marks after this load has been checked is always the new one.
+    const auto* reading = inUse.load();
+    tables.erase(std::remove_if(tables.begin(), tables.end(), [&](const std::unique_ptr<Segments>& candidate) {
+        return candidate.get() != current.load(std::memory_order_relaxed) && candidate.get() != reading;
+    }), tables.end());
+}
+
+std::vector<CustomCurve::Point> CustomCurve::getPoints() const {
+    const std::lock_guard<std::mutex> lock(writerLock);
+    return points;
+}
+
+const ClipKernels::CurveSegments* CustomCurve::acquire() {
+    auto* table = current.load();
+    for (;;) {
+        inUse.store(table);
+        auto* latest = current.load();
+        if (latest == table)
+            return table;
+        table = latest;
+    }
+}
@@ -0,0 +1,74 @@
+/*
+  ==============================================================================
+
+    CustomCurve.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include "ClipKernels.h"
+
+// User-drawn transfer curve for Clipping::CustomClip. The control points give
+// output against input for the positive half, both in units of the threshold;
+// the curve is odd-symmetric and holds its last value past the last point.
+//
+// The points are joined by a monotone piecewise-cubic interpolant (Fritsch-
+// Carlson PCHIP: no overshoot, monotone wherever the points are), then compiled
+// into ClipKernels::CurveSegments. The points are snapped to the segment grid, so
+// each segment is one piece of the interpolant and the table reproduces it
+// exactly: the kernel costs about as much as the built-in soft clip.
+//
+// setPoints() compiles on the calling thread and publishes the table with an
+// atomic swap. The audio thread picks it up with acquire(), which also marks it
+// as in use so the writer never frees a table the audio thread may still read.
+// Writers may be on several threads (the editor on the message thread, a state
+// restore wherever the host calls it): setPoints() and getPoints() take
+// writerLock, acquire() never does. One audio thread per instance.
+class CustomCurve {
+public:
+    struct Point {
+        float x; // input / threshold, 0..ClipKernels::CurveSegments::inputRange
+        float y; // output / threshold, 0..maxOutput
+    };
+
+    static constexpr int maxPoints = 16;
+    static constexpr float maxOutput = 2.0f;
+    static constexpr float gridStep = ClipKernels::CurveSegments::inputRange / ClipKernels::CurveSegments::numSegments;
+
+    CustomCurve();
+    ~CustomCurve() = default;
+
+    // A soft knee from 0.5 to 2 x the threshold
+    static std::vector<Point> getDefaultPoints();
+
+    // What compile() actually uses: clamped, snapped to the grid, sorted, one
+    // point per x, at most maxPoints and always starting at (0, 0).
+    static std::vector<Point> sanitise(std::vector<Point> points);
+
+    // Points must be sanitised
+    static void compile(const std::vector<Point>& points, ClipKernels::CurveSegments& segments);
+    static float evaluate(const std::vector<Point>& points, float x);
+
+    // Any thread but the audio thread
+    void setPoints(const std::vector<Point>& newPoints);
+    std::vector<Point> getPoints() const;
+
+    // Audio thread, once per block: the table to pass to Clipping::setCustomCurve.
+    const ClipKernels::CurveSegments* acquire();
+
+private:
+    static void getSlopes(const std::vector<Point>& points, std::vector<float>& slopes);
+
+    std::atomic<ClipKernels::CurveSegments*> current { nullptr };
+    std::atomic<ClipKernels::CurveSegments*> inUse { nullptr };
+
+    // Under writerLock: every table not freed yet, the current one included
+    mutable std::mutex writerLock;
+    std::vector<std::unique_ptr<ClipKernels::CurveSegments>> tables;
+    std::vector<Point> points;
+};
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    DspArena.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+
+// One aligned block that holds all of an instance's DSP scratch and state.
+// Components take their buffers from it in a fixed order through
+// allocate<T>(). layout() runs the same callback twice: the first pass only
+// measures, then the block is (re)allocated, then the second pass hands out
+// the real pointers. Nothing here may be called from the audio thread.
+class DspArena {
+public:
+    // Cache line; also enough for AVX-512 loads.
+    static constexpr size_t alignment = 64;
+
+    DspArena() = default;
+    ~DspArena() = default;
+
+    template <typename LayoutFunction>
+    void layout(LayoutFunction&& allocateAll) {
+        measuring = true;
+        used = 0;
+        allocateAll(*this);
+
+        const size_t required = used;
+        if (required > capacity) {
+            storage.reset(new char[required + alignment]);
+            capacity = required;
+        }
+
+        auto address = reinterpret_cast<std::uintptr_t>(storage.get());
+        base = reinterpret_cast<char*>((address + alignment - 1) & ~(std::uintptr_t)(alignment - 1));
+        if (base != nullptr)
+            std::memset(base, 0, capacity);
+
+        measuring = false;
+        used = 0;
+        allocateAll(*this);
+    }
+
+    // Returns `count` zeroed, aligned elements; nullptr during the measuring pass.
+    template <typename T>
+    T* allocate(size_t count) {
+        const size_t offset = (used + alignment - 1) & ~(alignment - 1);
+        used = offset + count * sizeof(T);
+        return measuring ? nullptr : reinterpret_cast<T*>(base + offset);
+    }
+
+    size_t getSizeInBytes() const { return capacity; }
+
+private:
+    std::unique_ptr<char[]> storage;
+    char* base = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+    bool measuring = false;
+
+    DspArena(const DspArena&) = delete;
+    DspArena& operator=(const DspArena&) = delete;
+};
@@ -0,0 +1,422 @@
+/*
+  ==============================================================================
+
+    FlightRecorder.cpp
+
+  ==============================================================================
+*/
+
+#include "FlightRecorder.h"
+#include "ClipKernels.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+    constexpr int captureMagic = 0x5246504b; // "KPFR"
+    constexpr int captureVersion = 2; // 2: custom curve points after the parameter IDs
+    const char* const manualReason = "manual";
+
+    double nowInSeconds() {
+        return juce::Time::getMillisecondCounterHiRes() * 0.001;
+    }
+}
+
+//==============================================================================
+// One thread for every recorder in the process: it allocates rings for
+// recorders enabled after prepare() and writes the captures.
+class FlightRecorderWriter : private juce::Thread {
+public:
+    FlightRecorderWriter() : juce::Thread("Klip flight recorder") {
+        startThread();
+    }
+
+    ~FlightRecorderWriter() override {
+        stopThread(2000);
+    }
+
+    void add(FlightRecorder* recorder) {
+        const juce::ScopedLock sl(lock);
+        recorders.add(recorder);
+    }
+
+    void remove(FlightRecorder* recorder) {
+        const juce::ScopedLock sl(lock);
+        recorders.removeFirstMatchingValue(recorder);
+    }
+
+private:
+    void run() override {
+        // Polls rather than being signalled: notify() can lock, and the audio
+        // thread is the one raising most requests.
+        while (! threadShouldExit()) {
+            wait(50);
+
+            const juce::ScopedLock sl(lock);
+            for (auto* recorder : recorders)
+                recorder->service();
+        }
+    }
+
+    juce::CriticalSection lock;
+    juce::Array<FlightRecorder*> recorders;
+};
+
+//==============================================================================
+FlightRecorder::FlightRecorder() {
+    captureDirectory = juce::File::getSpecialLocation(juce::File::userDocumentsDirectory).getChildFile("Klip Captures");
+    writer->add(this);
+}
+
+FlightRecorder::~FlightRecorder() {
+    writer->remove(this);
+}
+
+void FlightRecorder::prepare(double newSampleRate, int newMaxBlockSize, int newNumChannels,
+                             const juce::StringArray& newParameterIDs, double newSeconds) {
+    const juce::ScopedLock sl(storageLock);
+
+    sampleRate = newSampleRate;
+    maxBlockSize = juce::jmax(1, newMaxBlockSize);
+    numChannels = juce::jlimit(1, maxChannels, newNumChannels);
+    parameterIDs = newParameterIDs;
+    numParameters = juce::jmin(maxParameters, parameterIDs.size());
+    jassert(parameterIDs.size() <= maxParameters);
+    seconds = newSeconds;
+
+    samplePosition = 0;
+    blockActive = false;
+    writtenBlocks.store(0, std::memory_order_relaxed);
+    writtenSamples.store(0, std::memory_order_relaxed);
+
+    ready.store(false, std::memory_order_release);
+    if (isEnabled() || ! recordStorage.empty())
+        allocateStorage();
+}
+
+void FlightRecorder::allocateStorage() {
+    // Room for the window plus the block being written while the writer copies
+    const auto capacity = static_cast<uint64_t>(juce::nextPowerOfTwo(static_cast<int>(seconds * sampleRate) + maxBlockSize));
+    for (int channel = 0; channel < maxChannels; ++channel)
+        audioStorage[channel].assign(channel < numChannels ? capacity : 0, 0.0f);
+
+    // Blocks shorter than 32 samples shrink the window to what the records cover
+    recordCapacity = capacity / 32 + 64;
+    recordStorage.assign(recordCapacity, BlockRecord());
+    audioMask = capacity - 1;
+
+    ready.store(true, std::memory_order_release);
+}
+
+void FlightRecorder::setCaptureDirectory(const juce::File& directory) {
+    const juce::SpinLock::ScopedLockType sl(fileLock);
+    captureDirectory = directory;
+}
+
+juce::File FlightRecorder::getLastCaptureFile() const {
+    const juce::SpinLock::ScopedLockType sl(fileLock);
+    return lastCaptureFile;
+}
+
+void FlightRecorder::requestCapture() {
+    pendingReason.store(manualReason, std::memory_order_release);
+}
+
+void FlightRecorder::triggerCapture(const char* reason) {
+    const char* expected = nullptr;
+    pendingReason.compare_exchange_strong(expected, reason, std::memory_order_release, std::memory_order_relaxed);
+}
+
+//==============================================================================
+void FlightRecorder::beginBlock(const juce::AudioBuffer<float>& input, int channelsToRecord,
+                                std::atomic<float>* const* values, int qualityLevel, bool nonRealtime, bool liveMode) {
+    const int numSamples = input.getNumSamples();
+    current.sampleStart = samplePosition;
+    current.numSamples = numSamples;
+
+    blockActive = isEnabled() && ready.load(std::memory_order_acquire) && numSamples <= maxBlockSize;
+    if (! blockActive)
+        return;
+
+    current.flags = (nonRealtime ? static_cast<uint32_t>(NonRealtime) : 0u) | (liveMode ? static_cast<uint32_t>(LiveMode) : 0u);
+    current.qualityLevel = qualityLevel;
+    for (int i = 0; i < numParameters; ++i)
+        current.parameters[i] = values[i]->load(std::memory_order_relaxed);
+
+    // Copy in at most two runs, split where the ring wraps
+    const auto ringSize = audioMask + 1;
+    const int offset = static_cast<int>(samplePosition & audioMask);
+    const int firstRun = static_cast<int>(juce::jmin<uint64_t>(static_cast<uint64_t>(numSamples), ringSize - static_cast<uint64_t>(offset)));
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        float* ring = audioStorage[channel].data();
+        if (channel < juce::jmin(channelsToRecord, input.getNumChannels())) {
+            const float* source = input.getReadPointer(channel);
+            std::memcpy(ring + offset, source, static_cast<size_t>(firstRun) * sizeof(float));
+            std::memcpy(ring, source + firstRun, static_cast<size_t>(numSamples - firstRun) * sizeof(float));
+        }
+        else {
+            std::fill(ring + offset, ring + offset + firstRun, 0.0f);
+            std::fill(ring, ring + (numSamples - firstRun), 0.0f);
+        }
+    }
+}
+
+void FlightRecorder::endBlock(const juce::AudioBuffer<float>& output, double elapsedSeconds, bool overBudget) {
+    samplePosition += static_cast<uint64_t>(current.numSamples);
+    if (! blockActive)
+        return;
+
+    bool nonFinite = false;
+    current.outputHash = hashBlock(output, juce::jmin(numChannels, output.getNumChannels()), current.numSamples, nonFinite);
+    current.elapsedMicros = static_cast<float>(elapsedSeconds * 1.0e6);
+    if (nonFinite)
+        current.flags |= NonFiniteOutput;
+    if (overBudget)
+        current.flags |= BudgetOverrun;
+
+    const uint64_t block = writtenBlocks.load(std::memory_order_relaxed);
+    recordStorage[block % recordCapacity] = current;
+    writtenSamples.store(samplePosition, std::memory_order_release);
+    writtenBlocks.store(block + 1, std::memory_order_release);
+
+    if (nonFinite)
+        triggerCapture("non-finite");
+    else if (overBudget)
+        triggerCapture("overrun");
+}
+
+uint64_t FlightRecorder::hashBlock(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, bool& nonFinite) {
+    uint64_t hash = 14695981039346656037ull;
+    uint32_t infinityOrNaN = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel) {
+        const float* data = buffer.getReadPointer(channel);
+        for (int i = 0; i < numSamples; ++i) {
+            uint32_t bits;
+            std::memcpy(&bits, data + i, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ull;
+            infinityOrNaN |= static_cast<uint32_t>((bits & 0x7f800000u) == 0x7f800000u);
+        }
+    }
+
+    nonFinite = infinityOrNaN != 0;
+    return hash;
+}
+
+//==============================================================================
+void FlightRecorder::service() {
+    if (isEnabled() && ! ready.load(std::memory_order_acquire)) {
+        const juce::ScopedLock sl(storageLock);
+        if (! ready.load(std::memory_order_relaxed) && maxBlockSize > 0)
+            allocateStorage();
+    }
+
+    const char* reason = pendingReason.load(std::memory_order_acquire);
+    if (reason == nullptr)
+        return;
+
+    const bool manual = reason == manualReason;
+    const double now = nowInSeconds();
+    if (! manual && now - lastAutomaticCapture < minimumCaptureInterval) {
+        pendingReason.store(nullptr, std::memory_order_relaxed);
+        return;
+    }
+
+    if (captureDueTime <= 0.0)
+        captureDueTime = now + (manual ? 0.0 : postTriggerSeconds);
+    if (now < captureDueTime)
+        return;
+
+    captureDueTime = 0.0;
+    pendingReason.store(nullptr, std::memory_order_relaxed);
+    if (! manual)
+        lastAutomaticCapture = now;
+
+    writeCapture(reason);
+}
+
+void FlightRecorder::writeCapture(const char* reason) {
+    const juce::ScopedLock sl(storageLock);
+    if (! ready.load(std::memory_order_acquire))
+        return;
+
+    const uint64_t endBlock = writtenBlocks.load(std::memory_order_acquire);
+    if (endBlock == 0)
+        return;
+
+    // Newest contiguous run of records whose audio is still in the ring
+    const uint64_t audioCapacity = audioMask + 1 - static_cast<uint64_t>(maxBlockSize);
+    const uint64_t oldestBlock = endBlock > recordCapacity ? endBlock - recordCapacity : 0;
+    std::vector<BlockRecord> blocks;
+    blocks.reserve(static_cast<size_t>(endBlock - oldestBlock));
+
+    const BlockRecord& newest = recordStorage[(endBlock - 1) % recordCapacity];
+    const uint64_t endSample = newest.sampleStart + static_cast<uint64_t>(newest.numSamples);
+    for (uint64_t block = endBlock; block > oldestBlock; --block) {
+        const BlockRecord& record = recordStorage[(block - 1) % recordCapacity];
+        const uint64_t expectedEnd = blocks.empty() ? endSample : blocks.back().sampleStart;
+        if (record.sampleStart + static_cast<uint64_t>(record.numSamples) != expectedEnd
+            || endSample - record.sampleStart > audioCapacity)
+            break;
+
+        blocks.push_back(record);
+    }
+    std::reverse(blocks.begin(), blocks.end());
+
+    const uint64_t startSample = blocks.front().sampleStart;
+    const int length = static_cast<int>(endSample - startSample);
+    juce::AudioBuffer<float> audio(numChannels, length);
+    for (int channel = 0; channel < numChannels; ++channel)
+        for (int i = 0; i < length; ++i)
+            audio.setSample(channel, i, audioStorage[channel][(startSample + static_cast<uint64_t>(i)) & audioMask]);
+
+    // The audio thread kept going while we copied: drop whatever it may have
+    // overwritten since, including the block it's writing right now.
+    std::atomic_thread_fence(std::memory_order_acquire);
+    const uint64_t blocksNow = writtenBlocks.load(std::memory_order_relaxed);
+    const uint64_t samplesNow = writtenSamples.load(std::memory_order_relaxed) + static_cast<uint64_t>(maxBlockSize);
+    const uint64_t firstSafeBlock = blocksNow + 1 > recordCapacity ? blocksNow + 1 - recordCapacity : 0;
+    const uint64_t firstSafeSample = samplesNow > audioMask + 1 ? samplesNow - (audioMask + 1) : 0;
+    const uint64_t firstCopiedBlock = endBlock - blocks.size();
+
+    size_t skip = 0;
+    while (skip < blocks.size()
+           && (firstCopiedBlock + skip < firstSafeBlock || blocks[skip].sampleStart < firstSafeSample))
+        ++skip;
+
+    if (skip == blocks.size())
+        return;
+
+    juce::File directory;
+    {
+        const juce::SpinLock::ScopedLockType fl(fileLock);
+        directory = captureDirectory;
+    }
+    directory.createDirectory();
+    const auto file = directory.getNonexistentChildFile("Klip " + juce::Time::getCurrentTime().formatted("%Y-%m-%d %H-%M-%S") + " " + reason, ".klipcapture");
+
+    juce::FileOutputStream stream(file);
+    if (! stream.openedOk())
+        return;
+
+    stream.writeInt(captureMagic);
+    stream.writeInt(captureVersion);
+    stream.writeDouble(sampleRate);
+    stream.writeInt(maxBlockSize);
+    stream.writeInt(numChannels);
+    stream.writeString(ClipKernels::get().name);
+    stream.writeString(reason);
+    stream.writeInt(numParameters);
+    for (int i = 0; i < numParameters; ++i)
+        stream.writeString(parameterIDs[i]);
+
+    // Sanitised already, so the replay compiles exactly this table
+    const auto curvePoints = customCurve != nullptr ? customCurve->getPoints() : std::vector<CustomCurve::Point>();
+    stream.writeInt(static_cast<int>(curvePoints.size()));
+    for (const auto& point : curvePoints) {
+        stream.writeFloat(point.x);
+        stream.writeFloat(point.y);
+    }
+
+    stream.writeInt64(static_cast<juce::int64>(blocks.size() - skip));
+    for (size_t b = skip; b < blocks.size(); ++b) {
+        const auto& record = blocks[b];
+        stream.writeInt64(static_cast<juce::int64>(record.sampleStart));
+        stream.writeInt(record.numSamples);
+        stream.writeInt(static_cast<int>(record.flags));
+        stream.writeInt(record.qualityLevel);
+        stream.writeFloat(record.elapsedMicros);
+        stream.writeInt64(static_cast<juce::int64>(record.outputHash));
+        for (int i = 0; i < numParameters; ++i)
+            stream.writeFloat(record.parameters[i]);
+
+        const int offset = static_cast<int>(record.sampleStart - startSample);
+        for (int channel = 0; channel < numChannels; ++channel)
+            for (int i = 0; i < record.numSamples; ++i)
+                stream.writeFloat(audio.getSample(channel, offset + i));
+    }
+
+    stream.flush();
+
+    const juce::SpinLock::ScopedLockType fl(fileLock);
+    lastCaptureFile = file;
+}
+
+//==============================================================================
+bool FlightRecorder::readCapture(const juce::File& file, Capture& capture) {
+    juce::FileInputStream stream(file);
+    if (! stream.openedOk() || stream.readInt() != captureMagic)
+        return false;
+
+    const int version = stream.readInt();
+    if (version < 1 || version > captureVersion)
+        return false;
+
+    capture.sampleRate = stream.readDouble();
+    capture.maxBlockSize = stream.readInt();
+    capture.numChannels = stream.readInt();
+    capture.kernels = stream.readString();
+    capture.reason = stream.readString();
+
+    const int numParameters = stream.readInt();
+    if (capture.numChannels < 1 || capture.numChannels > maxChannels || capture.maxBlockSize < 1
+        || numParameters < 0 || numParameters > maxParameters)
+        return false;
+
+    capture.parameterIDs.clear();
+    for (int i = 0; i < numParameters; ++i)
+        capture.parameterIDs.add(stream.readString());
+
+    capture.customCurvePoints.clear();
+    if (version >= 2) {
+        const int numPoints = stream.readInt();
+        if (numPoints < 0 || numPoints > CustomCurve::maxPoints)
+            return false;
+
+        for (int i = 0; i < numPoints; ++i) {
+            const float x = stream.readFloat();
+            capture.customCurvePoints.push_back({ x, stream.readFloat() });
+        }
+    }
+
+    const auto numBlocks = stream.readInt64();
+    if (numBlocks <= 0)
+        return false;
+
+    // Each block carries at least its header, so a sane count fits the file
+    const auto remaining = stream.getTotalLength() - stream.getPosition();
+    if (numBlocks > remaining / 32)
+        return false;
+
+    capture.blocks.clear();
+    capture.blocks.reserve(static_cast<size_t>(numBlocks));
+    std::vector<std::vector<float>> channels(static_cast<size_t>(capture.numChannels));
+
+    for (juce::int64 b = 0; b < numBlocks; ++b) {
+        BlockRecord record;
+        record.sampleStart = static_cast<uint64_t>(stream.readInt64());
+        record.numSamples = stream.readInt();
+        record.flags = static_cast<uint32_t>(stream.readInt());
+        record.qualityLevel = stream.readInt();
+        record.elapsedMicros = stream.readFloat();
+        record.outputHash = static_cast<uint64_t>(stream.readInt64());
+        for (int i = 0; i < numParameters; ++i)
+            record.parameters[i] = stream.readFloat();
+
+        if (record.numSamples < 0 || record.numSamples > capture.maxBlockSize || stream.isExhausted())
+            return false;
+
+        for (auto& channel : channels)
+            for (int i = 0; i < record.numSamples; ++i)
+                channel.push_back(stream.readFloat());
+
+        capture.blocks.push_back(record);
+    }
+
+    const int length = static_cast<int>(channels[0].size());
+    capture.input.setSize(capture.numChannels, length);
+    for (int channel = 0; channel < capture.numChannels; ++channel)
+        capture.input.copyFrom(channel, 0, channels[static_cast<size_t>(channel)].data(), length);
+
+    return true;
+}
@@ -0,0 +1,155 @@
+/*
+  ==============================================================================
+
+    FlightRecorder.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+#include "CustomCurve.h"
+
+class FlightRecorderWriter;
+
+// Opt-in black box for glitch reports. While enabled, the audio thread copies
+// every block's input, the raw parameter values it ran with, the governor
+// level, its processing time and a hash of its output into preallocated rings
+// (the last `seconds` of audio). Nothing on the audio thread locks or allocates.
+//
+// A capture is written to disk on request or automatically after an anomaly
+// (non-finite output, block over the CPU budget), by one writer thread shared
+// by every instance in the process. The writer copies the rings while the audio
+// thread keeps going and then drops whatever was overwritten in the meantime.
+//
+// The header also holds the custom curve's points, which live in the plugin
+// state rather than in a parameter. They are the ones in use when the capture
+// is written: a curve edited inside the window replays as its last version.
+//
+// Captures replay through KlipCli ("replay"). The output hashes make the
+// replay check itself: blocks match bit for bit when the capture starts at
+// prepareToPlay and the replaying build uses the same kernels and compiler
+// settings. Later captures converge once the filter state has settled, except
+// for state that never settles and isn't recorded: the dither noise streams
+// and the spectral engine's hop phase. Blocks with dither or the spectral
+// engine only match in captures that start at prepareToPlay.
+class FlightRecorder {
+public:
+    static constexpr int maxParameters = 32;
+    static constexpr int maxChannels = 2;
+    static constexpr double defaultSeconds = 10.0;
+
+    enum Flags : uint32_t {
+        NonFiniteOutput = 1,
+        BudgetOverrun = 2,
+        NonRealtime = 4,
+        LiveMode = 8 // no host-rate delay, spectral engine or transient lookahead
+    };
+
+    struct BlockRecord {
+        uint64_t sampleStart = 0; // samples since prepareToPlay
+        int32_t numSamples = 0;
+        uint32_t flags = 0;
+        int32_t qualityLevel = 0;
+        float elapsedMicros = 0.0f;
+        uint64_t outputHash = 0;
+        float parameters[maxParameters] = {};
+    };
+
+    // What a capture file holds, as read back by the CLI. Input is one channel
+    // array per channel, all blocks back to back.
+    struct Capture {
+        double sampleRate = 44100.0;
+        int maxBlockSize = 0;
+        int numChannels = 0;
+        juce::String kernels;
+        juce::String reason;
+        juce::StringArray parameterIDs;
+        std::vector<CustomCurve::Point> customCurvePoints; // sanitised; empty in version 1 captures
+        std::vector<BlockRecord> blocks;
+        juce::AudioBuffer<float> input;
+    };
+
+    FlightRecorder();
+    ~FlightRecorder();
+
+    // Message thread, audio stopped. Allocates the rings if recording is (or
+    // ever was) enabled; otherwise the writer thread does it on first enable.
+    void prepare(double sampleRate, int maxBlockSize, int numChannels, const juce::StringArray& parameterIDs,
+                 double seconds = defaultSeconds);
+
+    // Message thread, before prepare(). The curve must outlive the recorder.
+    void setCustomCurve(const CustomCurve* curve) { customCurve = curve; }
+
+    // Any thread
+    void setEnabled(bool shouldRecord) { enabled.store(shouldRecord, std::memory_order_relaxed); }
+    bool isEnabled() const { return enabled.load(std::memory_order_relaxed); }
+    void requestCapture(); // written straight away
+    void setCaptureDirectory(const juce::File& directory);
+    juce::File getLastCaptureFile() const;
+
+    // Audio thread, around processing one block. Values are the raw parameter
+    // atomics in parameterIDs order; liveMode is whether the block runs the
+    // live path, which changes the output as much as a parameter does.
+    void beginBlock(const juce::AudioBuffer<float>& input, int numChannels, std::atomic<float>* const* values,
+                    int qualityLevel, bool nonRealtime, bool liveMode);
+    void endBlock(const juce::AudioBuffer<float>& output, double elapsedSeconds, bool overBudget);
+
+    // Word-wise FNV-1a over the sample bits, also reports NaN/Inf.
+    static uint64_t hashBlock(const juce::AudioBuffer<float>& buffer, int numChannels, int numSamples, bool& nonFinite);
+
+    static bool readCapture(const juce::File& file, Capture& capture);
+
+private:
+    friend class FlightRecorderWriter;
+
+    // Anomalies keep recording for postTriggerSeconds so the capture shows the
+    // aftermath too, and at most one is written per minimumCaptureInterval.
+    static constexpr double postTriggerSeconds = 1.0;
+    static constexpr double minimumCaptureInterval = 30.0;
+    void triggerCapture(const char* reason);
+
+    // Writer thread
+    void service();
+    void allocateStorage();
+    void writeCapture(const char* reason);
+
+    std::atomic<bool> enabled { false };
+    std::atomic<bool> ready { false };
+    std::atomic<const char*> pendingReason { nullptr };
+    juce::CriticalSection storageLock; // prepare() vs writer thread, never the audio thread
+
+    // Configuration, set in prepare()
+    double sampleRate = 44100.0;
+    int maxBlockSize = 0;
+    int numChannels = 2;
+    juce::StringArray parameterIDs;
+    int numParameters = 0;
+    double seconds = defaultSeconds;
+    const CustomCurve* customCurve = nullptr;
+
+    // Rings: audio indexed by absolute sample & audioMask, records by block index
+    std::vector<float> audioStorage[maxChannels];
+    std::vector<BlockRecord> recordStorage;
+    uint64_t audioMask = 0;
+    uint64_t recordCapacity = 0;
+
+    // Audio thread state; the counters are what the writer reads
+    BlockRecord current;
+    uint64_t samplePosition = 0;
+    bool blockActive = false;
+    std::atomic<uint64_t> writtenBlocks { 0 };
+    std::atomic<uint64_t> writtenSamples { 0 };
+
+    juce::File captureDirectory;
+    juce::File lastCaptureFile;
+    juce::SpinLock fileLock;
+    double captureDueTime = 0.0;
+    double lastAutomaticCapture = -1.0e9;
+
+    juce::SharedResourcePointer<FlightRecorderWriter> writer;
+
+    JUCE_DECLARE_NON_COPYABLE(FlightRecorder)
+};
@@ -0,0 +1,185 @@
+/*
+  ==============================================================================
+
+    KlipDsp.cpp
+
+  ==============================================================================
+*/
+
+#include "KlipDsp.h"
+#include "StereoClipper.h"
+#include <cmath>
+#include <new>
+
+namespace {
+    constexpr int numParameters = KLIP_PARAM_EXACT_CURVES + 1;
+
+    // Indexed by klip_parameter
+    constexpr float defaultValues[numParameters] = { -12.0f, 0.0f, 2.0f, 0.5f, OffsetDCRemover::defaultCutoff, 0.0f, 0.0f, 0.0f };
+
+    int toChoice(float value, int numChoices) {
+        return std::clamp(static_cast<int>(std::lround(value)), 0, numChoices - 1);
+    }
+}
+
+struct klip_processor {
+    StereoClipper clipper;
+    float values[numParameters] = {};
+};
+
+int klip_get_api_version(void) {
+    return KLIP_API_VERSION;
+}
+
+void klip_config_init(klip_config* config) {
+    if (config == nullptr)
+        return;
+
+    config->struct_size = sizeof(klip_config);
+    config->sample_rate = 44100.0;
+    config->max_block_size = 512;
+}
+
+klip_status klip_create(const klip_config* config, klip_processor** processor) {
+    if (processor == nullptr)
+        return KLIP_ERROR_INVALID_ARGUMENT;
+    *processor = nullptr;
+
+    if (config == nullptr || config->struct_size < sizeof(klip_config)
+        || ! (config->sample_rate > 0.0) || config->max_block_size <= 0)
+        return KLIP_ERROR_INVALID_ARGUMENT;
+
+    auto* created = new (std::nothrow) klip_processor();
+    if (created == nullptr)
+        return KLIP_ERROR_OUT_OF_MEMORY;
+
+    try {
+        created->clipper.prepare(config->sample_rate, config->max_block_size);
+    }
+    catch (const std::bad_alloc&) {
+        delete created;
+        return KLIP_ERROR_OUT_OF_MEMORY;
+    }
+
+    for (int parameter = 0; parameter < numParameters; ++parameter)
+        klip_set_parameter(created, static_cast<klip_parameter>(parameter), defaultValues[parameter]);
+
+    *processor = created;
+    return KLIP_OK;
+}
+
+void klip_destroy(klip_processor* processor) {
+    delete processor;
+}
+
+klip_status klip_set_parameter(klip_processor* processor, klip_parameter parameter, float value) {
+    if (processor == nullptr || ! std::isfinite(value))
+        return KLIP_ERROR_INVALID_ARGUMENT;
+
+    auto& clipper = processor->clipper;
+    auto* values = processor->values;
+
+    switch (parameter) {
+    case KLIP_PARAM_THRESHOLD_DB:
+        value = std::clamp(value, StereoClipper::minThresholdDecibels, StereoClipper::maxThresholdDecibels);
+        clipper.setThresholdDecibels(value);
+        break;
+    case KLIP_PARAM_CLIP_TYPE:
+        value = static_cast<float>(toChoice(value, 12));
+        clipper.setClipType(Clipping::getClipTypeForChoice(static_cast<int>(value)));
+        break;
+    case KLIP_PARAM_MS_MODE:
+        value = static_cast<float>(toChoice(value, 3));
+        clipper.setMode(static_cast<MidSide::Mode>(static_cast<int>(value)));
+        break;
+    case KLIP_PARAM_KNEE_WIDTH:
+        value = std::clamp(value, 0.0f, 1.0f);
+        clipper.setKneeWidth(value);
+        break;
+    case KLIP_PARAM_DC_CUTOFF:
+        value = std::clamp(value, OffsetDCRemover::minCutoff, OffsetDCRemover::maxCutoff);
+        clipper.setDCCutoff(value);
+        break;
+    case KLIP_PARAM_DITHER_BITS:
+    case KLIP_PARAM_NOISE_SHAPING:
+        if (parameter == KLIP_PARAM_DITHER_BITS)
+            value = value < 8.0f ? 0.0f : (value < 20.0f ? 16.0f : 24.0f);
+        else
+            value = static_cast<float>(toChoice(value, 4));
+
+        values[parameter] = value;
+        clipper.setDither(static_cast<int>(values[KLIP_PARAM_DITHER_BITS]),
+                          static_cast<OutputDither::Shape>(static_cast<int>(values[KLIP_PARAM_NOISE_SHAPING])));
+        return KLIP_OK;
+    case KLIP_PARAM_EXACT_CURVES:
+        value = value >= 0.5f ? 1.0f : 0.0f;
+        clipper.setUseExactCurves(value > 0.0f);
+        break;
+    default:
+        return KLIP_ERROR_UNKNOWN_PARAMETER;
+    }
+
+    values[parameter] = value;
+    return KLIP_OK;
+}
+
+klip_status klip_get_parameter(const klip_processor* processor, klip_parameter parameter, float* value) {
+    if (processor == nullptr || value == nullptr)
+        return KLIP_ERROR_INVALID_ARGUMENT;
+    if (parameter < 0 || parameter >= numParameters)
+        return KLIP_ERROR_UNKNOWN_PARAMETER;
+
+    *value = processor->values[parameter];
+    return KLIP_OK;
+}
+
+klip_status klip_set_custom_curve(klip_processor* processor, const float* points, int num_points) {
+    if (processor == nullptr || num_points < 0 || (num_points > 0 && points == nullptr))
+        return KLIP_ERROR_INVALID_ARGUMENT;
+
+    try {
+        std::vector<CustomCurve::Point> curve;
+        for (int point = 0; point < num_points; ++point)
+            curve.push_back({ points[2 * point], points[2 * point + 1] });
+
+        processor->clipper.setCustomCurve(curve);
+    }
+    catch (const std::bad_alloc&) {
+        return KLIP_ERROR_OUT_OF_MEMORY;
+    }
+
+    return KLIP_OK;
+}
+
+void klip_reset(klip_processor* processor) {
+    if (processor != nullptr)
+        processor->clipper.reset();
+}
+
+klip_status klip_process_planar(klip_processor* processor, float* const* channels, int num_channels, int num_frames) {
+    if (processor == nullptr || num_channels < 0 || num_frames < 0 || (num_channels > 0 && channels == nullptr))
+        return KLIP_ERROR_INVALID_ARGUMENT;
+
+    for (int channel = 0; channel < std::min(num_channels, 2); ++channel)
+        if (channels[channel] == nullptr)
+            return KLIP_ERROR_INVALID_ARGUMENT;
+
+    processor->clipper.processPlanar(channels, num_channels, num_frames);
+    return KLIP_OK;
+}
+
+klip_status klip_process_interleaved(klip_processor* processor, float* frames, int num_channels, int num_frames) {
+    if (processor == nullptr || num_channels < 0 || num_frames < 0 || (num_channels > 0 && num_frames > 0 && frames == nullptr))
+        return KLIP_ERROR_INVALID_ARGUMENT;
+
+    processor->clipper.processInterleaved(frames, num_channels, num_frames);
+    return KLIP_OK;
+}
+
+int klip_get_latency(const klip_processor*) {
+    return 0;
+}
+
+const char* klip_get_kernel_name(void) {
+    return ClipKernels::get().name;
+}
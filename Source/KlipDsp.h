@@ -0,0 +1,111 @@
+/*
+  ==============================================================================
+
+    KlipDsp.h
+
+    C API of the klip_dsp library: the time-domain clipper (mid/side, DC
+    blocker, clip curves, dither) without JUCE or any GUI code.
+
+    Audio is processed in place in caller-owned float buffers, planar (one
+    array per channel) or interleaved. klip_create allocates everything; the
+    process, parameter and reset calls never allocate or lock. One channel is
+    processed as a single path; with two or more, channels 0 and 1 are left
+    and right and the others are left as they are.
+
+    A processor is not thread safe: calls on one processor must not overlap.
+    Different processors are independent.
+
+    The enum values and the layout of klip_config are part of the ABI. New
+    parameters get new ids and klip_config only grows at the end, with
+    struct_size telling the library which version the caller was built with.
+
+  ==============================================================================
+*/
+
+#ifndef KLIP_DSP_H
+#define KLIP_DSP_H
+
+#include <stddef.h>
+
+#if defined(KLIP_DSP_SHARED)
+ #if defined(_WIN32)
+  #if defined(KLIP_DSP_BUILDING)
+   #define KLIP_API __declspec(dllexport)
+  #else
+   #define KLIP_API __declspec(dllimport)
+  #endif
+ #else
+  #define KLIP_API __attribute__((visibility("default")))
+ #endif
+#else
+ #define KLIP_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KLIP_API_VERSION 1
+
+typedef struct klip_processor klip_processor;
+
+typedef enum klip_status {
+    KLIP_OK = 0,
+    KLIP_ERROR_INVALID_ARGUMENT = 1,
+    KLIP_ERROR_OUT_OF_MEMORY = 2,
+    KLIP_ERROR_UNKNOWN_PARAMETER = 3
+} klip_status;
+
+/* Values as in the plugin. Choice parameters take their index as a float. */
+typedef enum klip_parameter {
+    KLIP_PARAM_THRESHOLD_DB = 0,  /* -24 .. 0 dB, default -12 */
+    KLIP_PARAM_CLIP_TYPE = 1,     /* 0 .. 11, same list as the plugin's Clip Type; 11 is the custom curve */
+    KLIP_PARAM_MS_MODE = 2,       /* 0 mid, 1 side, 2 mid+side (default) */
+    KLIP_PARAM_KNEE_WIDTH = 3,    /* 0 .. 1, default 0.5 */
+    KLIP_PARAM_DC_CUTOFF = 4,     /* 2 .. 40 Hz, default 10 */
+    KLIP_PARAM_DITHER_BITS = 5,   /* 0 off (default), 16 or 24 */
+    KLIP_PARAM_NOISE_SHAPING = 6, /* 0 flat, 1 highpass, 2 E-weighted, 3 F-weighted */
+    KLIP_PARAM_EXACT_CURVES = 7   /* 0 lookup tables (default), 1 exact exp/log */
+} klip_parameter;
+
+typedef struct klip_config {
+    size_t struct_size;   /* sizeof(klip_config) */
+    double sample_rate;
+    int max_block_size;   /* frames; longer calls are fine, interleaved ones are split */
+} klip_config;
+
+KLIP_API int klip_get_api_version(void);
+
+/* Fills in the defaults: 44.1 kHz, 512 frames. */
+KLIP_API void klip_config_init(klip_config* config);
+
+KLIP_API klip_status klip_create(const klip_config* config, klip_processor** processor);
+KLIP_API void klip_destroy(klip_processor* processor);
+
+KLIP_API klip_status klip_set_parameter(klip_processor* processor, klip_parameter parameter, float value);
+KLIP_API klip_status klip_get_parameter(const klip_processor* processor, klip_parameter parameter, float* value);
+
+/* Control points of the custom curve as x, y pairs: output against input for
+   the positive half, both relative to the threshold (x 0..4, y 0..2). The
+   curve is odd-symmetric, monotone between the points and holds its last
+   value. Points snap to a 1/32 grid, at most 16 are used, and (0, 0) is always
+   the first. This call compiles the curve, so it allocates. */
+KLIP_API klip_status klip_set_custom_curve(klip_processor* processor, const float* points, int num_points);
+
+/* Clears the filter, transition and dither state. */
+KLIP_API void klip_reset(klip_processor* processor);
+
+KLIP_API klip_status klip_process_planar(klip_processor* processor, float* const* channels, int num_channels, int num_frames);
+KLIP_API klip_status klip_process_interleaved(klip_processor* processor, float* frames, int num_channels, int num_frames);
+
+/* Always 0: the library runs at the host rate, without oversampling or the spectral engine. */
+KLIP_API int klip_get_latency(const klip_processor* processor);
+
+/* Name of the kernel variant picked for this CPU, e.g. "avx2". */
+KLIP_API const char* klip_get_kernel_name(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* KLIP_DSP_H */
@@ -0,0 +1,70 @@
+/*
+  ==============================================================================
+
+    LatencyProbe.cpp
+
+  ==============================================================================
+*/
+
+#include "LatencyProbe.h"
+#include <algorithm>
+#include <cmath>
+
+void LatencyProbe::process(float* const* channels, int numInputChannels, int numOutputChannels, int numSamples, double sampleRate) {
+    if (state == Idle) {
+        if (! requested.load())
+            return;
+
+        state = ListeningToNoise;
+        position = 0;
+        noisePeak = 0.0f;
+    }
+
+    const int noiseSamples = static_cast<int>(noiseFloorSeconds * sampleRate);
+    const int timeoutSamples = static_cast<int>(timeoutSeconds * sampleRate);
+
+    for (int i = 0; i < numSamples; ++i) {
+        float input = 0.0f;
+        for (int channel = 0; channel < numInputChannels; ++channel)
+            input = std::max(input, std::abs(channels[channel][i]));
+
+        float output = 0.0f;
+        switch (state) {
+        case ListeningToNoise:
+            noisePeak = std::max(noisePeak, input);
+            if (++position >= noiseSamples) {
+                state = Emitting;
+                position = 0;
+            }
+            break;
+
+        case Emitting:
+            // The impulse is this output sample: counting starts here
+            output = impulseLevel;
+            state = WaitingForImpulse;
+            position = 0;
+            break;
+
+        case WaitingForImpulse:
+            ++position;
+            if (input > std::max(minimumDetectionLevel, 4.0f * noisePeak)) {
+                result.store(position);
+                state = Idle;
+            }
+            else if (position >= timeoutSamples) {
+                result.store(timedOut);
+                state = Idle;
+            }
+            break;
+
+        case Idle:
+            break;
+        }
+
+        for (int channel = 0; channel < numOutputChannels; ++channel)
+            channels[channel][i] = output;
+    }
+
+    if (state == Idle)
+        requested.store(false);
+}
@@ -0,0 +1,52 @@
+/*
+  ==============================================================================
+
+    LatencyProbe.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+
+// Round-trip latency through a physical loopback (output cabled to input).
+// While it runs it owns the audio: it listens to the input for a moment to
+// learn the noise floor, sends one impulse to every output channel, and counts
+// samples until the input rises clearly above that floor. The count covers
+// both device buffers, the converters and their filters: what a performer
+// going through Klip actually hears.
+//
+// start() and the getters are for any thread; process() is the audio thread
+// and neither locks nor allocates.
+class LatencyProbe {
+public:
+    static constexpr int notMeasured = -1;
+    static constexpr int timedOut = -2;
+
+    static constexpr double noiseFloorSeconds = 0.1;
+    static constexpr double timeoutSeconds = 1.0;
+    static constexpr float impulseLevel = 0.7f;
+    static constexpr float minimumDetectionLevel = 0.02f; // about -34 dBFS
+
+    // requested stays set until process() has finished the measurement, so it
+    // alone tells every thread whether one is pending or under way.
+    void start() { requested.store(true); }
+    bool isRunning() const { return requested.load(); }
+
+    // In place: channels hold the input on entry and the probe signal on return.
+    void process(float* const* channels, int numInputChannels, int numOutputChannels, int numSamples, double sampleRate);
+
+    // Samples of the last measurement, or notMeasured / timedOut
+    int getResult() const { return result.load(); }
+
+private:
+    enum State { Idle, ListeningToNoise, Emitting, WaitingForImpulse };
+
+    std::atomic<bool> requested { false }; // cleared by the audio thread once back to Idle
+    std::atomic<int> result { notMeasured };
+
+    // Audio thread only
+    State state = Idle;
+    int position = 0; // samples in the current state
+    float noisePeak = 0.0f;
+};
@@ -0,0 +1,225 @@
+/*
+  ==============================================================================
+
+    LiveMode.cpp
+
+  ==============================================================================
+*/
+
+#include "LiveMode.h"
+#include "PluginProcessor.h"
+
+#if defined (JucePlugin_Build_Standalone) && JucePlugin_Build_Standalone
+ #include <juce_audio_plugin_client/Standalone/juce_StandaloneFilterWindow.h>
+ #define KLIP_STANDALONE_HOLDER 1
+#else
+ #define KLIP_STANDALONE_HOLDER 0
+#endif
+
+#if JUCE_LINUX || JUCE_BSD
+ #include <pthread.h>
+ #include <sched.h>
+#endif
+
+namespace {
+   #if KLIP_STANDALONE_HOLDER
+    juce::StandalonePluginHolder* getHolder(const KlipAudioProcessor& processor) {
+        if (processor.wrapperType != juce::AudioProcessor::wrapperType_Standalone)
+            return nullptr;
+        return juce::StandalonePluginHolder::getInstance();
+    }
+   #endif
+}
+
+LiveMode::LiveMode(KlipAudioProcessor& p) : processor(p) {
+}
+
+LiveMode::~LiveMode() {
+    setEnabled(false);
+}
+
+juce::AudioDeviceManager* LiveMode::getDeviceManager() const {
+   #if KLIP_STANDALONE_HOLDER
+    if (auto* holder = getHolder(processor))
+        return &holder->deviceManager;
+   #endif
+    return nullptr;
+}
+
+void LiveMode::setBufferSize(int bufferSize) {
+    auto* deviceManager = getDeviceManager();
+    auto setup = deviceManager->getAudioDeviceSetup();
+    if (setup.bufferSize == bufferSize)
+        return;
+
+    setup.bufferSize = bufferSize;
+    deviceManager->setAudioDeviceSetup(setup, true);
+
+    // Reopening the device may restart its xrun counter
+    lastDeviceXRuns = juce::jmax(0, getDeviceXRuns());
+}
+
+int LiveMode::getDeviceXRuns() const {
+    auto* deviceManager = getDeviceManager();
+    auto* device = deviceManager != nullptr ? deviceManager->getCurrentAudioDevice() : nullptr;
+    return device != nullptr ? device->getXRunCount() : -1;
+}
+
+void LiveMode::setEnabled(bool shouldBeEnabled) {
+    if (shouldBeEnabled == enabled || ! isAvailable())
+        return;
+
+    enabled = shouldBeEnabled;
+    processor.setLiveMode(enabled);
+    auto* device = getDeviceManager()->getCurrentAudioDevice();
+
+    if (! enabled) {
+        searching = false;
+        if (device != nullptr && originalBufferSize > 0)
+            setBufferSize(originalBufferSize);
+        originalBufferSize = 0;
+        return;
+    }
+
+    startTimerHz(4);
+    if (device == nullptr)
+        return;
+
+    originalBufferSize = device->getCurrentBufferSizeSamples();
+    xrunsSeen = 0;
+    lastDeviceXRuns = juce::jmax(0, getDeviceXRuns());
+
+    // Without an xrun count there is nothing to judge stability by: start safe
+    const int smallest = getDeviceXRuns() < 0 ? safeBufferSize : minBufferSize;
+    candidateSizes.clear();
+    for (int size : device->getAvailableBufferSizes())
+        if (size >= smallest)
+            candidateSizes.addIfNotAlreadyThere(size);
+    candidateSizes.sort();
+
+    if (candidateSizes.isEmpty())
+        return;
+
+    candidateIndex = 0;
+    setBufferSize(candidateSizes.getFirst());
+    searching = getDeviceXRuns() >= 0;
+    candidateStart = juce::Time::getMillisecondCounterHiRes();
+    candidateXRuns = xrunsSeen;
+}
+
+void LiveMode::startLatencyMeasurement() {
+   #if KLIP_STANDALONE_HOLDER
+    if (auto* holder = getHolder(processor)) {
+        auto& muteInput = holder->getMuteInputValue();
+        if (static_cast<bool>(muteInput.getValue())) {
+            muteInput = false;
+            restoreInputMute = true;
+        }
+    }
+   #endif
+
+    processor.getLatencyProbe().start();
+    startTimerHz(4);
+}
+
+void LiveMode::timerCallback() {
+    // Device xruns, across counter restarts
+    const int deviceXRuns = getDeviceXRuns();
+    if (deviceXRuns >= 0) {
+        xrunsSeen += deviceXRuns >= lastDeviceXRuns ? deviceXRuns - lastDeviceXRuns : deviceXRuns;
+        lastDeviceXRuns = deviceXRuns;
+    }
+
+    if (searching) {
+        if (xrunsSeen > candidateXRuns) {
+            // Not stable: one size up, or stay at the largest
+            if (candidateIndex + 1 < candidateSizes.size()) {
+                setBufferSize(candidateSizes[++candidateIndex]);
+                candidateStart = juce::Time::getMillisecondCounterHiRes();
+                candidateXRuns = xrunsSeen;
+            }
+            else
+                searching = false;
+        }
+        else if (juce::Time::getMillisecondCounterHiRes() - candidateStart >= settleSeconds * 1000.0)
+            searching = false;
+    }
+
+    if (restoreInputMute && ! processor.getLatencyProbe().isRunning()) {
+       #if KLIP_STANDALONE_HOLDER
+        if (auto* holder = getHolder(processor))
+            holder->getMuteInputValue() = true;
+       #endif
+        restoreInputMute = false;
+    }
+
+    if (! enabled && ! restoreInputMute)
+        stopTimer();
+}
+
+LiveMode::Status LiveMode::getStatus() const {
+    Status status;
+    status.enabled = enabled;
+    status.searching = searching;
+    status.roundTrip = processor.getLatencyProbe().getResult();
+    status.measuring = processor.getLatencyProbe().isRunning();
+    status.xruns = getDeviceXRuns() >= 0 ? xrunsSeen : -1;
+    status.priority = processor.getAudioThreadPriority();
+    status.latencyFeatureBypassed = processor.isLatencyFeatureBypassed();
+
+    auto* deviceManager = getDeviceManager();
+    if (auto* device = deviceManager != nullptr ? deviceManager->getCurrentAudioDevice() : nullptr) {
+        status.bufferSize = device->getCurrentBufferSizeSamples();
+        status.sampleRate = device->getCurrentSampleRate();
+        status.deviceLatency = device->getInputLatencyInSamples() + device->getOutputLatencyInSamples();
+    }
+
+    return status;
+}
+
+juce::String LiveMode::describe(const Status& status) {
+    if (status.sampleRate <= 0.0)
+        return "No audio device";
+
+    auto toMillis = [&](int samples) { return juce::String(1000.0 * samples / status.sampleRate, 1) + " ms"; };
+
+    juce::String text;
+    text << status.bufferSize << " smp @ " << juce::String(status.sampleRate / 1000.0, 1) << " kHz"
+         << (status.searching ? " (searching)" : "")
+         << " | device " << toMillis(status.deviceLatency)
+         << " | round trip ";
+
+    if (status.measuring)
+        text << "measuring...";
+    else if (status.roundTrip >= 0)
+        text << toMillis(status.roundTrip);
+    else
+        text << (status.roundTrip == LatencyProbe::timedOut ? "no signal" : "-");
+
+    text << " | xruns " << (status.xruns >= 0 ? juce::String(status.xruns) : juce::String("n/a"));
+
+    switch (status.priority) {
+    case Priority::Promoted:
+    case Priority::AlreadyRealtime: text << " | RT"; break;
+    case Priority::Denied:          text << " | RT denied"; break;
+    case Priority::NotRequested:
+    case Priority::Unsupported:     break;
+    }
+
+    return text;
+}
+
+LiveMode::Priority LiveMode::promoteCurrentThread() {
+   #if JUCE_LINUX || JUCE_BSD
+    int policy = 0;
+    sched_param parameters {};
+    if (pthread_getschedparam(pthread_self(), &policy, &parameters) == 0 && (policy == SCHED_FIFO || policy == SCHED_RR))
+        return Priority::AlreadyRealtime;
+
+    // JACK's default level for its own process thread
+    parameters.sched_priority = juce::jmin(70, sched_get_priority_max(SCHED_FIFO));
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters) == 0 ? Priority::Promoted : Priority::Denied;
+   #else
+    return Priority::Unsupported;
+   #endif
+}
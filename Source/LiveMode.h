@@ -0,0 +1,92 @@
+/*
+  ==============================================================================
+
+    LiveMode.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+
+class KlipAudioProcessor;
+
+// Live mode for the standalone app (broadcast boxes on ALSA/JACK). Enabling it
+// - switches the processor to its zero-latency path: host-rate clipping without
+//   the oversampling delay compensation, spectral engine and transient lookahead
+//   bypassed (the editor flags it when selected);
+// - asks for SCHED_FIFO on the audio thread (Linux; JACK clients already have it);
+// - looks for the smallest stable buffer size: starting from the smallest the
+//   device offers, each size runs for settleSeconds and the next one up is tried
+//   as soon as the device reports an xrun. Devices that don't count xruns start
+//   at safeBufferSize instead.
+// Disabling it restores the buffer size and the processor's normal path.
+//
+// Message thread only. Outside the standalone app isAvailable() is false and
+// nothing here does anything.
+class LiveMode : private juce::Timer {
+public:
+    static constexpr double settleSeconds = 3.0;
+    static constexpr int minBufferSize = 16;
+    static constexpr int safeBufferSize = 64;
+
+    enum class Priority {
+        NotRequested,
+        Promoted,        // SCHED_FIFO granted
+        AlreadyRealtime, // the driver's thread was realtime already (JACK)
+        Denied,          // no rtprio allowance (see /etc/security/limits.conf)
+        Unsupported      // other platforms: their drivers pick the thread class
+    };
+
+    struct Status {
+        bool enabled = false;
+        bool searching = false;     // still looking for the smallest stable size
+        int bufferSize = 0;
+        double sampleRate = 0.0;
+        int deviceLatency = 0;      // input + output, as the driver reports it (samples)
+        int roundTrip = -1;         // measured, see LatencyProbe; -1 none, -2 timed out
+        bool measuring = false;
+        int xruns = -1;             // since live mode was enabled; -1 if the device doesn't count them
+        Priority priority = Priority::NotRequested;
+        bool latencyFeatureBypassed = false;
+    };
+
+    explicit LiveMode(KlipAudioProcessor& processor);
+    ~LiveMode() override;
+
+    bool isAvailable() const { return getDeviceManager() != nullptr; }
+
+    void setEnabled(bool shouldBeEnabled);
+    bool isEnabled() const { return enabled; }
+
+    // Needs output cabled to input; the input is unmuted while it runs.
+    void startLatencyMeasurement();
+
+    Status getStatus() const;
+    static juce::String describe(const Status& status);
+
+    // Audio thread, once per thread
+    static Priority promoteCurrentThread();
+
+private:
+    void timerCallback() override;
+    juce::AudioDeviceManager* getDeviceManager() const;
+    void setBufferSize(int bufferSize);
+    int getDeviceXRuns() const;
+
+    KlipAudioProcessor& processor;
+    bool enabled = false;
+    int originalBufferSize = 0;
+
+    juce::Array<int> candidateSizes; // ascending, from the current one up
+    int candidateIndex = 0;
+    double candidateStart = 0.0;
+    int candidateXRuns = 0;
+    bool searching = false;
+
+    int xrunsSeen = 0;       // since enabled, summed across device restarts
+    int lastDeviceXRuns = 0;
+    bool restoreInputMute = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(LiveMode)
+};
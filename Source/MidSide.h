@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    MidSide.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Stereo <-> mid/side conversions around the clipper, in place on the caller's
+// channels: left carries mid and right carries side while the paths run.
+// mid = (L + R) / 2 and side = (L - R) / 2, so decoding is a plain sum and
+// difference. The Mid and Side modes clip one path and rebuild the other
+// channel from it: the discarded component is dropped, as it always was.
+namespace MidSide {
+
+// Values match the msProcessing parameter choices
+enum Mode {
+    Mid,
+    Side,
+    Both
+};
+
+inline int getNumPaths(Mode mode) { return mode == Both ? 2 : 1; }
+
+inline void encode(Mode mode, float* left, float* right, int numSamples)
+{
+    switch (mode) {
+    case Mid:
+        for (int sample = 0; sample < numSamples; ++sample)
+            left[sample] = 0.5f * (left[sample] + right[sample]);
+        break;
+    case Side:
+        for (int sample = 0; sample < numSamples; ++sample)
+            left[sample] = 0.5f * (left[sample] - right[sample]);
+        break;
+    case Both:
+        for (int sample = 0; sample < numSamples; ++sample) {
+            const float mid = 0.5f * (left[sample] + right[sample]);
+            const float side = 0.5f * (left[sample] - right[sample]);
+            left[sample] = mid;
+            right[sample] = side;
+        }
+        break;
+    }
+}
+
+inline void decode(Mode mode, float* left, float* right, int numSamples)
+{
+    switch (mode) {
+    case Mid:
+        for (int sample = 0; sample < numSamples; ++sample)
+            right[sample] = left[sample];
+        break;
+    case Side:
+        for (int sample = 0; sample < numSamples; ++sample)
+            right[sample] = -left[sample];
+        break;
+    case Both:
+        for (int sample = 0; sample < numSamples; ++sample) {
+            const float mid = left[sample];
+            const float side = right[sample];
+            left[sample] = mid + side;
+            right[sample] = mid - side;
+        }
+        break;
+    }
+}
+
+// The conversions as StagePipeline stages, for a mode fixed at compile time
+template <Mode mode>
+struct EncodeStage {
+    template <typename Context>
+    static void process(Context&, float* const* channels, int, int numSamples) { encode(mode, channels[0], channels[1], numSamples); }
+};
+
+template <Mode mode>
+struct DecodeStage {
+    template <typename Context>
+    static void process(Context&, float* const* channels, int, int numSamples) { decode(mode, channels[0], channels[1], numSamples); }
+};
+
+} // namespace MidSide
@@ -0,0 +1,109 @@
+/*
+  ==============================================================================
+
+    MultiChannelFilter.cpp
+
+  ==============================================================================
+*/
+
+#include "MultiChannelFilter.h"
+
+void MultiChannelFilter::setup(Type newType, double newSampleRate, float newCutoff, float newQ) {
+    type = newType;
+    sampleRate = newSampleRate;
+    cutoff = newCutoff;
+    q = std::max(0.05f, newQ);
+    updateCoefficients();
+}
+
+void MultiChannelFilter::setCutoff(float newCutoff) {
+    if (newCutoff != cutoff) {
+        cutoff = newCutoff;
+        updateCoefficients();
+    }
+}
+
+void MultiChannelFilter::reset() {
+    std::fill(std::begin(state), std::end(state), 0.0f);
+}
+
+void MultiChannelFilter::updateCoefficients() {
+    // Prewarp, keeping the cutoff just under Nyquist
+    const double nyquistLimit = 0.49 * sampleRate;
+    const double frequency = std::clamp(static_cast<double>(cutoff), 1.0e-3, nyquistLimit);
+    const float g = static_cast<float>(std::tan(3.14159265358979323846 * frequency / sampleRate));
+
+    for (int lane = 0; lane < maxChannels; ++lane) {
+        if (isOnePole()) {
+            onePole.g[lane] = g / (1.0f + g);
+            // hp = x - lp, allpass = lp - hp
+            onePole.inputGain[lane] = type == OnePoleLowPass ? 0.0f : (type == OnePoleHighPass ? 1.0f : -1.0f);
+            onePole.lowPassGain[lane] = type == OnePoleLowPass ? 1.0f : (type == OnePoleHighPass ? -1.0f : 2.0f);
+        }
+        else {
+            const float k = 1.0f / q;
+            svf.a1[lane] = 1.0f / (1.0f + g * (g + k));
+            svf.a2[lane] = g * svf.a1[lane];
+            svf.a3[lane] = g * svf.a2[lane];
+
+            // y = m0 * x + m1 * band + m2 * low
+            switch (type) {
+            case LowPass:  svf.m0[lane] = 0.0f; svf.m1[lane] = 0.0f;      svf.m2[lane] = 1.0f;  break;
+            case HighPass: svf.m0[lane] = 1.0f; svf.m1[lane] = -k;        svf.m2[lane] = -1.0f; break;
+            case BandPass: svf.m0[lane] = 0.0f; svf.m1[lane] = 1.0f;      svf.m2[lane] = 0.0f;  break;
+            default:       svf.m0[lane] = 1.0f; svf.m1[lane] = -2.0f * k; svf.m2[lane] = 0.0f;  break;
+            }
+        }
+    }
+}
+
+void MultiChannelFilter::processBlock(float* const* channels, int numChannels, int numSamples) {
+    assert(numChannels <= maxChannels);
+    numChannels = std::min(numChannels, maxChannels);
+
+    // Lanes without a channel stay at zero and so does their state
+    constexpr int chunkFrames = 64;
+    float frames[chunkFrames * maxChannels] = {};
+
+    for (int start = 0; start < numSamples; start += chunkFrames) {
+        const int count = std::min(chunkFrames, numSamples - start);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* source = channels[channel] + start;
+            for (int i = 0; i < count; ++i)
+                frames[i * maxChannels + channel] = source[i];
+        }
+
+        if (isOnePole())
+            kernels->onePole(frames, count, onePole, state);
+        else
+            kernels->svf(frames, count, svf, state);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* dest = channels[channel] + start;
+            for (int i = 0; i < count; ++i)
+                dest[i] = frames[i * maxChannels + channel];
+        }
+    }
+}
+
+float MultiChannelFilter::processSample(int channel, float input) {
+    assert(channel >= 0 && channel < maxChannels);
+
+    if (isOnePole()) {
+        float& s = state[channel];
+        const float v = (input - s) * onePole.g[channel];
+        const float lp = v + s;
+        s = lp + v;
+        return onePole.inputGain[channel] * input + onePole.lowPassGain[channel] * lp;
+    }
+
+    float& ic1 = state[channel];
+    float& ic2 = state[maxChannels + channel];
+    const float v3 = input - ic2;
+    const float v1 = svf.a1[channel] * ic1 + svf.a2[channel] * v3;
+    const float v2 = ic2 + svf.a2[channel] * ic1 + svf.a3[channel] * v3;
+    ic1 = 2.0f * v1 - ic1;
+    ic2 = 2.0f * v2 - ic2;
+    return svf.m0[channel] * input + svf.m1[channel] * v1 + svf.m2[channel] * v2;
+}
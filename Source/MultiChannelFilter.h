@@ -0,0 +1,65 @@
+/*
+  ==============================================================================
+
+    MultiChannelFilter.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <cmath>
+#include "ClipKernels.h"
+
+// One filter for up to maxChannels channels, built on the TPT one-pole and
+// state-variable kernels in ClipKernels. Coefficients come from the real sample
+// rate (prewarped), so the cutoff is where it says at 44.1k, 192k or at the
+// oversampled rate.
+//
+// processBlock() interleaves the channels into the kernel lanes in small stack
+// chunks, no allocation. processSample() runs the same equations on one lane
+// for the per-sample callers; both share the state.
+class MultiChannelFilter {
+public:
+    static constexpr int maxChannels = ClipKernels::filterLanes;
+
+    enum Type {
+        OnePoleLowPass,
+        OnePoleHighPass,
+        OnePoleAllPass,
+        LowPass,
+        HighPass,
+        BandPass,
+        AllPass
+    };
+
+    MultiChannelFilter() = default;
+    ~MultiChannelFilter() = default;
+
+    // Same settings on every channel. Doesn't clear the state, so it can follow
+    // parameter changes; call reset() for a fresh start.
+    void setup(Type newType, double newSampleRate, float newCutoff, float newQ = 0.70710678118654752f);
+    void setCutoff(float newCutoff);
+    float getCutoff() const { return cutoff; }
+
+    void reset();
+
+    void processBlock(float* const* channels, int numChannels, int numSamples);
+    float processSample(int channel, float input);
+
+private:
+    void updateCoefficients();
+    bool isOnePole() const { return type <= OnePoleAllPass; }
+
+    const ClipKernels::Table* kernels = &ClipKernels::get();
+    ClipKernels::OnePoleCoefficients onePole {};
+    ClipKernels::SvfCoefficients svf {};
+    float state[2 * maxChannels] = {};
+
+    Type type = OnePoleHighPass;
+    double sampleRate = 44100.0;
+    float cutoff = 20.0f;
+    float q = 0.70710678f;
+};
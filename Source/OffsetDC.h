@@ -9,29 +9,44 @@
 */
 
 #pragma once
-#include <cmath>
-#ifndef M_PI
-#define M_PI 3.14159265358979323846 
-#endif
+#include "MultiChannelFilter.h"
 
+// DC blocker in front of the clip curves: a TPT one-pole high-pass on up to
+// MultiChannelFilter::maxChannels channels. The cutoff used to be a fixed
+// 40 Hz, which takes audible weight off the low end; it's now settable and
+// defaults to 10 Hz.
 class OffsetDCRemover {
 public:
-    OffsetDCRemover() : x_prev(0.0f), y_prev(0.0f), alpha(0.0f) {}
+    static constexpr float defaultCutoff = 10.0f; // Hz
+    static constexpr float minCutoff = 2.0f;
+    static constexpr float maxCutoff = 40.0f;
 
-    void setSampleRate(float sampleRate) {
-        const float cutoffFrequency = 40.0f; // Frequenza di taglio per il filtro
-        float RC = 1.0f / (cutoffFrequency * 2.0f * M_PI);
-        alpha = RC / (RC + 1.0f / sampleRate);
+    OffsetDCRemover() {
+        filter.setup(MultiChannelFilter::OnePoleHighPass, sampleRate, defaultCutoff);
+    }
+
+    void setSampleRate(float newSampleRate) {
+        sampleRate = newSampleRate;
+        filter.setup(MultiChannelFilter::OnePoleHighPass, sampleRate, filter.getCutoff());
+    }
+
+    void setCutoff(float cutoffFrequency) {
+        filter.setCutoff(std::clamp(cutoffFrequency, minCutoff, maxCutoff));
     }
 
     float processSample(float x) {
-        float y = alpha * (y_prev + x - x_prev);
-        x_prev = x;
-        y_prev = y;
-        return y;
+        return filter.processSample(0, x);
+    }
+
+    void reset() {
+        filter.reset();
+    }
+
+    void processBlock(float* const* channels, int numChannels, int numSamples) {
+        filter.processBlock(channels, numChannels, numSamples);
     }
 
 private:
-    float x_prev, y_prev;
-    float alpha;
-};
\ No newline at end of file
+    MultiChannelFilter filter;
+    float sampleRate = 44100.0f;
+};
@@ -0,0 +1,123 @@
+/*
+  ==============================================================================
+
+    OutputDither.cpp
+
+  ==============================================================================
+*/
+
+#include "OutputDither.h"
+
+namespace {
+    // Error filter taps h[k] (noise transfer function 1 - H(z)), 44.1 kHz designs
+    const float eWeighted[] = { 2.033f, -2.165f, 1.959f, -1.590f, 0.6149f };
+    const float fWeighted[] = { 2.412f, -3.370f, 3.937f, -4.174f, 3.353f, -2.205f, 1.281f, -0.569f, 0.0847f };
+
+    // splitmix32 finaliser, spreads seed/channel/stream into unrelated states
+    uint32_t mix(uint32_t x) {
+        x += 0x9e3779b9u;
+        x = (x ^ (x >> 16)) * 0x85ebca6bu;
+        x = (x ^ (x >> 13)) * 0xc2b2ae35u;
+        return x ^ (x >> 16);
+    }
+}
+
+void OutputDither::setup(double newSampleRate, int newBits, Shape newShape) {
+    newBits = std::clamp(newBits, 8, 24);
+    if (newSampleRate != sampleRate || newBits != bits || newShape != shape || coefficients.scale == 0.0f) {
+        sampleRate = newSampleRate;
+        bits = newBits;
+        shape = newShape;
+        updateCoefficients();
+    }
+}
+
+void OutputDither::updateCoefficients() {
+    const float* taps = nullptr;
+    int order = 0;
+    static const float highpass[] = { 1.0f };
+
+    Shape effectiveShape = shape;
+    if (sampleRate > 50000.0 && (shape == EWeighted || shape == FWeighted))
+        effectiveShape = Highpass;
+
+    switch (effectiveShape) {
+    case Highpass:  taps = highpass;  order = 1; break;
+    case EWeighted: taps = eWeighted; order = static_cast<int>(std::size(eWeighted)); break;
+    case FWeighted: taps = fWeighted; order = static_cast<int>(std::size(fWeighted)); break;
+    default: break;
+    }
+
+    coefficients.order = order;
+    for (int k = 0; k < ClipKernels::maxNoiseShaperOrder; ++k)
+        coefficients.h[k] = k < order ? taps[k] : 0.0f;
+
+    coefficients.scale = static_cast<float>(1 << (bits - 1));
+    coefficients.inverseScale = 1.0f / coefficients.scale;
+    coefficients.minimum = -coefficients.scale;
+    coefficients.maximum = coefficients.scale - 1.0f;
+
+    // A different filter makes the old error history meaningless
+    std::fill(std::begin(errors), std::end(errors), 0.0f);
+}
+
+void OutputDither::setSeed(uint32_t newSeed) {
+    seed = newSeed;
+    reset();
+}
+
+void OutputDither::reset() {
+    for (int channel = 0; channel < maxChannels; ++channel) {
+        for (int stream = 0; stream < ClipKernels::ditherStreams; ++stream) {
+            const uint32_t state = mix(seed ^ mix(static_cast<uint32_t>(channel * ClipKernels::ditherStreams + stream)));
+            streams[channel][stream] = state != 0 ? state : 0x6d2b79f5u; // xorshift never leaves 0
+        }
+    }
+
+    std::fill(std::begin(errors), std::end(errors), 0.0f);
+    noisePosition = chunkFrames;
+}
+
+void OutputDither::refillNoise(int numChannels) {
+    for (int channel = 0; channel < numChannels; ++channel)
+        kernels->ditherNoise(noise[channel], chunkFrames, streams[channel]);
+
+    noisePosition = 0;
+}
+
+void OutputDither::processBlock(float* const* channels, int numChannels, int numSamples) {
+    assert(numChannels <= maxChannels);
+    numChannels = std::min(numChannels, maxChannels);
+
+    // Unused lanes stay silent: zero in, zero noise, zero error
+    float frames[chunkFrames * maxChannels] = {};
+    float noiseFrames[chunkFrames * maxChannels] = {};
+
+    for (int start = 0; start < numSamples;) {
+        if (noisePosition == chunkFrames)
+            refillNoise(numChannels);
+
+        // Stop at the end of the noise chunk, so the next call draws a fresh one
+        const int count = std::min(numSamples - start, chunkFrames - noisePosition);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* source = channels[channel] + start;
+            const float* channelNoise = noise[channel] + noisePosition;
+            for (int i = 0; i < count; ++i) {
+                frames[i * maxChannels + channel] = source[i];
+                noiseFrames[i * maxChannels + channel] = channelNoise[i];
+            }
+        }
+
+        kernels->quantise(frames, noiseFrames, count, coefficients, errors);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* dest = channels[channel] + start;
+            for (int i = 0; i < count; ++i)
+                dest[i] = frames[i * maxChannels + channel];
+        }
+
+        noisePosition += count;
+        start += count;
+    }
+}
@@ -0,0 +1,71 @@
+/*
+  ==============================================================================
+
+    OutputDither.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include "ClipKernels.h"
+
+// Optional last stage for 16/24-bit masters: TPDF dither and error-feedback
+// noise shaping, then quantisation to the target word length (the output stays
+// float, on the integer grid). Runs on the ditherNoise/quantise kernels, with the
+// channels side by side in the lanes like MultiChannelFilter.
+//
+// Each channel has its own ClipKernels::ditherStreams generators, seeded from
+// one seed, so the noise is independent between channels yet the output is
+// identical for identical input, whatever the block sizes.
+class OutputDither {
+public:
+    static constexpr int maxChannels = ClipKernels::filterLanes;
+    static constexpr uint32_t defaultSeed = 0x4b4c4950u;
+
+    // Noise shaping curves. The weighted ones are the classic 44.1 kHz designs
+    // (Lipshitz E-weighted 5 tap, Wannamaker F-weighted 9 tap); they are used up
+    // to 50 kHz and fall back to Highpass above, where they'd miss the ear's
+    // sensitive band.
+    enum Shape {
+        Flat,
+        Highpass,
+        EWeighted,
+        FWeighted
+    };
+
+    OutputDither() { reset(); }
+    ~OutputDither() = default;
+
+    // Cheap when nothing changed, so it can follow the parameters every block.
+    void setup(double newSampleRate, int newBits, Shape newShape);
+    int getBits() const { return bits; }
+
+    // Reseeds the generators and clears the shaping filter.
+    void setSeed(uint32_t newSeed);
+    void reset();
+
+    void processBlock(float* const* channels, int numChannels, int numSamples);
+
+private:
+    void updateCoefficients();
+    void refillNoise(int numChannels);
+
+    static constexpr int chunkFrames = 64; // a multiple of ClipKernels::ditherStreams
+
+    const ClipKernels::Table* kernels = &ClipKernels::get();
+    ClipKernels::QuantiserCoefficients coefficients {};
+    float errors[ClipKernels::maxNoiseShaperOrder * maxChannels] = {};
+
+    // Noise is drawn a chunk at a time per channel and used up across blocks
+    uint32_t seed = defaultSeed;
+    uint32_t streams[maxChannels][ClipKernels::ditherStreams] = {};
+    float noise[maxChannels][chunkFrames] = {};
+    int noisePosition = chunkFrames;
+
+    double sampleRate = 44100.0;
+    int bits = 24;
+    Shape shape = Flat;
+};
@@ -0,0 +1,96 @@
+/*
+  ==============================================================================
+
+    PeakSketch.cpp
+
+  ==============================================================================
+*/
+
+#include "PeakSketch.h"
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+namespace {
+    // Far below where doubles lose the small bins against the large ones
+    constexpr double maxWeight = 1.0e100;
+}
+
+void PeakSketch::prepare(double sampleRate, double halfLifeSeconds, double windowSeconds) {
+    windowLength = std::max(1, static_cast<int>(std::lround(sampleRate * windowSeconds)));
+    const double peaksPerHalfLife = halfLifeSeconds * sampleRate / windowLength;
+    weightGrowth = peaksPerHalfLife > 0.0 ? std::exp2(1.0 / peaksPerHalfLife) : 1.0;
+    reset();
+}
+
+void PeakSketch::reset() {
+    std::fill(std::begin(bins), std::end(bins), 0.0);
+    totalWeight = 0.0;
+    weight = 1.0;
+    windowPosition = 0;
+    windowPeak = 0.0f;
+}
+
+int PeakSketch::process(const float* const* paths, int numPaths, int numSamples) {
+    int completed = 0;
+
+    for (int start = 0; start < numSamples;) {
+        const int count = std::min(numSamples - start, windowLength - windowPosition);
+
+        float peak = windowPeak;
+        for (int path = 0; path < numPaths; ++path)
+            for (int i = start; i < start + count; ++i)
+                peak = std::max(peak, std::abs(paths[path][i]));
+
+        windowPeak = peak;
+        windowPosition += count;
+        start += count;
+
+        if (windowPosition == windowLength) {
+            addPeak(windowPeak);
+            windowPeak = 0.0f;
+            windowPosition = 0;
+            ++completed;
+        }
+    }
+
+    return completed;
+}
+
+void PeakSketch::addPeak(float peak) {
+    const float decibels = peak > 0.0f ? 20.0f * std::log10(peak) : minDecibels;
+    const int bin = std::clamp(static_cast<int>((decibels - minDecibels) / binDecibels), 0, numBins - 1);
+
+    bins[bin] += weight;
+    totalWeight += weight;
+    weight *= weightGrowth;
+
+    if (weight > maxWeight)
+        rescale();
+}
+
+void PeakSketch::rescale() {
+    for (auto& bin : bins)
+        bin /= weight;
+    totalWeight /= weight;
+    weight = 1.0;
+}
+
+float PeakSketch::getDecibelsExceededBy(double fraction) const {
+    if (totalWeight <= 0.0)
+        return minDecibels;
+
+    const double target = std::clamp(fraction, 0.0, 1.0) * totalWeight;
+    double above = 0.0;
+
+    for (int bin = numBins - 1; bin >= 0; --bin) {
+        if (bins[bin] > 0.0 && above + bins[bin] >= target) {
+            // Peaks taken as spread evenly across the bin
+            const double shareAbove = (target - above) / bins[bin];
+            return minDecibels + binDecibels * static_cast<float>(bin + 1 - shareAbove);
+        }
+        above += bins[bin];
+    }
+
+    return minDecibels;
+}
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    PeakSketch.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <cstdint>
+
+// Streaming quantile sketch of short-term peaks, for the auto threshold.
+//
+// The signal is cut into fixed windows of windowSeconds (independent of the
+// host's block size) and the largest absolute sample of each window, across
+// the paths, is one peak. Peaks go into a histogram of binDecibels-wide bins
+// from minDecibels to maxDecibels: fixed memory, O(1) per peak, and a query
+// walks the bins from the top. Levels are accurate to a fraction of a bin.
+//
+// With a half-life the sketch forgets: each new peak weighs a little more
+// than the previous one, so a peak's share halves every halfLifeSeconds of
+// audio; the bins are rescaled now and then to keep the weights finite. With
+// no half-life every peak counts the same, which is what an offline analysis
+// of a whole file wants.
+//
+// Not thread-safe: the audio thread (or the offline analysis) owns it.
+class PeakSketch {
+public:
+    static constexpr float minDecibels = -72.0f;
+    static constexpr float maxDecibels = 24.0f;
+    static constexpr float binDecibels = 0.25f;
+    static constexpr int numBins = static_cast<int>((maxDecibels - minDecibels) / binDecibels);
+    static constexpr double defaultWindowSeconds = 0.005;
+
+    PeakSketch() = default;
+    ~PeakSketch() = default;
+
+    // Clears the sketch. halfLifeSeconds <= 0 keeps every peak at full weight.
+    void prepare(double sampleRate, double halfLifeSeconds, double windowSeconds = defaultWindowSeconds);
+    void reset();
+
+    // Scans the block for peaks; returns how many windows it completed.
+    int process(const float* const* paths, int numPaths, int numSamples);
+    void addPeak(float peak);
+
+    // Peaks counted so far, decayed: the effective sample size of a query.
+    double getNumPeaks() const { return totalWeight / weight; }
+
+    // Level (dBFS) exceeded by `fraction` of the peaks, 0..1. minDecibels when
+    // the sketch is empty.
+    float getDecibelsExceededBy(double fraction) const;
+
+private:
+    void rescale();
+
+    double bins[numBins] = {};
+    double totalWeight = 0.0;
+    double weight = 1.0;       // of the next peak
+    double weightGrowth = 1.0; // per peak, from the half-life
+
+    int windowLength = 240;
+    int windowPosition = 0;
+    float windowPeak = 0.0f;
+};
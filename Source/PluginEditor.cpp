@@ -11,7 +11,7 @@
 
 //==============================================================================
 KlipAudioProcessorEditor::KlipAudioProcessorEditor(KlipAudioProcessor& p)
-    : AudioProcessorEditor(&p), audioProcessor(p), processor(p)
+    : AudioProcessorEditor(&p), curveEditor(p), spectrumAnalyzer(p), liveMode(p), audioProcessor(p), processor(p)
 {
     // ComboBox per selezionare il tipo di Clipping
     clipTypeComboBox.addItem("Soft Clip", 1);
@@ -19,7 +19,27 @@ KlipAudioProcessorEditor::KlipAudioProcessorEditor(KlipAudioProcessor& p)
     clipTypeComboBox.addItem("Linear Clip", 3);
     clipTypeComboBox.addItem("Exponential Clip", 4);
     clipTypeComboBox.addItem("Asymmetric Clip", 5);
+    clipTypeComboBox.addItem("Tanh", 6);
+    clipTypeComboBox.addItem("Arctan", 7);
+    clipTypeComboBox.addItem("Algebraic", 8);
+    clipTypeComboBox.addItem("Cubic Knee", 9);
+    clipTypeComboBox.addItem("Quintic Knee", 10);
+    clipTypeComboBox.addItem("Sine Fold", 11);
+    clipTypeComboBox.addItem("Custom", 12);
     addAndMakeVisible(&clipTypeComboBox);
+    addAndMakeVisible(&curveEditor);
+    addAndMakeVisible(&spectrumAnalyzer);
+
+    // Modalita' live (solo standalone): stato salvato con il plugin
+    liveModeButton.onClick = [this] {
+        liveMode.setEnabled(liveModeButton.getToggleState());
+        processor.getParameters().state.setProperty("liveMode", liveModeButton.getToggleState(), nullptr);
+    };
+    measureLatencyButton.setTooltip("Connect an output to an input with a cable first");
+    measureLatencyButton.onClick = [this] { liveMode.startLatencyMeasurement(); };
+    addChildComponent(&liveModeButton);
+    addChildComponent(&measureLatencyButton);
+    addChildComponent(&liveStatusLabel);
 
     // Rotary Slider per Threshold
     thresholdSlider.setSliderStyle(juce::Slider::Rotary);
@@ -27,16 +47,118 @@ KlipAudioProcessorEditor::KlipAudioProcessorEditor(KlipAudioProcessor& p)
     thresholdSlider.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
     addAndMakeVisible(&thresholdSlider);
 
+    // Soglia automatica: la percentuale di picchi da clippare, il valore in dB nel decibelLabel
+    addAndMakeVisible(&autoThresholdButton);
+    autoTargetSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    autoTargetSlider.setTextValueSuffix(" % peaks");
+    autoTargetSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 90, 20);
+    addAndMakeVisible(&autoTargetSlider);
+
+    // Mix dry/wet (clipping parallelo), il dry allineato alla latenza del wet
+    mixSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    mixSlider.setTextValueSuffix(" % wet");
+    mixSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 90, 20);
+    addAndMakeVisible(&mixSlider);
+
+    // Split transienti/sustain: curva e soglia (offset in dB) dei transienti, sensibilita' e lookahead
+    addAndMakeVisible(&transientSplitButton);
+    for (int item = 1; item <= clipTypeComboBox.getNumItems(); ++item)
+        transientClipTypeComboBox.addItem("Transients: " + clipTypeComboBox.getItemText(item - 1), item);
+    addAndMakeVisible(&transientClipTypeComboBox);
+    transientThresholdSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    transientThresholdSlider.setTextValueSuffix(" dB transients");
+    transientThresholdSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 110, 20);
+    addAndMakeVisible(&transientThresholdSlider);
+    transientSensitivitySlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    transientSensitivitySlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+    addAndMakeVisible(&transientSensitivitySlider);
+    transientLookaheadSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    transientLookaheadSlider.setTextValueSuffix(" ms lookahead");
+    transientLookaheadSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 110, 20);
+    addAndMakeVisible(&transientLookaheadSlider);
+
+    // Slider per la larghezza del ginocchio (curve Cubic/Quintic Knee)
+    kneeWidthSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    kneeWidthSlider.setRange(0.0, 1.0, 0.01);
+    kneeWidthSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+    addAndMakeVisible(&kneeWidthSlider);
+
+    // Slider per la frequenza di taglio del filtro DC
+    dcCutoffSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    dcCutoffSlider.setTextValueSuffix(" Hz");
+    dcCutoffSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 60, 20);
+    addAndMakeVisible(&dcCutoffSlider);
+
     // ComboBox per Mid/Side Processing
     msProcessingComboBox.addItem("Mid", 1);
     msProcessingComboBox.addItem("Side", 2);
     msProcessingComboBox.addItem("Mid+Side", 3);
     addAndMakeVisible(&msProcessingComboBox);
 
+    // Motore di clipping: dominio del tempo o spettrale (STFT)
+    engineComboBox.addItem("Time Domain", 1);
+    engineComboBox.addItem("Spectral", 2);
+    addAndMakeVisible(&engineComboBox);
+
+    fftSizeComboBox.addItem("FFT 512", 1);
+    fftSizeComboBox.addItem("FFT 1024", 2);
+    fftSizeComboBox.addItem("FFT 2048", 3);
+    fftSizeComboBox.addItem("FFT 4096", 4);
+    addAndMakeVisible(&fftSizeComboBox);
+
+    fftOverlapComboBox.addItem("Overlap 2x", 1);
+    fftOverlapComboBox.addItem("Overlap 4x", 2);
+    fftOverlapComboBox.addItem("Overlap 8x", 3);
+    addAndMakeVisible(&fftOverlapComboBox);
+
+    // Dither finale per master a 16/24 bit
+    ditherDepthComboBox.addItem("Dither Off", 1);
+    ditherDepthComboBox.addItem("Dither 16 bit", 2);
+    ditherDepthComboBox.addItem("Dither 24 bit", 3);
+    addAndMakeVisible(&ditherDepthComboBox);
+
+    noiseShapingComboBox.addItem("Flat TPDF", 1);
+    noiseShapingComboBox.addItem("Highpass", 2);
+    noiseShapingComboBox.addItem("E-Weighted", 3);
+    noiseShapingComboBox.addItem("F-Weighted", 4);
+    addAndMakeVisible(&noiseShapingComboBox);
+
+    // Governor: riduce i costi quando la CPU non basta, livello corrente nel label
+    addAndMakeVisible(&governorButton);
+    governorBudgetSlider.setSliderStyle(juce::Slider::LinearHorizontal);
+    governorBudgetSlider.setTextValueSuffix(" % CPU");
+    governorBudgetSlider.setTextBoxStyle(juce::Slider::TextBoxRight, false, 80, 20);
+    addAndMakeVisible(&governorBudgetSlider);
+    qualityLabel.setColour(juce::Label::textColourId, juce::Colours::white);
+    addAndMakeVisible(&qualityLabel);
+
+    // Flight recorder: salva gli ultimi secondi su richiesta (o da solo dopo un glitch)
+    addAndMakeVisible(&flightRecorderButton);
+    saveCaptureButton.onClick = [this] { processor.getFlightRecorder().requestCapture(); };
+    addAndMakeVisible(&saveCaptureButton);
+
     // Inizializzazione degli Attachment
     clipTypeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "clipType", clipTypeComboBox);
     thresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "threshold", thresholdSlider);
+    kneeWidthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "kneeWidth", kneeWidthSlider);
+    dcCutoffAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "dcCutoff", dcCutoffSlider);
     msProcessingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "msProcessing", msProcessingComboBox);
+    engineAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "engine", engineComboBox);
+    fftSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "fftSize", fftSizeComboBox);
+    fftOverlapAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "fftOverlap", fftOverlapComboBox);
+    ditherDepthAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "ditherDepth", ditherDepthComboBox);
+    noiseShapingAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "noiseShaping", noiseShapingComboBox);
+    governorAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getParameters(), "governor", governorButton);
+    governorBudgetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "governorBudget", governorBudgetSlider);
+    flightRecorderAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getParameters(), "flightRecorder", flightRecorderButton);
+    autoThresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getParameters(), "autoThreshold", autoThresholdButton);
+    autoTargetAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "autoTarget", autoTargetSlider);
+    mixAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "mix", mixSlider);
+    transientSplitAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(audioProcessor.getParameters(), "transientSplit", transientSplitButton);
+    transientClipTypeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ComboBoxAttachment>(audioProcessor.getParameters(), "transientClipType", transientClipTypeComboBox);
+    transientThresholdAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "transientThreshold", transientThresholdSlider);
+    transientSensitivityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "transientSensitivity", transientSensitivitySlider);
+    transientLookaheadAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(audioProcessor.getParameters(), "transientLookahead", transientLookaheadSlider);
 
     // Inizializzazione decibelLabel
     decibelLabel.setFont(juce::Font(15.0f));
@@ -51,9 +173,31 @@ KlipAudioProcessorEditor::KlipAudioProcessorEditor(KlipAudioProcessor& p)
     mainFlexBox.items.add(juce::FlexItem(clipTypeComboBox).withFlex(1));
     mainFlexBox.items.add(juce::FlexItem(thresholdSlider).withFlex(2));
     mainFlexBox.items.add(juce::FlexItem(decibelLabel).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(autoThresholdButton).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(autoTargetSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(mixSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(transientSplitButton).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(transientClipTypeComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(transientThresholdSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(transientSensitivitySlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(transientLookaheadSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(kneeWidthSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(dcCutoffSlider).withFlex(1));
     mainFlexBox.items.add(juce::FlexItem(msProcessingComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(engineComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(fftSizeComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(fftOverlapComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(ditherDepthComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(noiseShapingComboBox).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(governorButton).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(governorBudgetSlider).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(qualityLabel).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(flightRecorderButton).withFlex(1));
+    mainFlexBox.items.add(juce::FlexItem(saveCaptureButton).withFlex(1));
 
-    setSize(800, 400);
+    setSize(800, 790);
+    timerCallback();
+    startTimerHz(10);
 }
 
 KlipAudioProcessorEditor::~KlipAudioProcessorEditor()
@@ -74,6 +218,65 @@ void KlipAudioProcessorEditor::paint(juce::Graphics& g)
 
 void KlipAudioProcessorEditor::resized()
 {
+    // Spettro in basso, editor della curva custom a destra, il FlexBox nel resto
+    auto bounds = getLocalBounds();
+    if (liveControlsVisible) {
+        auto strip = bounds.removeFromBottom(28).reduced(4, 2);
+        liveModeButton.setBounds(strip.removeFromLeft(110));
+        measureLatencyButton.setBounds(strip.removeFromLeft(130));
+        liveStatusLabel.setBounds(strip.withTrimmedLeft(8));
+    }
+    spectrumAnalyzer.setBounds(bounds.removeFromBottom(180).reduced(8, 4));
+    curveEditor.setBounds(bounds.removeFromRight(280).reduced(8, 32));
+
     // Utilizza il FlexBox per posizionare i componenti
-    mainFlexBox.performLayout(getLocalBounds());
+    mainFlexBox.performLayout(bounds);
+}
+
+void KlipAudioProcessorEditor::timerCallback()
+{
+    const auto level = processor.getQualityLevel();
+    qualityLabel.setText(juce::String("Quality: ") + QualityGovernor::getLevelName(level), juce::dontSendNotification);
+    qualityLabel.setColour(juce::Label::textColourId, level == QualityGovernor::Full ? juce::Colours::white : juce::Colours::orange);
+
+    auto& recorder = processor.getFlightRecorder();
+    saveCaptureButton.setEnabled(recorder.isEnabled());
+    const auto capture = recorder.getLastCaptureFile();
+    saveCaptureButton.setTooltip(capture == juce::File() ? juce::String() : "Last capture: " + capture.getFullPathName());
+
+    curveEditor.refresh();
+
+    // In automatico la manopola non conta: mostra la soglia che il plugin applica
+    const bool autoThreshold = autoThresholdButton.getToggleState();
+    thresholdSlider.setEnabled(! autoThreshold);
+    autoTargetSlider.setEnabled(autoThreshold);
+    const float thresholdDecibels = autoThreshold ? processor.getAutoThresholdDecibels()
+                                                  : processor.convertToDecibel(static_cast<float>(thresholdSlider.getValue()));
+    decibelLabel.setText((autoThreshold ? "Auto: " : "Threshold: ") + juce::String(thresholdDecibels, 1) + " dB", juce::dontSendNotification);
+
+    const bool transientSplit = transientSplitButton.getToggleState();
+    for (auto* component : std::initializer_list<juce::Component*> { &transientClipTypeComboBox, &transientThresholdSlider, &transientSensitivitySlider, &transientLookaheadSlider })
+        component->setEnabled(transientSplit);
+
+    if (liveMode.isAvailable() != liveControlsVisible) {
+        liveControlsVisible = liveMode.isAvailable();
+        for (auto* component : std::initializer_list<juce::Component*> { &liveModeButton, &measureLatencyButton, &liveStatusLabel })
+            component->setVisible(liveControlsVisible);
+
+        const bool wasLive = processor.getParameters().state.getProperty("liveMode", false);
+        liveModeButton.setToggleState(wasLive, juce::dontSendNotification);
+        liveMode.setEnabled(wasLive);
+        resized();
+    }
+
+    if (liveControlsVisible) {
+        const auto status = liveMode.getStatus();
+        auto text = LiveMode::describe(status);
+        if (status.latencyFeatureBypassed)
+            text << " | spectral engine / lookahead bypassed";
+        liveStatusLabel.setText(text, juce::dontSendNotification);
+        liveStatusLabel.setColour(juce::Label::textColourId, status.latencyFeatureBypassed || status.xruns > 0 || status.priority == LiveMode::Priority::Denied
+                                                              ? juce::Colours::orange : juce::Colours::white);
+        measureLatencyButton.setEnabled(! status.measuring);
+    }
 }
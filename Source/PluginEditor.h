@@ -10,11 +10,15 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "CurveEditor.h"
+#include "LiveMode.h"
+#include "SpectrumAnalyzer.h"
 
 //==============================================================================
 /**
 */
-class KlipAudioProcessorEditor  : public juce::AudioProcessorEditor
+class KlipAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                  private juce::Timer
 {
 public:
     KlipAudioProcessorEditor (KlipAudioProcessor&);
@@ -23,6 +27,7 @@ public:
     //==============================================================================
     void paint (juce::Graphics&) override;
     void resized() override;
+    void timerCallback() override;
     
 
 private:
@@ -30,14 +35,61 @@ private:
     juce::FlexBox mainFlexBox;
 
     juce::Slider thresholdSlider;
+    juce::Slider kneeWidthSlider;
+    juce::Slider dcCutoffSlider;
     juce::ComboBox msProcessingComboBox;
     juce::ComboBox clipTypeComboBox;
+    juce::ComboBox engineComboBox;
+    juce::ComboBox fftSizeComboBox;
+    juce::ComboBox fftOverlapComboBox;
+    juce::ComboBox ditherDepthComboBox;
+    juce::ComboBox noiseShapingComboBox;
 
     juce::Label decibelLabel;
+    juce::Label qualityLabel;
+    juce::ToggleButton governorButton { "Adaptive Quality" };
+    juce::Slider governorBudgetSlider;
+    juce::ToggleButton flightRecorderButton { "Flight Recorder" };
+    juce::ToggleButton autoThresholdButton { "Auto Threshold" };
+    juce::Slider autoTargetSlider;
+    juce::Slider mixSlider;
+    juce::ToggleButton transientSplitButton { "Transient Split" };
+    juce::ComboBox transientClipTypeComboBox;
+    juce::Slider transientThresholdSlider;
+    juce::Slider transientSensitivitySlider;
+    juce::Slider transientLookaheadSlider;
+    juce::TextButton saveCaptureButton { "Save Capture" };
+    CurveEditor curveEditor;
+    SpectrumAnalyzer spectrumAnalyzer;
+
+    // Standalone only: a strip along the bottom, shown once the app's device manager is found
+    LiveMode liveMode;
+    juce::ToggleButton liveModeButton { "Live Mode" };
+    juce::TextButton measureLatencyButton { "Measure Latency" };
+    juce::Label liveStatusLabel;
+    bool liveControlsVisible = false;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> thresholdAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> kneeWidthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> dcCutoffAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> clipTypeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> msProcessingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> engineAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> fftSizeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> fftOverlapAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> ditherDepthAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> noiseShapingAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> governorAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> governorBudgetAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> flightRecorderAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> autoThresholdAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> autoTargetAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> mixAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> transientSplitAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ComboBoxAttachment> transientClipTypeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> transientThresholdAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> transientSensitivityAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> transientLookaheadAttachment;
     
     KlipAudioProcessor& audioProcessor;
     KlipAudioProcessor& processor;
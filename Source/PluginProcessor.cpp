@@ -8,6 +8,19 @@
 
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "AllocationGuard.h"
+
+namespace {
+    std::unique_ptr<juce::dsp::Oversampling<float>> makeOversampler(const ProcessingQuality& quality)
+    {
+        const auto filterType = quality.linearPhaseFilters
+            ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+            : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+
+        // Integer latency so the value reported to the host is exact
+        return std::make_unique<juce::dsp::Oversampling<float>>(Clipping::maxPaths, quality.oversamplingOrder, filterType, true, true);
+    }
+}
 
 //==============================================================================
 KlipAudioProcessor::KlipAudioProcessor()
@@ -23,16 +36,69 @@ KlipAudioProcessor::KlipAudioProcessor()
     parameters(*this, nullptr, "parameters", juce::AudioProcessorValueTreeState::ParameterLayout{
     // Definizione dei parametri utilizzando AudioProcessorValueTreeState
     std::make_unique<juce::AudioParameterFloat>("threshold", "Threshold", juce::NormalisableRange<float>(0.0f, 1.0f), 0.5f),
-    std::make_unique<juce::AudioParameterChoice>("clipType", "Clip Type", juce::StringArray{ "Soft Clip", "Hard Clip", "Linear Clip", "Exponential Clip", "Asymmetric Clip" }, 0),
-    std::make_unique<juce::AudioParameterChoice>("msProcessing", "MS Processing", juce::StringArray{ "Mid", "Side", "Mid+Side" }, 2)
+    std::make_unique<juce::AudioParameterChoice>("clipType", "Clip Type", juce::StringArray{ "Soft Clip", "Hard Clip", "Linear Clip", "Exponential Clip", "Asymmetric Clip", "Tanh", "Arctan", "Algebraic", "Cubic Knee", "Quintic Knee", "Sine Fold", "Custom" }, 0),
+    std::make_unique<juce::AudioParameterChoice>("msProcessing", "MS Processing", juce::StringArray{ "Mid", "Side", "Mid+Side" }, 2),
+    std::make_unique<juce::AudioParameterFloat>("kneeWidth", "Knee Width", juce::NormalisableRange<float>(0.0f, 1.0f), 0.5f),
+    std::make_unique<juce::AudioParameterChoice>("engine", "Engine", juce::StringArray{ "Time Domain", "Spectral" }, 0),
+    std::make_unique<juce::AudioParameterChoice>("fftSize", "FFT Size", juce::StringArray{ "512", "1024", "2048", "4096" }, 2),
+    std::make_unique<juce::AudioParameterChoice>("fftOverlap", "FFT Overlap", juce::StringArray{ "2x", "4x", "8x" }, 1),
+    std::make_unique<juce::AudioParameterFloat>("dcCutoff", "DC Cutoff", juce::NormalisableRange<float>(OffsetDCRemover::minCutoff, OffsetDCRemover::maxCutoff, 0.1f, 0.5f), OffsetDCRemover::defaultCutoff),
+    std::make_unique<juce::AudioParameterBool>("governor", "Adaptive Quality", false),
+    std::make_unique<juce::AudioParameterFloat>("governorBudget", "CPU Budget", juce::NormalisableRange<float>(5.0f, 100.0f, 1.0f), 50.0f),
+    std::make_unique<juce::AudioParameterBool>("flightRecorder", "Flight Recorder", false),
+    std::make_unique<juce::AudioParameterChoice>("ditherDepth", "Dither", juce::StringArray{ "Off", "16 bit", "24 bit" }, 0),
+    std::make_unique<juce::AudioParameterChoice>("noiseShaping", "Noise Shaping", juce::StringArray{ "Flat", "Highpass", "E-Weighted", "F-Weighted" }, 0),
+    std::make_unique<juce::AudioParameterBool>("autoThreshold", "Auto Threshold", false),
+    std::make_unique<juce::AudioParameterFloat>("autoTarget", "Auto Target", juce::NormalisableRange<float>(0.01f, 10.0f, 0.01f, 0.3f), 0.1f),
+    std::make_unique<juce::AudioParameterBool>("transientSplit", "Transient Split", false),
+    std::make_unique<juce::AudioParameterChoice>("transientClipType", "Transient Clip Type", juce::StringArray{ "Soft Clip", "Hard Clip", "Linear Clip", "Exponential Clip", "Asymmetric Clip", "Tanh", "Arctan", "Algebraic", "Cubic Knee", "Quintic Knee", "Sine Fold", "Custom" }, 1),
+    std::make_unique<juce::AudioParameterFloat>("transientThreshold", "Transient Threshold", juce::NormalisableRange<float>(-12.0f, 12.0f, 0.1f), 0.0f),
+    std::make_unique<juce::AudioParameterFloat>("transientSensitivity", "Transient Sensitivity", juce::NormalisableRange<float>(0.0f, 1.0f), TransientDetector::defaultSensitivity),
+    std::make_unique<juce::AudioParameterFloat>("transientLookahead", "Transient Lookahead", juce::NormalisableRange<float>(0.0f, maxTransientLookaheadMs, 0.1f), 0.0f),
+    std::make_unique<juce::AudioParameterFloat>("mix", "Mix", juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), 100.0f)
         })
 #endif
 {
+    realtimeOversampler = makeOversampler(ProcessingQuality::realtime());
+    activeOversampler = realtimeOversampler.get();
+
+    thresholdParameter = parameters.getRawParameterValue("threshold");
+    msProcessingParameter = parameters.getRawParameterValue("msProcessing");
+    clipTypeParameter = parameters.getRawParameterValue("clipType");
+    kneeWidthParameter = parameters.getRawParameterValue("kneeWidth");
+    dcCutoffParameter = parameters.getRawParameterValue("dcCutoff");
+    engineParameter = parameters.getRawParameterValue("engine");
+    fftSizeParameter = parameters.getRawParameterValue("fftSize");
+    fftOverlapParameter = parameters.getRawParameterValue("fftOverlap");
+    governorParameter = parameters.getRawParameterValue("governor");
+    governorBudgetParameter = parameters.getRawParameterValue("governorBudget");
+    flightRecorderParameter = parameters.getRawParameterValue("flightRecorder");
+    ditherDepthParameter = parameters.getRawParameterValue("ditherDepth");
+    noiseShapingParameter = parameters.getRawParameterValue("noiseShaping");
+    autoThresholdParameter = parameters.getRawParameterValue("autoThreshold");
+    autoTargetParameter = parameters.getRawParameterValue("autoTarget");
+    transientSplitParameter = parameters.getRawParameterValue("transientSplit");
+    transientClipTypeParameter = parameters.getRawParameterValue("transientClipType");
+    transientThresholdParameter = parameters.getRawParameterValue("transientThreshold");
+    transientSensitivityParameter = parameters.getRawParameterValue("transientSensitivity");
+    transientLookaheadParameter = parameters.getRawParameterValue("transientLookahead");
+    mixParameter = parameters.getRawParameterValue("mix");
+
+    for (auto* parameter : AudioProcessor::getParameters()) {
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter)) {
+            recordedParameterIDs.add(ranged->paramID);
+            recordedParameterValues.push_back(parameters.getRawParameterValue(ranged->paramID));
+        }
+    }
 
+    flightRecorder.setCustomCurve(&customCurve);
+    dryDelay.setKeepsHistory(true);
+    backgroundBuilder->add(this);
 }
 
 KlipAudioProcessor::~KlipAudioProcessor()
 {
+    backgroundBuilder->remove(this);
 }
 //==============================================================================
 
@@ -43,58 +109,292 @@ float KlipAudioProcessor::convertToDecibel(float sliderValue)
 
 // =======================================Mid+Side PhaseControl=========================================================================
 
-void KlipAudioProcessor::initializeAllPassFilters()
+void KlipAudioProcessor::initializeAllPassFilters(double sampleRate)
 {
-    auto allPassCoefficients = juce::dsp::IIR::Coefficients<float>::makeAllPass(44100, 1000.0f);
-    leftAllPassFilter.coefficients = allPassCoefficients;
-    rightAllPassFilter.coefficients = allPassCoefficients;
+    allPassFilter.setup(MultiChannelFilter::AllPass, sampleRate, 1000.0f);
+    allPassFilter.reset();
 }
 
 std::pair<float, float> KlipAudioProcessor::combineMidSideWithPhaseControl(float mid, float side)
 {
     // Applica i filtri all-pass ai segnali mid e side
-    float left = leftAllPassFilter.processSample(mid + side);
-    float right = rightAllPassFilter.processSample(mid - side);
+    float left = allPassFilter.processSample(0, mid + side);
+    float right = allPassFilter.processSample(1, mid - side);
 
     return std::make_pair(left, right);
 }
 
-// ===========================mid/side processing===========================================
+// ===========================quality / oversampling===========================================
+
+juce::dsp::Oversampling<float>& KlipAudioProcessor::getOversampler(bool offline) const
+{
+    jassert(! offline || offlineOversampler != nullptr);
+    return offline ? *offlineOversampler : *realtimeOversampler;
+}
 
-void KlipAudioProcessor::processMid(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType) {
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-        float mid = 0.5f * (buffer.getSample(0, sample) + buffer.getSample(1, sample));
-        float midClipped = clipping.processSample(mid, clipType);
-        buffer.setSample(0, sample, midClipped);
-        buffer.setSample(1, sample, midClipped);
+void KlipAudioProcessor::prepareOfflineOversampler()
+{
+    // The audio thread only reaches it through offlineQualityReady, published after this
+    try {
+        if (offlineOversampler == nullptr)
+            offlineOversampler = makeOversampler(ProcessingQuality::offline());
+
+        // The dry delay may have been sized before this existed; one spectral frame covers it by far
+        jassert(juce::roundToInt(offlineOversampler->getLatencyInSamples()) <= SpectralClipper::getLatencyInSamples(SpectralClipper::maxFftOrder));
+        offlineOversampler->initProcessing(static_cast<size_t>(juce::jmax(1, preparedBlockSize)));
+    }
+    catch (const std::exception&) {
+        // Renders carry on in realtime quality; the next prepare tries again
+        offlineQualityReady.store(false, std::memory_order_release);
+        return;
     }
+
+    offlineQualityReady.store(true, std::memory_order_release);
 }
 
-void KlipAudioProcessor::processSide(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType) {
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-        float side = 0.5f * (buffer.getSample(0, sample) - buffer.getSample(1, sample));
-        float sideClipped = clipping.processSample(side, clipType);
+void KlipAudioProcessor::buildSpectralEngine()
+{
+    const juce::ScopedLock sl(subsystemLock);
+    if (spectralEngineReady.load(std::memory_order_relaxed))
+        return;
+
+    // The time-domain path carries on if it can't be allocated; the next request tries again
+    try {
+        spectralClipper.prepare();
+        spectralArena.layout([this](DspArena& a) { spectralClipper.allocateFrom(a); });
+    }
+    catch (const std::exception&) {
+        return;
+    }
+
+    spectralEngineReady.store(true, std::memory_order_release);
+}
 
-        buffer.setSample(0, sample, sideClipped);
-        buffer.setSample(1, sample, -sideClipped);
+void KlipAudioProcessor::buildRequestedSubsystems()
+{
+    if (spectralEngineRequested.load(std::memory_order_relaxed) && ! spectralEngineReady.load(std::memory_order_acquire))
+        buildSpectralEngine();
+}
+
+int KlipAudioProcessor::getLatencyForQuality(bool offline) const
+{
+    // Live mode: host-rate clipping, nothing buffered
+    if (liveModeActive && ! offline)
+        return 0;
+
+    // The spectral engine runs at the host rate, its latency is one FFT frame
+    if (spectralEngineActive)
+        return spectralClipper.getLatencyInSamples();
+
+    // Both time-domain paths hold the signal back by the same lookahead
+    return juce::roundToInt(getOversampler(offline).getLatencyInSamples()) + getTransientLookaheadSamples();
+}
+
+int KlipAudioProcessor::getExpectedLatency(bool offline) const
+{
+    // Same cases as getLatencyForQuality, in the order the audio thread picks them
+    if (liveModeRequested.load() && ! offline)
+        return 0;
+
+    offline = offline && offlineQualityReady.load(std::memory_order_acquire);
+
+    if (static_cast<int>(engineParameter->load()) == 1 && spectralEngineReady.load(std::memory_order_acquire))
+        return SpectralClipper::getLatencyInSamples(SpectralClipper::minFftOrder + static_cast<int>(fftSizeParameter->load()));
+
+    return juce::roundToInt(getOversampler(offline).getLatencyInSamples()) + getTransientLookaheadSamples();
+}
+
+int KlipAudioProcessor::getTransientLookaheadSamples() const
+{
+    if (transientSplitParameter->load() < 0.5f)
+        return 0;
+
+    return juce::roundToInt(transientLookaheadParameter->load() * 0.001 * currentSampleRate);
+}
+
+void KlipAudioProcessor::applyQuality(bool offline)
+{
+    const auto quality = offline ? ProcessingQuality::offline() : ProcessingQuality::realtime();
+
+    activeOversampler = &getOversampler(offline);
+    activeOversampler->reset();
+
+    clipping.setSampleRate(static_cast<float>(currentSampleRate * quality.getOversamplingFactor()));
+    clipping.setUseExactCurves(quality.exactCurves);
+    clipping.reset();
+
+    // Offline renders have no deadline and always take the oversampled path
+    hostRateClipping.setSampleRate(static_cast<float>(currentSampleRate));
+    hostRateClipping.setUseExactCurves(quality.exactCurves);
+    hostRateClipping.reset();
+    hostRateDelay.reset();
+    activeClipPath = targetClipPath = liveModeActive && ! offline ? ClipPath::HostRate : ClipPath::Oversampled;
+    clipPathTransitionPosition = 0;
+
+    offlineQualityActive = offline;
+}
+
+void KlipAudioProcessor::setNonRealtime(bool isNonRealtime) noexcept
+{
+    // First render: the offline oversampler is built right here, and the spectral engine
+    // if the session uses it, so the render thread never has to. Both swallow allocation
+    // failures (noexcept): the render then runs in realtime quality or the time domain.
+    if (isNonRealtime) {
+        if (! offlineQualityReady.load(std::memory_order_acquire))
+            prepareOfflineOversampler();
+        if (static_cast<int>(engineParameter->load()) == 1)
+            buildSpectralEngine();
     }
+
+    AudioProcessor::setNonRealtime(isNonRealtime);
+
+    // Report the new latency straight away so the host can compensate the bounce;
+    // the audio thread swaps the settings on its next block.
+    setLatencySamples(getExpectedLatency(isNonRealtime));
 }
 
-void KlipAudioProcessor::processMidSide(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType) {
-    for (int sample = 0; sample < buffer.getNumSamples(); ++sample) {
-        float mid = 0.5f * (buffer.getSample(0, sample) + buffer.getSample(1, sample));
-        float side = 0.5f * (buffer.getSample(0, sample) - buffer.getSample(1, sample));
+void KlipAudioProcessor::clipPaths(float* const* paths, int numPaths, int numSamples, Clipping::ClipType clipType) {
+    if (spectralEngineActive) {
+        spectralClipper.processBlock(paths, numPaths, numSamples);
+        return;
+    }
+
+    if (activeClipPath == targetClipPath) {
+        runClipPath(activeClipPath, paths, numPaths, numSamples, clipType);
+        return;
+    }
+
+    // Switching: the incoming path runs on a copy, warming up first, then fading in
+    jassert(numSamples <= maxSubBlockSize);
+    for (int path = 0; path < numPaths; ++path)
+        juce::FloatVectorOperations::copy(clipPathScratch[path], paths[path], numSamples);
+
+    runClipPath(activeClipPath, paths, numPaths, numSamples, clipType);
+    runClipPath(targetClipPath, clipPathScratch, numPaths, numSamples, clipType);
+
+    const int fadePosition = clipPathTransitionPosition - clipPathWarmupSamples;
+    const int fadeStart = juce::jlimit(0, numSamples, -fadePosition);
+    if (fadeStart < numSamples) {
+        const float mixStep = 1.0f / static_cast<float>(clipPathFadeSamples);
+        const float startMix = static_cast<float>(fadePosition + fadeStart) * mixStep;
+
+        for (int path = 0; path < numPaths; ++path) {
+            float* incoming = clipPathScratch[path] + fadeStart;
+            ClipKernels::get().crossfade(incoming, paths[path] + fadeStart, numSamples - fadeStart, startMix, mixStep);
+            juce::FloatVectorOperations::copy(paths[path] + fadeStart, incoming, numSamples - fadeStart);
+        }
+    }
+
+    clipPathTransitionPosition += numSamples;
+    if (clipPathTransitionPosition >= clipPathWarmupSamples + clipPathFadeSamples) {
+        // Leave the outgoing path clean for its next warm-up
+        if (activeClipPath == ClipPath::Oversampled) {
+            activeOversampler->reset();
+            clipping.reset();
+        }
+        else {
+            hostRateClipping.reset();
+            hostRateDelay.reset();
+        }
 
-        // Process the Mid and Side components
-        float midClipped = clipping.processSample(mid, clipType);
-        float sideClipped = clipping.processSample(side, clipType);
+        activeClipPath = targetClipPath;
+        clipPathTransitionPosition = 0;
+    }
+}
 
-        // Combine processed Mid and Side back into Left and Right channels
-        buffer.setSample(0, sample, midClipped + sideClipped); // Left
-        buffer.setSample(1, sample, midClipped - sideClipped); // Right
+void KlipAudioProcessor::runClipPath(ClipPath path, float* const* paths, int numPaths, int numSamples, Clipping::ClipType clipType) {
+    if (path == ClipPath::HostRate) {
+        hostRateClipping.processBlock(paths, numPaths, numSamples, clipType);
+
+        // In live mode nothing waits for the oversampled path's latency
+        if (! liveModeActive)
+            hostRateDelay.process(paths, numPaths, numSamples);
+        return;
     }
+
+    juce::dsp::AudioBlock<float> pathBlock(paths, static_cast<size_t>(numPaths), static_cast<size_t>(numSamples));
+    auto oversampledBlock = activeOversampler->processSamplesUp(pathBlock);
+
+    float* oversampledPaths[Clipping::maxPaths];
+    for (int index = 0; index < numPaths; ++index)
+        oversampledPaths[index] = oversampledBlock.getChannelPointer(static_cast<size_t>(index));
+
+    clipping.processBlock(oversampledPaths, numPaths, static_cast<int>(oversampledBlock.getNumSamples()), clipType);
+
+    activeOversampler->processSamplesDown(pathBlock);
 }
 
+void KlipAudioProcessor::setClipPathTarget(ClipPath target) {
+    // A switch in progress finishes first; the governor holds its level longer than that
+    if (activeClipPath != targetClipPath || target == activeClipPath)
+        return;
+
+    targetClipPath = target;
+    clipPathTransitionPosition = 0;
+}
+
+// ===========================mid/side processing===========================================
+
+// The conversions (MidSide.h, shared with the DSP library) run in place on the host
+// buffer so the clipper can work on whole sub-blocks: channel 0 carries mid, channel 1
+// side while Clipping::processBlock runs. They are stages of the sub-block chain
+// below, which takes a sub-block from the dry capture to the dither in one pass.
+
+struct KlipAudioProcessor::CaptureDryStage {
+    static void process(KlipAudioProcessor& processor, float* const* channels, int, int numSamples) {
+        processor.captureDrySignal(channels, numSamples);
+    }
+};
+
+// The auto threshold measures the paths as the clipper gets them
+template <MidSide::Mode mode>
+struct KlipAudioProcessor::MeasurePeaksStage {
+    static void process(KlipAudioProcessor& processor, float* const* channels, int, int numSamples) {
+        processor.updateAutoThresholdTarget(channels, MidSide::getNumPaths(mode), numSamples);
+    }
+};
+
+template <MidSide::Mode mode>
+struct KlipAudioProcessor::ClipStage {
+    static void process(KlipAudioProcessor& processor, float* const* channels, int, int numSamples) {
+        processor.clipPaths(channels, MidSide::getNumPaths(mode), numSamples, processor.subBlockClipType);
+    }
+};
+
+struct KlipAudioProcessor::MixDryStage {
+    static void process(KlipAudioProcessor& processor, float* const* channels, int, int numSamples) {
+        processor.mixDrySignal(channels, numSamples);
+    }
+};
+
+// Dither and noise shaping come last, nothing may touch the samples after them
+struct KlipAudioProcessor::DitherStage {
+    static void process(KlipAudioProcessor& processor, float* const* channels, int numChannels, int numSamples) {
+        processor.outputDither.processBlock(channels, juce::jmin(numChannels, OutputDither::maxChannels), numSamples);
+    }
+};
+
+template <int variant>
+struct KlipAudioProcessor::SubBlockChain {
+    static constexpr int layout = variant % 4;
+    static constexpr bool clipped = layout != passthroughLayout;
+    static constexpr auto mode = static_cast<MidSide::Mode>(clipped ? layout : MidSide::Both);
+
+    using Type = StagePipeline::Chain<maxSubBlockSize,
+                                      StagePipeline::When<clipped, CaptureDryStage>,
+                                      StagePipeline::When<clipped, MidSide::EncodeStage<mode>>,
+                                      StagePipeline::When<clipped && (variant & 4) != 0, MeasurePeaksStage<mode>>,
+                                      StagePipeline::When<clipped, ClipStage<mode>>,
+                                      StagePipeline::When<clipped, MidSide::DecodeStage<mode>>,
+                                      StagePipeline::When<clipped, MixDryStage>,
+                                      StagePipeline::When<(variant & 8) != 0, DitherStage>>;
+
+    template <typename Context>
+    static void process(Context& processor, float* const* channels, int numChannels, int numSamples) {
+        Type::process(processor, channels, numChannels, numSamples);
+    }
+};
+
 
 // ==============================================================================
 const juce::String KlipAudioProcessor::getName() const
@@ -147,26 +447,75 @@ int KlipAudioProcessor::getCurrentProgram()
 
 void KlipAudioProcessor::setCurrentProgram(int index)
 {
+    juce::ignoreUnused(index);
 }
 
 const juce::String KlipAudioProcessor::getProgramName(int index)
 {
+    juce::ignoreUnused(index);
     return {};
 }
 
 void KlipAudioProcessor::changeProgramName(int index, const juce::String& newName)
 {
+    juce::ignoreUnused(index, newName);
 }
 
 //==============================================================================
 void KlipAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    clipping.setSampleRate(static_cast<float>(sampleRate));
+    currentSampleRate = sampleRate;
+    preparedBlockSize = samplesPerBlock;
+
+    // Only what the current settings use; the rest waits until it's asked for
+    realtimeOversampler->initProcessing(static_cast<size_t>(samplesPerBlock));
+    if (isNonRealtime() || offlineOversampler != nullptr)
+        prepareOfflineOversampler();
+    if (static_cast<int>(engineParameter->load()) == 1)
+        buildSpectralEngine();
+
+    // Scratch sized for the highest oversampling factor either quality can use,
+    // the dry delay for the longest latency any engine and quality can report
+    const int maxOversampledBlockSize = samplesPerBlock << ProcessingQuality::maxOversamplingOrder;
+    const int hostRateLatency = juce::roundToInt(realtimeOversampler->getLatencyInSamples());
+    const int offlineLatency = offlineOversampler != nullptr ? juce::roundToInt(offlineOversampler->getLatencyInSamples()) : 0;
+    const int maxTransientLookahead = static_cast<int>(std::ceil(maxTransientLookaheadMs * 0.001 * sampleRate));
+    const int maxWetLatency = juce::jmax(SpectralClipper::getLatencyInSamples(SpectralClipper::maxFftOrder),
+                                         hostRateLatency + maxTransientLookahead, offlineLatency + maxTransientLookahead);
+    arena.layout([&](DspArena& a) {
+        clipping.allocateFrom(a, sampleRate, maxOversampledBlockSize, maxTransientLookahead << ProcessingQuality::maxOversamplingOrder);
+        hostRateClipping.allocateFrom(a, sampleRate, maxSubBlockSize, maxTransientLookahead);
+        hostRateDelay.allocateFrom(a, hostRateLatency);
+        for (auto& scratch : clipPathScratch)
+            scratch = a.allocate<float>(maxSubBlockSize);
+        dryDelay.allocateFrom(a, maxWetLatency);
+        for (auto& scratch : dryScratch)
+            scratch = a.allocate<float>(maxSubBlockSize);
+    });
+    hostRateDelay.setDelay(hostRateLatency);
+    governor.reset();
+    flightRecorder.prepare(sampleRate, samplesPerBlock, getTotalNumInputChannels(), recordedParameterIDs);
+
+    // From the settings rather than the engine the last block ran: a session (or a
+    // tool) set to the spectral engine before playback gets its latency right away
+    applyQuality(isOfflineQualityRequested());
+    setLatencySamples(getExpectedLatency(isNonRealtime()));
+
     const double timeDuration = 0.05; // 50 milliseconds
     int bufferSize = static_cast<int>(sampleRate * timeDuration);
 
-    clipping.setupLowFrequencyAnalysis(sampleRate, bufferSize);
-    initializeAllPassFilters();
+    clipping.setupLowFrequencyAnalysis(static_cast<int>(sampleRate), bufferSize);
+    peakSketch.prepare(sampleRate, autoThresholdHalfLifeSeconds);
+    autoThresholdActive = false;
+    initializeAllPassFilters(sampleRate);
+    blockEndThreshold = -1.0f;
+
+    dryWetMix.reset(sampleRate, dryWetRampSeconds);
+    dryWetMix.setCurrentAndTargetValue(mixParameter->load() * 0.01f);
+
+    // Fixed seed: the same input renders to the same dithered output every time
+    outputDither.reset();
+    ditherActive = false;
 }
 
 void KlipAudioProcessor::releaseResources()
@@ -202,53 +551,260 @@ bool KlipAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) cons
 #endif
 
 void KlipAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages) {
+    juce::ignoreUnused(midiMessages);
+    processBlockWithParameterEvents(buffer, nullptr, 0);
+}
+
+void KlipAudioProcessor::processBlockWithParameterEvents(juce::AudioBuffer<float>& buffer, const ParameterEvent* events, int numEvents) {
     juce::ScopedNoDenormals noDenormals;
+    ScopedAllocationGuard allocationGuard;
+    const auto startTicks = juce::Time::getHighResolutionTicks();
+    const int numSamples = buffer.getNumSamples();
+
+    // Live mode switches at a block boundary. Every new audio thread (the driver
+    // makes one whenever the device reopens) asks for realtime priority once.
+    const bool liveMode = liveModeRequested.load() && ! isNonRealtime();
+    if (liveMode != liveModeActive) {
+        liveModeActive = liveMode;
+        applyQuality(isOfflineQualityRequested());
+    }
+    if (liveModeActive && juce::Thread::getCurrentThreadId() != promotedAudioThread) {
+        promotedAudioThread = juce::Thread::getCurrentThreadId();
+        audioThreadPriority.store(LiveMode::promoteCurrentThread());
+    }
+
+    // The latency measurement replaces the output entirely while it runs
+    if (latencyProbe.isRunning()) {
+        latencyProbe.process(buffer.getArrayOfWritePointers(), juce::jmin(getTotalNumInputChannels(), buffer.getNumChannels()),
+                             buffer.getNumChannels(), numSamples, currentSampleRate);
+        return;
+    }
+
+    // Spectrum analyzer input; one atomic load covers both taps when no editor is open
+    const bool spectrumTapOpen = spectrumTap.isOpen();
+    if (spectrumTapOpen)
+        spectrumTap.push(SpectrumTap::Input, buffer, getTotalNumInputChannels());
+
+    // The recorder takes the input before anything touches it
+    flightRecorder.setEnabled(flightRecorderParameter->load() >= 0.5f);
+    flightRecorder.beginBlock(buffer, getTotalNumInputChannels(), recordedParameterValues.data(), governor.getLevel(), isNonRealtime(), liveModeActive);
+
+    // Hosts may toggle offline rendering without calling prepareToPlay again
+    if (isOfflineQualityRequested() != offlineQualityActive)
+        applyQuality(isOfflineQualityRequested());
+
+    // The plugin wrappers only hand over the value at the end of the block. Without
+    // timestamps the threshold ramps to it across the sub-blocks, which retraces
+    // the host's linear automation segment instead of stepping once per block.
+    const bool rampThreshold = numEvents == 0;
+    const float targetThreshold = thresholdParameter->load();
+    const float startThreshold = (rampThreshold && blockEndThreshold >= 0.0f) ? blockEndThreshold : targetThreshold;
+
+    // Auto threshold starts over from the manual setting with an empty sketch
+    const bool autoThreshold = autoThresholdParameter->load() >= 0.5f;
+    if (autoThreshold && ! autoThresholdActive) {
+        peakSketch.reset();
+        autoThresholdTarget = autoThresholdDecibels = convertToDecibel(startThreshold);
+    }
+    autoThresholdActive = autoThreshold;
+
+    for (int channel = getTotalNumInputChannels(); channel < getTotalNumOutputChannels(); ++channel) {
+        buffer.clear(channel, 0, numSamples);
+    }
+
+    // The dither runs inside the sub-block chain; its noise doesn't depend on where blocks split
+    const int ditherDepth = static_cast<int>(ditherDepthParameter->load());
+    if (ditherDepth > 0) {
+        if (! ditherActive)
+            outputDither.reset();
+
+        outputDither.setup(currentSampleRate, ditherDepth == 1 ? 16 : 24, static_cast<OutputDither::Shape>(static_cast<int>(noiseShapingParameter->load())));
+    }
+    ditherActive = ditherDepth > 0;
+
+    auto* const* channels = buffer.getArrayOfWritePointers();
+    const int numChannels = juce::jmin(buffer.getNumChannels(), StagePipeline::maxChannels);
+
+    int eventIndex = 0;
+    for (int start = 0; start < numSamples;) {
+        for (; eventIndex < numEvents && events[eventIndex].sampleOffset <= start; ++eventIndex)
+            applyParameterEvent(events[eventIndex]);
+
+        int end = juce::jmin(numSamples, start + maxSubBlockSize);
+        if (eventIndex < numEvents)
+            end = juce::jmin(end, events[eventIndex].sampleOffset);
+
+        const float threshold = autoThresholdActive ? getAutoThreshold(end - start)
+            : rampThreshold ? startThreshold + (targetThreshold - startThreshold) * static_cast<float>(end) / static_cast<float>(numSamples)
+            : thresholdParameter->load();
+
+        // Refers to the caller's channels, no copy and no allocation
+        float* subBlock[StagePipeline::maxChannels] = {};
+        for (int channel = 0; channel < numChannels; ++channel)
+            subBlock[channel] = channels[channel] + start;
+
+        processSubBlock(subBlock, numChannels, end - start, threshold);
+        start = end;
+    }
+
+    // Events stamped past the end still count, from the next block on
+    for (; eventIndex < numEvents; ++eventIndex)
+        applyParameterEvent(events[eventIndex]);
+
+    blockEndThreshold = thresholdParameter->load();
+
+    // Engine and FFT size both change the latency
+    const int latency = getLatencyForQuality(offlineQualityActive);
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+
+    if (spectrumTapOpen)
+        spectrumTap.push(SpectrumTap::Output, buffer, getTotalNumOutputChannels());
+
+    // Takes effect from the next block
+    const double elapsedSeconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    const double blockSeconds = numSamples / currentSampleRate;
+    const float budget = governorBudgetParameter->load() * 0.01f;
+    governor.setBudget(budget);
+    governor.update(elapsedSeconds, blockSeconds, governorParameter->load() >= 0.5f && ! offlineQualityActive);
+    flightRecorder.endBlock(buffer, elapsedSeconds, ! offlineQualityActive && elapsedSeconds > blockSeconds * budget);
+}
+
+float KlipAudioProcessor::getAutoThreshold(int numSamples) {
+    const float glide = 1.0f - static_cast<float>(std::exp(-numSamples / (autoThresholdGlideSeconds * currentSampleRate)));
+    autoThresholdDecibels += (autoThresholdTarget - autoThresholdDecibels) * glide;
+    autoThresholdDisplay.store(autoThresholdDecibels, std::memory_order_relaxed);
+
+    // Back to the slider position processSubBlock works from (inverse of convertToDecibel)
+    return (autoThresholdDecibels + 24.0f) / 24.0f;
+}
+
+void KlipAudioProcessor::updateAutoThresholdTarget(float* const* paths, int numPaths, int numSamples) {
+    // Queried only when a window completed, kept to the manual threshold's range
+    if (peakSketch.process(paths, numPaths, numSamples) > 0 && peakSketch.getNumPeaks() >= autoThresholdMinPeaks) {
+        const double fraction = autoTargetParameter->load() * 0.01;
+        autoThresholdTarget = juce::jlimit(-24.0f, 0.0f, peakSketch.getDecibelsExceededBy(fraction));
+    }
+}
+
+void KlipAudioProcessor::captureDrySignal(const float* const* channels, int numSamples) {
+    for (int channel = 0; channel < BlockDelayLine::maxChannels; ++channel)
+        juce::FloatVectorOperations::copy(dryScratch[channel], channels[channel], numSamples);
+}
+
+void KlipAudioProcessor::mixDrySignal(float* const* channels, int numSamples) {
+    // Always delayed, so a mix that leaves 100% starts from the right material. The
+    // latency is the one this sub-block ran with (engine, quality, lookahead, live mode);
+    // a change only moves the read position, so the dry part never drops out.
+    dryDelay.setDelay(getLatencyForQuality(offlineQualityActive));
+    dryDelay.process(dryScratch, BlockDelayLine::maxChannels, numSamples);
+
+    dryWetMix.setTargetValue(mixParameter->load() * 0.01f);
+    const float startMix = dryWetMix.getCurrentValue();
+    const float endMix = dryWetMix.skip(numSamples);
+    if (startMix >= 1.0f && endMix >= 1.0f)
+        return;
+
+    // Wet towards dry, the mix ramping linearly across the sub-block
+    const float mixStep = (endMix - startMix) / static_cast<float>(numSamples);
+    for (int channel = 0; channel < BlockDelayLine::maxChannels; ++channel)
+        ClipKernels::get().crossfade(channels[channel], dryScratch[channel], numSamples, startMix, mixStep);
+}
+
+void KlipAudioProcessor::applyParameterEvent(const ParameterEvent& event) {
+    // Same sequence the VST3 wrapper uses, so the cached raw values follow
+    if (auto* parameter = AudioProcessor::getParameters()[event.parameterIndex]) {
+        parameter->setValue(event.normalisedValue);
+        parameter->sendValueChangedMessageToListeners(event.normalisedValue);
+    }
+}
+
+void KlipAudioProcessor::processSubBlock(float* const* channels, int numChannels, int numSamples, float currentThreshold) {
     auto totalNumInputChannels = getTotalNumInputChannels();
 
     // Ottieni i valori dei parametri
-    auto currentThreshold = parameters.getRawParameterValue("threshold")->load();
-    auto msChoiceValue = parameters.getRawParameterValue("msProcessing")->load();
-    auto clipTypeChoiceValue = parameters.getRawParameterValue("clipType")->load();
+    auto msChoiceValue = msProcessingParameter->load();
+    auto clipTypeChoiceValue = clipTypeParameter->load();
 
     // Converti i valori float in indici interi (errore in atomic)
     int msChoice = static_cast<int>(msChoiceValue);
     int clipTypeChoice = static_cast<int>(clipTypeChoiceValue);
 
     // Ottimizzazione: Valori di soglia memorizzati nella cache
-    static float cachedThresholdInDecibels = -1.0f;
-    if (currentThreshold != cachedThresholdInDecibels) {
-        cachedThresholdInDecibels = currentThreshold;
-        thresholdInDecibels = convertToDecibel(cachedThresholdInDecibels);
-        clipping.setThreshold(thresholdInDecibels);
-    }
-
-    Clipping::ClipType clipType;
-    switch (clipTypeChoice) {
-    case 0: clipType = Clipping::SoftClip; break;
-    case 1: clipType = Clipping::HardClip; break;
-    case 2: clipType = Clipping::LinearClip; break;
-    case 3: clipType = Clipping::ExponentialClip; break;
-    case 4: clipType = Clipping::AsymmetricClip; break;
-    default: clipType = Clipping::SoftClip;
-    }
-
-    if (totalNumInputChannels >= 2) {
-        switch (msChoice) {
-        case 0:
-            processMid(buffer, clipType);
-            break;
-        case 1:
-            processSide(buffer, clipType);
-            break;
-        case 2:
-            processMidSide(buffer, clipType);
-            break;
-        }
+    if (! juce::approximatelyEqual(currentThreshold, cachedThreshold)) {
+        cachedThreshold = currentThreshold;
+        thresholdInDecibels = convertToDecibel(cachedThreshold);
+        thresholdGain = juce::Decibels::decibelsToGain(thresholdInDecibels);
+        clipping.setThreshold(thresholdGain);
+        hostRateClipping.setThreshold(thresholdGain);
+    }
+
+    const Clipping::ClipType clipType = Clipping::getClipTypeForChoice(clipTypeChoice);
+
+    // Curva custom: la tabella compilata dal message thread
+    const auto* customSegments = customCurve.acquire();
+    clipping.setCustomCurve(customSegments);
+    hostRateClipping.setCustomCurve(customSegments);
+
+    clipping.setKneeWidth(kneeWidthParameter->load());
+    hostRateClipping.setKneeWidth(kneeWidthParameter->load());
+
+    const float currentDCCutoff = dcCutoffParameter->load();
+    if (! juce::approximatelyEqual(currentDCCutoff, cachedDCCutoff)) {
+        cachedDCCutoff = currentDCCutoff;
+        clipping.setDCCutoff(cachedDCCutoff);
+        hostRateClipping.setDCCutoff(cachedDCCutoff);
     }
 
-    for (int channel = totalNumInputChannels; channel < getTotalNumOutputChannels(); ++channel) {
-        buffer.clear(channel, 0, buffer.getNumSamples());
+    // Split transienti/sustain: la soglia dei transienti e' un offset dalla soglia
+    // principale, cosi' segue automazione e soglia automatica. Il lookahead conta alla
+    // frequenza di ciascun path, la latenza resta la stessa su entrambi.
+    const bool transientSplit = transientSplitParameter->load() >= 0.5f;
+    const auto transientClipType = Clipping::getClipTypeForChoice(static_cast<int>(transientClipTypeParameter->load()));
+    const float transientThresholdGain = thresholdGain * juce::Decibels::decibelsToGain(transientThresholdParameter->load());
+    clipping.setTransientSplit(transientSplit, transientClipType, transientThresholdGain);
+    hostRateClipping.setTransientSplit(transientSplit, transientClipType, transientThresholdGain);
+    clipping.setTransientSensitivity(transientSensitivityParameter->load());
+    hostRateClipping.setTransientSensitivity(transientSensitivityParameter->load());
+
+    const int transientLookahead = liveModeActive ? 0 : getTransientLookaheadSamples();
+    clipping.setTransientLookahead(transientLookahead * static_cast<int>(activeOversampler->getOversamplingFactor()));
+    hostRateClipping.setTransientLookahead(transientLookahead);
+
+    // Governor levels: Reduced drops oversampling and caps the spectral overlap at 4x,
+    // Minimal caps it at 2x. Latency stays put at every level.
+    const auto qualityLevel = governor.getLevel();
+    setClipPathTarget(qualityLevel == QualityGovernor::Full && ! liveModeActive ? ClipPath::Oversampled : ClipPath::HostRate);
+
+    // Live mode bypasses the spectral engine (one FFT frame of latency); the editor flags it.
+    // Until the engine is built the time-domain path carries on. prepareToPlay and
+    // setNonRealtime(true) build it when a session or bounce starts on it; only a switch
+    // to it in the middle of a render waits for the builder like realtime playback does.
+    bool spectral = static_cast<int>(engineParameter->load()) == 1 && ! liveModeActive;
+    if (spectral && ! spectralEngineReady.load(std::memory_order_acquire)) {
+        spectralEngineRequested.store(true, std::memory_order_relaxed);
+        spectral = false;
+    }
+    if (spectral) {
+        const int maxOverlap = qualityLevel == QualityGovernor::Full ? 8 : (qualityLevel == QualityGovernor::Reduced ? 4 : 2);
+        spectralClipper.setFrameLayout(SpectralClipper::minFftOrder + static_cast<int>(fftSizeParameter->load()),
+                                       juce::jmin(maxOverlap, 2 << static_cast<int>(fftOverlapParameter->load())));
+        spectralClipper.setCurve(clipType, { thresholdGain, kneeWidthParameter->load(), customSegments });
     }
+
+    if (spectral != spectralEngineActive) {
+        spectralEngineActive = spectral;
+        if (spectral)
+            spectralClipper.reset();
+        else
+            applyQuality(offlineQualityActive);
+    }
+
+    // Mono input passes through untouched, dither aside
+    const bool clipped = totalNumInputChannels >= 2 && numChannels >= 2 && msChoice >= MidSide::Mid && msChoice <= MidSide::Both;
+    const int variant = (clipped ? msChoice : passthroughLayout) + (autoThresholdActive ? 4 : 0) + (ditherActive ? 8 : 0);
+    subBlockClipType = clipType;
+    StagePipeline::Variants<SubBlockChain, numSubBlockVariants>::get<KlipAudioProcessor>(variant)(*this, channels, numChannels, numSamples);
 }
 
 
@@ -267,6 +823,7 @@ juce::AudioProcessorEditor* KlipAudioProcessor::createEditor()
 void KlipAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     // Salva lo stato corrente in un flusso di dati
+    const juce::ScopedLock sl(stateLock);
     auto state = parameters.copyState();
     std::unique_ptr<juce::XmlElement> xml(state.createXml());
     copyXmlToBinary(*xml, destData);
@@ -274,11 +831,50 @@ void KlipAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 
 void KlipAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
-    // Ripristina lo stato da un flusso di dati
+    // Ripristina lo stato da un flusso di dati; i punti della curva dal thread
+    // dell'editor aspettano il lock
+    const juce::ScopedLock sl(stateLock);
     std::unique_ptr<juce::XmlElement> xmlState(getXmlFromBinary(data, sizeInBytes));
     if (xmlState != nullptr)
         if (xmlState->hasTagName(parameters.state.getType()))
             parameters.replaceState(juce::ValueTree::fromXml(*xmlState));
+
+    // A session that uses the spectral engine gets it built before playback starts
+    if (static_cast<int>(engineParameter->load()) == 1)
+        spectralEngineRequested.store(true, std::memory_order_relaxed);
+
+    // Punti della curva custom, salvati come "x y x y ..." nello stato;
+    // gli stati senza curva tornano a quella di default
+    const auto curveState = parameters.state.getChildWithName("CustomCurve");
+    if (! curveState.isValid()) {
+        customCurve.setPoints(CustomCurve::getDefaultPoints());
+        return;
+    }
+
+    juce::StringArray tokens;
+    tokens.addTokens(curveState.getProperty("points").toString(), " ", "");
+    tokens.removeEmptyStrings();
+
+    std::vector<CustomCurve::Point> points;
+    for (int i = 0; i + 1 < tokens.size(); i += 2)
+        points.push_back({ tokens[i].getFloatValue(), tokens[i + 1].getFloatValue() });
+    customCurve.setPoints(points);
+}
+
+void KlipAudioProcessor::setCustomCurvePoints(const std::vector<CustomCurve::Point>& points)
+{
+    // Curva e stato insieme, cosi' un ripristino concorrente non li separa
+    const juce::ScopedLock sl(stateLock);
+    customCurve.setPoints(points);
+
+    juce::StringArray tokens;
+    for (const auto& point : customCurve.getPoints()) {
+        tokens.add(juce::String(point.x));
+        tokens.add(juce::String(point.y));
+    }
+
+    auto curveState = parameters.state.getOrCreateChildWithName("CustomCurve", nullptr);
+    curveState.setProperty("points", tokens.joinIntoString(" "), nullptr);
 }
 
 
@@ -10,6 +10,22 @@
 
 #include <JuceHeader.h>
 #include "Clipping.h"
+#include "ProcessingQuality.h"
+#include "DspArena.h"
+#include "SpectralClipper.h"
+#include "MultiChannelFilter.h"
+#include "BlockDelayLine.h"
+#include "QualityGovernor.h"
+#include "FlightRecorder.h"
+#include "OutputDither.h"
+#include "MidSide.h"
+#include "CustomCurve.h"
+#include "LatencyProbe.h"
+#include "LiveMode.h"
+#include "SpectrumTap.h"
+#include "BackgroundBuilder.h"
+#include "PeakSketch.h"
+#include "StagePipeline.h"
 // #include "OffsetDC.h"
 //==============================================================================
 /**
@@ -18,6 +34,7 @@ class KlipAudioProcessor  : public juce::AudioProcessor
                             #if JucePlugin_Enable_ARA
                              , public juce::AudioProcessorARAExtension
                             #endif
+                            , private BackgroundBuilder::Client
 {
 public:
     //==============================================================================
@@ -33,6 +50,56 @@ public:
    #endif
 
     void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    using AudioProcessor::processBlock;
+
+    // A parameter change at an exact sample: index into AudioProcessor::getParameters(),
+    // value normalised 0..1.
+    struct ParameterEvent
+    {
+        int sampleOffset;
+        int parameterIndex;
+        float normalisedValue;
+    };
+
+    // processBlock with timestamped changes (sorted by sampleOffset): the block is
+    // split at every event, so each one takes effect on its own sample. processBlock
+    // itself has no timestamps from the plugin wrappers and ramps the threshold instead.
+    void processBlockWithParameterEvents (juce::AudioBuffer<float>& buffer, const ParameterEvent* events, int numEvents);
+
+    // Longest stretch processed with one set of parameter values.
+    static constexpr int maxSubBlockSize = 64;
+
+    // Level the adaptive quality governor currently runs at (any thread).
+    QualityGovernor::Level getQualityLevel() const { return governor.getLevel(); }
+
+    // Opt-in black box for glitch reports, see FlightRecorder.h.
+    FlightRecorder& getFlightRecorder() { return flightRecorder; }
+
+    // Replaying a capture pins the governor to the recorded level (-1 releases it).
+    void setQualityLevelOverride (int level) { governor.setOverride(level); }
+
+    // Standalone live mode (see LiveMode.h), any thread. The audio thread switches
+    // to the zero-latency path on its next block and asks for realtime priority.
+    void setLiveMode (bool enabled) { liveModeRequested.store(enabled); }
+    bool isLiveModeActive() const { return liveModeRequested.load(); }
+    LiveMode::Priority getAudioThreadPriority() const { return audioThreadPriority.load(); }
+
+    // True while live mode bypasses a selected feature that would add latency
+    bool isLatencyFeatureBypassed() const { return liveModeRequested.load() && (static_cast<int>(engineParameter->load()) == 1 || getTransientLookaheadSamples() > 0); }
+
+    // Loopback round-trip measurement; owns the audio while it runs
+    LatencyProbe& getLatencyProbe() { return latencyProbe; }
+
+    // Feeds the editor's spectrum analyzer while one is open
+    SpectrumTap& getSpectrumTap() { return spectrumTap; }
+
+    // The spectral engine is built the first time it's selected; until then
+    // the time-domain path keeps running (any thread).
+    bool isSpectralEngineReady() const { return spectralEngineReady.load(std::memory_order_acquire); }
+
+    // Threshold the auto mode currently applies, in dB (any thread)
+    float getAutoThresholdDecibels() const { return autoThresholdDisplay.load(std::memory_order_relaxed); }
+    void setNonRealtime (bool isNonRealtime) noexcept override;
 
     //==============================================================================
     juce::AudioProcessorEditor* createEditor() override;
@@ -61,19 +128,178 @@ public:
     float convertToDecibel(float sliderValue);   
     juce::AudioProcessorValueTreeState& getParameters() { return parameters; }
 
+    // Control points of the Custom clip type (any thread but the audio thread).
+    // Setting them compiles the curve and saves the points with the plugin state.
+    void setCustomCurvePoints (const std::vector<CustomCurve::Point>& points);
+    std::vector<CustomCurve::Point> getCustomCurvePoints() const { return customCurve.getPoints(); }
+
 private:
-    void processMid(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType);
-    void processSide(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType);
-    void processMidSide(juce::AudioBuffer<float>& buffer, Clipping::ClipType clipType);
+    void clipPaths(float* const* paths, int numPaths, int numSamples, Clipping::ClipType clipType);
+    void processSubBlock(float* const* channels, int numChannels, int numSamples, float currentThreshold);
+
+    // The per-sample chain of a sub-block, composed from StagePipeline stages
+    // (defined in PluginProcessor.cpp). variant = layout + 4 * auto threshold
+    // + 8 * dither, layout being the mid/side mode or passthroughLayout when
+    // there's nothing to clip (mono input); every combination is compiled.
+    static constexpr int passthroughLayout = 3;
+    static constexpr int numSubBlockVariants = 16;
+    struct CaptureDryStage;
+    template <MidSide::Mode mode> struct MeasurePeaksStage;
+    template <MidSide::Mode mode> struct ClipStage;
+    struct MixDryStage;
+    struct DitherStage;
+    template <int variant> struct SubBlockChain;
+    Clipping::ClipType subBlockClipType = Clipping::HardClip;
+
+    // The two time-domain paths. HostRate skips oversampling and is delayed to the
+    // oversampler's latency, so the governor can swap them without a latency change.
+    enum class ClipPath { Oversampled, HostRate };
+    void runClipPath(ClipPath path, float* const* paths, int numPaths, int numSamples, Clipping::ClipType clipType);
+    void setClipPathTarget(ClipPath target);
+    void applyParameterEvent(const ParameterEvent& event);
+
+    // Auto threshold: the level that autoTarget percent of the clipper's input
+    // peaks exceed, from a PeakSketch that forgets with autoThresholdHalfLife and
+    // reached through a one-pole glide. The manual threshold holds until the
+    // sketch has autoThresholdMinPeaks to go on (a second of 5 ms windows).
+    static constexpr double autoThresholdHalfLifeSeconds = 10.0;
+    static constexpr double autoThresholdGlideSeconds = 0.5;
+    static constexpr double autoThresholdMinPeaks = 200.0;
+    float getAutoThreshold(int numSamples);
+    void updateAutoThresholdTarget(float* const* paths, int numPaths, int numSamples);
+
+    // Transient split (see Clipping::setTransientSplit). The lookahead is set in ms
+    // and adds that much latency to both time-domain paths while the split is on.
+    static constexpr float maxTransientLookaheadMs = 5.0f;
+    int getTransientLookaheadSamples() const;
+
+    // Parallel clipping: the input, delayed by exactly the latency the wet path
+    // reports (oversampling, lookahead or spectral frame), crossfaded with the
+    // output by the mix parameter, ramped over dryWetRampSeconds. The delay is
+    // sized in prepareToPlay for the largest latency any setting can have, so
+    // switching modes never allocates.
+    static constexpr double dryWetRampSeconds = 0.02;
+    void captureDrySignal(const float* const* channels, int numSamples);
+    void mixDrySignal(float* const* channels, int numSamples);
+
+    // Real-time and offline settings are both prepared up front, so a bounce only
+    // swaps the active oversampler and curve mode on the audio thread.
+    void applyQuality(bool offline);
+    int getLatencyForQuality(bool offline) const;
+    juce::dsp::Oversampling<float>& getOversampler(bool offline) const;
+
+    // Offline quality once the host renders and the offline oversampler is ready
+    // for it; a render whose oversampler couldn't be allocated stays in realtime quality.
+    bool isOfflineQualityRequested() const { return isNonRealtime() && offlineQualityReady.load(std::memory_order_acquire); }
+
+    // getLatencyForQuality as the audio thread will see it, for the host's thread:
+    // from parameters and atomics only, none of the audio thread's state.
+    int getExpectedLatency(bool offline) const;
+
+    // Subsystems the default settings don't use are only built when asked for,
+    // then kept. The offline oversampler (8x FIR, the slowest thing to design)
+    // waits for the first render; the spectral engine for the first time it's
+    // selected, built by prepareToPlay and setNonRealtime(true) when it already
+    // is and otherwise by the background builder while the time-domain path
+    // carries on. Never on the audio thread. An allocation failure leaves the
+    // subsystem unready, and what the instance already runs carries on.
+    void prepareOfflineOversampler();
+    void buildSpectralEngine();
+    void buildRequestedSubsystems() override;
+
+    std::unique_ptr<juce::dsp::Oversampling<float>> realtimeOversampler;
+    std::unique_ptr<juce::dsp::Oversampling<float>> offlineOversampler; // null until the first render
+    std::atomic<bool> offlineQualityReady { false };                     // offlineOversampler is prepared
+    juce::dsp::Oversampling<float>* activeOversampler = nullptr;
+    bool offlineQualityActive = false;
+
+    // Live mode: host-rate path without delay compensation, no spectral engine
+    std::atomic<bool> liveModeRequested { false };
+    bool liveModeActive = false;
+    std::atomic<LiveMode::Priority> audioThreadPriority { LiveMode::Priority::NotRequested };
+    juce::Thread::ThreadID promotedAudioThread = nullptr;
+    LatencyProbe latencyProbe;
+    SpectrumTap spectrumTap;
+    double currentSampleRate = 44100.0;
  
     std::pair<float, float> combineMidSideWithPhaseControl(float mid, float side);
-    juce::dsp::IIR::Filter<float> leftAllPassFilter;
-    juce::dsp::IIR::Filter<float> rightAllPassFilter;
-    void initializeAllPassFilters();
+    MultiChannelFilter allPassFilter; // left, right
+    void initializeAllPassFilters(double sampleRate);
 
     float thresholdInDecibels;
+    float cachedThreshold = -1.0f;
+    float blockEndThreshold = -1.0f;
+    float thresholdGain = 1.0f;
+    float cachedDCCutoff = -1.0f;
 
+    // All of the instance's scratch and analysis buffers, sized in prepareToPlay
+    // (the spectral engine's excepted, see spectralArena).
+    // JUCE's Oversampling keeps its own buffers, also allocated there.
+    DspArena arena;
     Clipping clipping;
+    Clipping hostRateClipping;
+    CustomCurve customCurve;
+    juce::CriticalSection stateLock; // parameters.state: state save/restore (any thread) vs the curve editor
+    BlockDelayLine hostRateDelay;
+    SpectralClipper spectralClipper;
+    DspArena spectralArena; // the engine's frame buffers, laid out when it's built
+    bool spectralEngineActive = false;
+    std::atomic<bool> spectralEngineRequested { false };
+    std::atomic<bool> spectralEngineReady { false };
+    juce::CriticalSection subsystemLock; // builder thread vs prepareToPlay and offline renders
+    int preparedBlockSize = 0;
+    juce::SharedResourcePointer<BackgroundBuilder> backgroundBuilder;
+
+    // Path switches warm the incoming path up on a copy of the signal (filters,
+    // delay line) before crossfading to it.
+    static constexpr int clipPathWarmupSamples = 4096;
+    static constexpr int clipPathFadeSamples = 1024;
+    QualityGovernor governor;
+    ClipPath activeClipPath = ClipPath::Oversampled;
+    ClipPath targetClipPath = ClipPath::Oversampled;
+    int clipPathTransitionPosition = 0;
+    float* clipPathScratch[Clipping::maxPaths] = {};
+
+    PeakSketch peakSketch;
+    bool autoThresholdActive = false;
+    float autoThresholdTarget = 0.0f;   // dB
+    float autoThresholdDecibels = 0.0f; // dB, gliding towards the target
+    std::atomic<float> autoThresholdDisplay { 0.0f };
+
+    BlockDelayLine dryDelay;
+    float* dryScratch[BlockDelayLine::maxChannels] = {};
+    juce::LinearSmoothedValue<float> dryWetMix { 1.0f };
+
+    // Final quantisation for fixed-point masters, off unless a word length is chosen
+    OutputDither outputDither;
+    bool ditherActive = false;
+
+    // Raw values of every parameter in getParameters() order, as the recorder stores them
+    FlightRecorder flightRecorder;
+    juce::StringArray recordedParameterIDs;
+    std::vector<std::atomic<float>*> recordedParameterValues;
+
+    std::atomic<float>* thresholdParameter = nullptr;
+    std::atomic<float>* msProcessingParameter = nullptr;
+    std::atomic<float>* clipTypeParameter = nullptr;
+    std::atomic<float>* kneeWidthParameter = nullptr;
+    std::atomic<float>* dcCutoffParameter = nullptr;
+    std::atomic<float>* engineParameter = nullptr;
+    std::atomic<float>* fftSizeParameter = nullptr;
+    std::atomic<float>* fftOverlapParameter = nullptr;
+    std::atomic<float>* governorParameter = nullptr;
+    std::atomic<float>* governorBudgetParameter = nullptr;
+    std::atomic<float>* flightRecorderParameter = nullptr;
+    std::atomic<float>* ditherDepthParameter = nullptr;
+    std::atomic<float>* noiseShapingParameter = nullptr;
+    std::atomic<float>* autoThresholdParameter = nullptr;
+    std::atomic<float>* autoTargetParameter = nullptr;
+    std::atomic<float>* transientSplitParameter = nullptr;
+    std::atomic<float>* transientClipTypeParameter = nullptr;
+    std::atomic<float>* transientThresholdParameter = nullptr;
+    std::atomic<float>* transientSensitivityParameter = nullptr;
+    std::atomic<float>* transientLookaheadParameter = nullptr;
+    std::atomic<float>* mixParameter = nullptr;
 
     juce::AudioProcessorValueTreeState parameters;
     //==============================================================================
@@ -0,0 +1,25 @@
+/*
+  ==============================================================================
+
+    ProcessingQuality.h
+
+  ==============================================================================
+*/
+
+#pragma once
+
+// Settings that trade CPU for quality. The processor uses realtime() while the
+// host is playing and switches to offline() when it bounces (isNonRealtime()).
+struct ProcessingQuality
+{
+    int oversamplingOrder;    // oversampling factor is 2^order
+    bool linearPhaseFilters;  // FIR equiripple half-band filters instead of polyphase IIR
+    bool exactCurves;         // evaluate exp/log curves exactly instead of through lookup tables
+
+    static constexpr int maxOversamplingOrder = 3;
+
+    static constexpr ProcessingQuality realtime() { return { 1, false, false }; }
+    static constexpr ProcessingQuality offline()  { return { 3, true, true }; }
+
+    int getOversamplingFactor() const { return 1 << oversamplingOrder; }
+};
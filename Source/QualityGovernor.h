@@ -0,0 +1,118 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <atomic>
+
+// Live-use safety net: compares each block's processing time with its
+// deadline and steps the processor down when it keeps running over budget,
+// back up once there is clear headroom again. Stepping down needs
+// `overloadBlocks` blocks in a row over budget; stepping up needs
+// `recoverySeconds` below half the budget. After any change the level is held
+// for `holdSeconds` so the cost of the transition itself can't trigger the next.
+//
+// What each level turns off is up to the processor (see KlipAudioProcessor::
+// processSubBlock); every level keeps the same latency.
+class QualityGovernor {
+public:
+    enum Level {
+        Full,
+        Reduced,
+        Minimal
+    };
+
+    static constexpr int overloadBlocks = 4;
+    static constexpr double recoverySeconds = 3.0;
+    static constexpr double holdSeconds = 0.5;
+
+    // Fraction of the block duration the processor may use, 0..1.
+    void setBudget(float fractionOfDeadline) {
+        budget = fractionOfDeadline;
+    }
+
+    void reset() {
+        overloadCount = 0;
+        headroomSeconds = 0.0;
+        holdRemaining = 0.0;
+        level.store(Full, std::memory_order_relaxed);
+    }
+
+    // Pins the level, -1 hands control back. Replaying a flight recorder
+    // capture uses it to run every block at the level it was recorded at.
+    void setOverride(int forcedLevel) {
+        levelOverride.store(forcedLevel, std::memory_order_relaxed);
+    }
+
+    // Audio thread, once per block after processing it. Disabled means Full.
+    Level update(double elapsedSeconds, double blockSeconds, bool enabled) {
+        if (levelOverride.load(std::memory_order_relaxed) >= 0)
+            return getLevel();
+
+        if (! enabled || blockSeconds <= 0.0) {
+            if (getLevel() != Full)
+                reset();
+            return Full;
+        }
+
+        const double load = elapsedSeconds / blockSeconds;
+        holdRemaining -= blockSeconds;
+
+        if (load > budget) {
+            ++overloadCount;
+            headroomSeconds = 0.0;
+        }
+        else {
+            overloadCount = 0;
+            headroomSeconds = load < 0.5 * budget ? headroomSeconds + blockSeconds : 0.0;
+        }
+
+        auto current = getLevel();
+        if (holdRemaining <= 0.0) {
+            if (overloadCount >= overloadBlocks && current < Minimal)
+                current = changeLevel(static_cast<Level>(current + 1));
+            else if (headroomSeconds >= recoverySeconds && current > Full)
+                current = changeLevel(static_cast<Level>(current - 1));
+        }
+
+        return current;
+    }
+
+    // Any thread (the editor shows it).
+    Level getLevel() const {
+        const int forced = levelOverride.load(std::memory_order_relaxed);
+        if (forced >= 0)
+            return forced < Minimal ? static_cast<Level>(forced) : Minimal;
+
+        return level.load(std::memory_order_relaxed);
+    }
+
+    static const char* getLevelName(Level levelToName) {
+        switch (levelToName) {
+        case Reduced: return "Reduced";
+        case Minimal: return "Minimal";
+        case Full:    break;
+        }
+        return "Full";
+    }
+
+private:
+    Level changeLevel(Level newLevel) {
+        level.store(newLevel, std::memory_order_relaxed);
+        overloadCount = 0;
+        headroomSeconds = 0.0;
+        holdRemaining = holdSeconds;
+        return newLevel;
+    }
+
+    std::atomic<Level> level { Full };
+    std::atomic<int> levelOverride { -1 };
+    float budget = 0.5f;
+    int overloadCount = 0;
+    double headroomSeconds = 0.0;
+    double holdRemaining = 0.0;
+};
@@ -0,0 +1,53 @@
+/*
+  ==============================================================================
+
+    SharedTableCache.cpp
+
+  ==============================================================================
+*/
+
+#include "SharedTableCache.h"
+#include <iterator>
+#include <map>
+#include <mutex>
+
+namespace {
+    struct Store {
+        std::mutex lock;
+        std::map<SharedTableCache::Key, std::weak_ptr<const void>> tables;
+    };
+
+    // Leaked on purpose: instances destroyed during static destruction can
+    // still release their tables.
+    Store& getStore() {
+        static Store* store = new Store();
+        return *store;
+    }
+
+    void removeExpired(std::map<SharedTableCache::Key, std::weak_ptr<const void>>& tables) {
+        for (auto it = tables.begin(); it != tables.end();)
+            it = it->second.expired() ? tables.erase(it) : std::next(it);
+    }
+}
+
+std::shared_ptr<const void> SharedTableCache::find(const Key& key, const std::function<std::shared_ptr<const void>()>& build) {
+    auto& store = getStore();
+    std::lock_guard<std::mutex> guard(store.lock);
+
+    auto& entry = store.tables[key];
+    if (auto table = entry.lock())
+        return table;
+
+    // Built under the lock, so concurrent first requests never build twice
+    auto table = build();
+    entry = table;
+    removeExpired(store.tables);
+    return table;
+}
+
+int SharedTableCache::getNumLiveTables() {
+    auto& store = getStore();
+    std::lock_guard<std::mutex> guard(store.lock);
+    removeExpired(store.tables);
+    return static_cast<int>(store.tables.size());
+}
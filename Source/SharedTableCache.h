@@ -0,0 +1,59 @@
+/*
+  ==============================================================================
+
+    SharedTableCache.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <functional>
+#include <memory>
+#include <tuple>
+
+// Process-wide store for immutable DSP tables (windows, FFT engines, curve or
+// filter tables that depend on the settings). Instances asking for the same key
+// get the same object: it's built once, by whichever instance asks first, and
+// freed when the last shared_ptr to it goes away.
+//
+// get() locks and may build, so it belongs in prepare/setup code, never on the
+// audio thread. What it returns is const and safe to read from any number of
+// audio threads. Each plugin binary has its own cache.
+class SharedTableCache {
+public:
+    enum class Kind {
+        SqrtHannWindow, // factor = size
+        FftEngine       // factor = order
+    };
+
+    // Unused fields stay zero. Kind tells the builders apart, so two kinds may
+    // use the same fields for different things.
+    struct Key {
+        Kind kind;
+        int curve = 0;        // clip type, or another selector within the kind
+        float threshold = 0.0f;
+        double sampleRate = 0.0;
+        int factor = 0;       // oversampling factor, size or order
+
+        bool operator<(const Key& other) const {
+            return std::tie(kind, curve, threshold, sampleRate, factor)
+                 < std::tie(other.kind, other.curve, other.threshold, other.sampleRate, other.factor);
+        }
+    };
+
+    // The table for `key`, calling build() (returning a std::unique_ptr<T> or
+    // std::shared_ptr<T>) if no instance holds one. T must be the same for
+    // every use of a Kind.
+    template <typename T, typename Builder>
+    static std::shared_ptr<const T> get(const Key& key, Builder&& build) {
+        return std::static_pointer_cast<const T>(find(key, [&]() -> std::shared_ptr<const void> {
+            return std::shared_ptr<const T>(build());
+        }));
+    }
+
+    // Tables alive right now, for the tools
+    static int getNumLiveTables();
+
+private:
+    static std::shared_ptr<const void> find(const Key& key, const std::function<std::shared_ptr<const void>()>& build);
+};
@@ -0,0 +1,217 @@
+/*
+  ==============================================================================
+
+    SpectralClipper.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectralClipper.h"
+
+void SpectralClipper::prepare() {
+    for (int order = minFftOrder; order <= maxFftOrder; ++order) {
+        auto& fft = ffts[order - minFftOrder];
+        if (fft == nullptr)
+            fft = SharedTableCache::get<juce::dsp::FFT>({ SharedTableCache::Kind::FftEngine, 0, 0.0f, 0.0, order }, [order] {
+                return std::make_unique<juce::dsp::FFT>(order);
+            });
+
+        auto& sharedWindow = windows[order - minFftOrder];
+        if (sharedWindow == nullptr)
+            sharedWindow = SharedTableCache::get<Window>({ SharedTableCache::Kind::SqrtHannWindow, 0, 0.0f, 0.0, 1 << order }, [order] {
+                // sqrt of a periodic Hann: analysis * synthesis sums to overlap / 2
+                const int size = 1 << order;
+                auto built = std::make_unique<Window>();
+                built->samples.resize(static_cast<size_t>(size));
+
+                double windowSum = 0.0;
+                for (int i = 0; i < size; ++i) {
+                    const double hann = 0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * i / size);
+                    built->samples[static_cast<size_t>(i)] = static_cast<float>(std::sqrt(hann));
+                    windowSum += built->samples[static_cast<size_t>(i)];
+                }
+
+                built->amplitudeScale = static_cast<float>(2.0 / windowSum);
+                return built;
+            });
+    }
+
+    selectWindow();
+}
+
+void SpectralClipper::allocateFrom(DspArena& arena) {
+    const size_t maxSize = static_cast<size_t>(1 << maxFftOrder);
+
+    fftData = arena.allocate<float>(2 * maxSize);
+    amplitudes = arena.allocate<float>(maxSize / 2 + 1);
+    clipped = arena.allocate<float>(maxSize / 2 + 1);
+
+    for (auto& state : pathStates) {
+        state.input = arena.allocate<float>(maxSize);
+        state.outputAccum = arena.allocate<float>(maxSize);
+        state.ready = arena.allocate<float>(maxSize);
+    }
+}
+
+void SpectralClipper::setFrameLayout(int newFftOrder, int newOverlap) {
+    newFftOrder = juce::jlimit(minFftOrder, maxFftOrder, newFftOrder);
+    newOverlap = juce::jlimit(2, 8, juce::nextPowerOfTwo(newOverlap));
+
+    if (newFftOrder != fftOrder) {
+        fftOrder = newFftOrder;
+        fftSize = 1 << fftOrder;
+        overlap = newOverlap;
+        selectWindow();
+        reset();
+        return;
+    }
+
+    // Picked up at the next frame boundary by advanceSchedule()
+    overlap = newOverlap;
+}
+
+void SpectralClipper::setCurve(int newClipType, const ClipKernels::CurveShape& newShape) {
+    clipType = newClipType;
+    shape = newShape;
+}
+
+void SpectralClipper::reset() {
+    gridOverlap = overlap;
+    hopSize = fftSize / gridOverlap;
+    hopPosition = 0;
+    scheduleTransition = false;
+
+    if (fftData == nullptr)
+        return;
+
+    for (auto& state : pathStates) {
+        juce::FloatVectorOperations::clear(state.input, fftSize);
+        juce::FloatVectorOperations::clear(state.outputAccum, fftSize);
+        juce::FloatVectorOperations::clear(state.ready, hopSize);
+    }
+}
+
+void SpectralClipper::selectWindow() {
+    const auto* selected = windows[fftOrder - minFftOrder].get();
+    if (selected == nullptr)
+        return;
+
+    window = selected->samples.data();
+    amplitudeScale = selected->amplitudeScale;
+}
+
+float SpectralClipper::getFrameWeight() const {
+    // Squared sqrt-Hann frames at overlap O add up to O / 2
+    if (! scheduleTransition)
+        return 2.0f / static_cast<float>(gridOverlap);
+
+    const int ratio = fineOverlap / coarseOverlap;
+    const bool onCoarseGrid = frameInTransition % ratio == 0;
+    return (1.0f - coarseMix) * 2.0f / static_cast<float>(fineOverlap)
+         + (onCoarseGrid ? coarseMix * 2.0f / static_cast<float>(coarseOverlap) : 0.0f);
+}
+
+int SpectralClipper::advanceSchedule() {
+    if (! scheduleTransition && overlap != gridOverlap) {
+        // The frame just done counts as a coarse-grid frame either way
+        scheduleTransition = true;
+        frameInTransition = 0;
+        fineOverlap = juce::jmax(overlap, gridOverlap);
+        coarseOverlap = juce::jmin(overlap, gridOverlap);
+        coarseMix = overlap < gridOverlap ? 0.0f : 1.0f;
+        gridOverlap = fineOverlap;
+    }
+
+    if (scheduleTransition) {
+        // About four FFT lengths; a request for the other end mid-way just turns around
+        const float step = 1.0f / static_cast<float>(4 * fineOverlap);
+        coarseMix = juce::jlimit(0.0f, 1.0f, coarseMix + (overlap <= coarseOverlap ? step : -step));
+
+        const int ratio = fineOverlap / coarseOverlap;
+        const bool frameWasOnCoarseGrid = frameInTransition % ratio == 0;
+        ++frameInTransition;
+
+        if (coarseMix <= 0.0f) {
+            scheduleTransition = false;
+            gridOverlap = fineOverlap;
+        }
+        else if (coarseMix >= 1.0f && frameWasOnCoarseGrid) {
+            // The in-between frames weigh nothing now, the next one is a coarse hop away
+            scheduleTransition = false;
+            gridOverlap = coarseOverlap;
+        }
+    }
+
+    return fftSize / gridOverlap;
+}
+
+void SpectralClipper::processBlock(float* const* paths, int numPaths, int numSamples) {
+    jassert(fftData != nullptr && window != nullptr && ffts[fftOrder - minFftOrder] != nullptr);
+    numPaths = juce::jmin(numPaths, maxPaths);
+
+    int done = 0;
+    while (done < numSamples) {
+        const int count = juce::jmin(numSamples - done, hopSize - hopPosition);
+
+        for (int path = 0; path < numPaths; ++path) {
+            auto& state = pathStates[path];
+            float* io = paths[path] + done;
+
+            // Nuovi campioni in coda al frame, poi l'uscita pronta per questo hop
+            juce::FloatVectorOperations::copy(state.input + fftSize - hopSize + hopPosition, io, count);
+            juce::FloatVectorOperations::copy(io, state.ready + hopPosition, count);
+        }
+
+        hopPosition += count;
+        done += count;
+
+        if (hopPosition == hopSize) {
+            const float outputScale = getFrameWeight();
+            const int nextHop = advanceSchedule();
+
+            for (int path = 0; path < numPaths; ++path)
+                processFrame(path, outputScale, nextHop);
+
+            hopSize = nextHop;
+            hopPosition = 0;
+        }
+    }
+}
+
+void SpectralClipper::processFrame(int path, float outputScale, int nextHop) {
+    auto& state = pathStates[path];
+    const auto& fft = *ffts[fftOrder - minFftOrder];
+    const int numBins = fftSize / 2 + 1;
+
+    juce::FloatVectorOperations::multiply(fftData, state.input, window, fftSize);
+    juce::FloatVectorOperations::clear(fftData + fftSize, fftSize);
+    fft.performRealOnlyForwardTransform(fftData, true);
+
+    for (int bin = 0; bin < numBins; ++bin) {
+        const float re = fftData[2 * bin];
+        const float im = fftData[2 * bin + 1];
+        amplitudes[bin] = std::sqrt(re * re + im * im) * amplitudeScale;
+    }
+
+    juce::FloatVectorOperations::copy(clipped, amplitudes, numBins);
+    kernels->clip(clipped, numBins, clipType, shape);
+
+    for (int bin = 0; bin < numBins; ++bin) {
+        const float gain = amplitudes[bin] > 1.0e-8f ? clipped[bin] / amplitudes[bin] : 1.0f;
+        fftData[2 * bin] *= gain;
+        fftData[2 * bin + 1] *= gain;
+    }
+
+    fft.performRealOnlyInverseTransform(fftData);
+
+    // Synthesis window and overlap-add
+    for (int i = 0; i < fftSize; ++i)
+        state.outputAccum[i] += fftData[i] * window[i] * outputScale;
+
+    // No later frame reaches the next hop's worth of output: publish it and slide
+    // both frames by that hop (it differs from the last one while the overlap changes)
+    juce::FloatVectorOperations::copy(state.ready, state.outputAccum, nextHop);
+    std::memmove(state.outputAccum, state.outputAccum + nextHop, sizeof(float) * static_cast<size_t>(fftSize - nextHop));
+    juce::FloatVectorOperations::clear(state.outputAccum + fftSize - nextHop, nextHop);
+    std::memmove(state.input, state.input + nextHop, sizeof(float) * static_cast<size_t>(fftSize - nextHop));
+}
@@ -0,0 +1,103 @@
+/*
+  ==============================================================================
+
+    SpectralClipper.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "ClipKernels.h"
+#include "DspArena.h"
+#include "SharedTableCache.h"
+
+// Alternative clipping engine: STFT with sqrt-Hann analysis/synthesis windows and
+// overlap-add. Each frame's bin magnitudes are converted to sine amplitudes, run
+// through the selected clip curve (same kernels as the time-domain engine) and
+// the resulting gain is applied to the bin, keeping its phase. Distortion then
+// stays in the bins that exceed the threshold instead of spreading across the
+// spectrum.
+//
+// Latency is exactly one FFT frame. All frame buffers come from the instance
+// arena. The FFT engines and windows for every selectable size are fetched in
+// prepare() from SharedTableCache, so instances share one copy of each and
+// changing size or overlap on the audio thread neither allocates nor computes.
+//
+// Overlap changes don't reset anything. Frames run on the finer of the two hop
+// grids while each frame's overlap-add weight slides from one schedule to the
+// other over a few FFT lengths; both schedules sum to unity, so the output
+// stays continuous and only the cost changes.
+class SpectralClipper {
+public:
+    static constexpr int minFftOrder = 9;  // 512
+    static constexpr int maxFftOrder = 12; // 4096
+    static constexpr int maxPaths = 2;
+
+    SpectralClipper() = default;
+    ~SpectralClipper() = default;
+
+    // Message thread: fetches (or builds) the shared FFT engines and windows. Safe to call again.
+    void prepare();
+    void allocateFrom(DspArena& arena);
+
+    // Audio thread. fftOrder in [minFftOrder, maxFftOrder], overlap 2, 4 or 8.
+    // A new FFT size resets the frame state (and changes the latency); a new
+    // overlap alone crossfades the frame schedule.
+    void setFrameLayout(int newFftOrder, int newOverlap);
+    void setCurve(int newClipType, const ClipKernels::CurveShape& newShape);
+    void reset();
+
+    void processBlock(float* const* paths, int numPaths, int numSamples);
+
+    int getLatencyInSamples() const { return fftSize; }
+    static int getLatencyInSamples(int fftOrder) { return 1 << fftOrder; }
+
+private:
+    void selectWindow();
+    void processFrame(int path, float outputScale, int nextHop);
+    float getFrameWeight() const;
+    int advanceSchedule();
+
+    struct PathState {
+        float* input = nullptr;       // last fftSize input samples
+        float* outputAccum = nullptr; // overlap-add accumulator
+        float* ready = nullptr;       // finished samples for the current hop
+    };
+
+    // sqrt-Hann of one FFT size, plus the bin magnitude -> sine amplitude factor
+    struct Window {
+        std::vector<float> samples;
+        float amplitudeScale;
+    };
+
+    static constexpr int numFftOrders = maxFftOrder - minFftOrder + 1;
+    std::shared_ptr<const juce::dsp::FFT> ffts[numFftOrders];
+    std::shared_ptr<const Window> windows[numFftOrders];
+    const ClipKernels::Table* kernels = &ClipKernels::get();
+
+    PathState pathStates[maxPaths];
+    const float* window = nullptr;
+    float* fftData = nullptr;
+    float* amplitudes = nullptr;
+    float* clipped = nullptr;
+
+    int fftOrder = 11;
+    int fftSize = 1 << 11;
+    int overlap = 4;           // requested
+    int gridOverlap = 4;       // frames are currently scheduled at fftSize / gridOverlap
+    int hopSize = fftSize / gridOverlap;
+    int hopPosition = 0;
+    float amplitudeScale = 1.0f; // bin magnitude -> sine amplitude
+
+    // Overlap transition: fineOverlap frames, weights sliding towards the
+    // coarseOverlap schedule as coarseMix goes 0 -> 1.
+    bool scheduleTransition = false;
+    int fineOverlap = 4;
+    int coarseOverlap = 4;
+    int frameInTransition = 0;
+    float coarseMix = 0.0f;
+
+    int clipType = 0;
+    ClipKernels::CurveShape shape { 1.0f, 0.5f };
+};
@@ -0,0 +1,186 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumAnalyzer.h"
+
+SpectrumAnalyzer::SpectrumAnalyzer(KlipAudioProcessor& p)
+    : processor(p), tap(p.getSpectrumTap()) {
+    // Same engine the spectral clipper uses at this size
+    fft = SharedTableCache::get<juce::dsp::FFT>({ SharedTableCache::Kind::FftEngine, 0, 0.0f, 0.0, fftOrder }, [] {
+        return std::make_unique<juce::dsp::FFT>(fftOrder);
+    });
+
+    // Periodic Hann
+    window.resize(static_cast<size_t>(fftSize));
+    for (int i = 0; i < fftSize; ++i)
+        window[static_cast<size_t>(i)] = static_cast<float>(0.5 - 0.5 * std::cos(juce::MathConstants<double>::twoPi * i / fftSize));
+
+    fftData.resize(static_cast<size_t>(2 * fftSize));
+    pulled.resize(static_cast<size_t>(SpectrumTap::capacity));
+
+    signals[0].point = SpectrumTap::Input;
+    signals[1].point = SpectrumTap::Output;
+    for (auto& signal : signals) {
+        signal.history.assign(static_cast<size_t>(fftSize), 0.0f);
+        std::fill(std::begin(signal.levels), std::end(signal.levels), minDecibels);
+    }
+
+    setOpaque(true);
+    tap.open();
+    startTimerHz(frameRate);
+}
+
+SpectrumAnalyzer::~SpectrumAnalyzer() {
+    tap.close();
+}
+
+void SpectrumAnalyzer::updateBands() {
+    // Log-spaced from minFrequency to Nyquist, as fractional FFT bins
+    const float nyquist = static_cast<float>(sampleRate * 0.5);
+    for (int band = 0; band <= numBands; ++band) {
+        const float frequency = minFrequency * std::pow(nyquist / minFrequency, static_cast<float>(band) / numBands);
+        bandEdges[band] = frequency * fftSize / static_cast<float>(sampleRate);
+    }
+}
+
+bool SpectrumAnalyzer::drain(Signal& signal) {
+    int total = 0;
+    for (int count; (count = tap.pull(signal.point, pulled.data() + total, SpectrumTap::capacity - total)) > 0;)
+        total += count;
+    if (total == 0)
+        return false;
+
+    // Keep the newest fftSize samples
+    auto& history = signal.history;
+    const int kept = juce::jmax(0, fftSize - total);
+    std::move(history.end() - kept, history.end(), history.begin());
+    const int fresh = juce::jmin(total, fftSize);
+    std::copy(pulled.begin() + (total - fresh), pulled.begin() + total, history.begin() + kept);
+    return true;
+}
+
+void SpectrumAnalyzer::analyse(Signal& signal) {
+    juce::FloatVectorOperations::multiply(fftData.data(), signal.history.data(), window.data(), fftSize);
+    juce::FloatVectorOperations::clear(fftData.data() + fftSize, fftSize);
+    fft->performFrequencyOnlyForwardTransform(fftData.data(), true);
+
+    // A full-scale sine reads 0 dB: Hann sums to fftSize / 2, a bin holds half the amplitude
+    const float scale = 4.0f / fftSize;
+    const float fall = fallDecibelsPerSecond / frameRate;
+    const int lastBin = fftSize / 2;
+
+    for (int band = 0; band < numBands; ++band) {
+        const float low = bandEdges[band], high = bandEdges[band + 1];
+        float magnitude = 0.0f;
+
+        if (high - low < 1.0f) {
+            // Narrower than a bin (low end): interpolate at the centre
+            const float centre = juce::jlimit(0.0f, static_cast<float>(lastBin - 1), 0.5f * (low + high));
+            const int bin = static_cast<int>(centre);
+            magnitude = juce::jmap(centre - static_cast<float>(bin), fftData[static_cast<size_t>(bin)], fftData[static_cast<size_t>(bin + 1)]);
+        }
+        else {
+            for (int bin = static_cast<int>(std::ceil(low)); bin <= juce::jmin(lastBin, static_cast<int>(high)); ++bin)
+                magnitude = juce::jmax(magnitude, fftData[static_cast<size_t>(bin)]);
+        }
+
+        const float decibels = juce::Decibels::gainToDecibels(magnitude * scale, minDecibels);
+        signal.levels[band] = juce::jmax(decibels, signal.levels[band] - fall);
+    }
+}
+
+void SpectrumAnalyzer::timerCallback() {
+    if (processor.getSampleRate() > 0.0 && ! juce::approximatelyEqual(processor.getSampleRate(), sampleRate)) {
+        sampleRate = processor.getSampleRate();
+        updateBands();
+        resized(); // the grid depends on Nyquist
+    }
+    if (sampleRate <= 0.0)
+        return;
+
+    for (auto& signal : signals) {
+        if (drain(signal))
+            analyse(signal);
+        else
+            for (auto& level : signal.levels)
+                level = juce::jmax(minDecibels, level - fallDecibelsPerSecond / frameRate);
+    }
+
+    inputPath = makePath(signals[0], true);
+    outputPath = makePath(signals[1], false);
+    repaint();
+}
+
+float SpectrumAnalyzer::getX(float frequency) const {
+    const float nyquist = static_cast<float>(sampleRate * 0.5);
+    return static_cast<float>(getWidth()) * std::log(frequency / minFrequency) / std::log(nyquist / minFrequency);
+}
+
+float SpectrumAnalyzer::getY(float decibels) const {
+    return juce::jmap(decibels, minDecibels, maxDecibels, static_cast<float>(getHeight()), 0.0f);
+}
+
+juce::Path SpectrumAnalyzer::makePath(const Signal& signal, bool closed) const {
+    juce::Path path;
+    const float bandWidth = static_cast<float>(getWidth()) / numBands;
+
+    for (int band = 0; band < numBands; ++band) {
+        const float x = (static_cast<float>(band) + 0.5f) * bandWidth;
+        const float y = getY(signal.levels[band]);
+        if (band == 0)
+            path.startNewSubPath(x, y);
+        else
+            path.lineTo(x, y);
+    }
+
+    if (closed) {
+        path.lineTo(static_cast<float>(getWidth()), static_cast<float>(getHeight()));
+        path.lineTo(0.0f, static_cast<float>(getHeight()));
+        path.closeSubPath();
+    }
+
+    return path;
+}
+
+void SpectrumAnalyzer::resized() {
+    // Grid into an image once; frames only draw the two paths over it
+    background = juce::Image(juce::Image::RGB, juce::jmax(1, getWidth()), juce::jmax(1, getHeight()), true);
+    juce::Graphics g(background);
+    g.fillAll(juce::Colours::black);
+    if (sampleRate <= 0.0)
+        return;
+
+    g.setFont(10.0f);
+    for (float frequency : { 50.0f, 100.0f, 200.0f, 500.0f, 1000.0f, 2000.0f, 5000.0f, 10000.0f, 20000.0f }) {
+        if (frequency >= sampleRate * 0.5)
+            break;
+        const int x = juce::roundToInt(getX(frequency));
+        g.setColour(juce::Colours::white.withAlpha(0.12f));
+        g.drawVerticalLine(x, 0.0f, static_cast<float>(getHeight()));
+        g.setColour(juce::Colours::white.withAlpha(0.4f));
+        g.drawText(frequency >= 1000.0f ? juce::String(frequency / 1000.0f) + "k" : juce::String(frequency), x + 2, getHeight() - 12, 30, 12,
+                   juce::Justification::left);
+    }
+
+    for (float decibels = 0.0f; decibels > minDecibels; decibels -= 24.0f) {
+        const int y = juce::roundToInt(getY(decibels));
+        g.setColour(juce::Colours::white.withAlpha(0.12f));
+        g.drawHorizontalLine(y, 0.0f, static_cast<float>(getWidth()));
+        g.setColour(juce::Colours::white.withAlpha(0.4f));
+        g.drawText(juce::String(juce::roundToInt(decibels)) + " dB", 2, y, 40, 12, juce::Justification::left);
+    }
+}
+
+void SpectrumAnalyzer::paint(juce::Graphics& g) {
+    g.drawImageAt(background, 0, 0);
+
+    g.setColour(juce::Colours::grey.withAlpha(0.5f));
+    g.fillPath(inputPath);
+    g.setColour(juce::Colours::orange);
+    g.strokePath(outputPath, juce::PathStrokeType(1.5f));
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    SpectrumAnalyzer.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include "PluginProcessor.h"
+
+// Input/output spectrum overlay for the editor: the input filled in grey, the
+// output drawn over it, so whatever the clipping adds stands out.
+//
+// Everything but the SpectrumTap push runs here on the message thread, at
+// most frameRate times a second: drain the FIFOs, one windowed FFT per signal
+// over the latest fftSize samples, band levels on a log frequency axis, peak
+// hold with a constant fall. The grid is drawn once per resize into an image;
+// a frame only rebuilds the two paths and repaints this component.
+class SpectrumAnalyzer : public juce::Component, private juce::Timer {
+public:
+    static constexpr int fftOrder = 12;
+    static constexpr int fftSize = 1 << fftOrder;
+    static constexpr int numBands = 160;
+    static constexpr int frameRate = 30;
+    static constexpr float minFrequency = 20.0f;
+    static constexpr float minDecibels = -96.0f;
+    static constexpr float maxDecibels = 6.0f;
+    static constexpr float fallDecibelsPerSecond = 36.0f;
+
+    explicit SpectrumAnalyzer(KlipAudioProcessor& processor);
+    ~SpectrumAnalyzer() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+private:
+    struct Signal {
+        SpectrumTap::Point point;
+        std::vector<float> history; // last fftSize samples, oldest first
+        float levels[numBands];     // dB, smoothed
+    };
+
+    void timerCallback() override;
+    bool drain(Signal& signal);
+    void analyse(Signal& signal);
+    void updateBands();
+    juce::Path makePath(const Signal& signal, bool closed) const;
+    float getX(float frequency) const;
+    float getY(float decibels) const;
+
+    KlipAudioProcessor& processor;
+    SpectrumTap& tap;
+    std::shared_ptr<const juce::dsp::FFT> fft;
+    std::vector<float> window;
+    std::vector<float> fftData;
+    std::vector<float> pulled;
+
+    Signal signals[2];
+    double sampleRate = 0.0;
+    float bandEdges[numBands + 1] = {}; // in FFT bins, fractional
+
+    juce::Image background;
+    juce::Path inputPath, outputPath;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(SpectrumAnalyzer)
+};
@@ -0,0 +1,64 @@
+/*
+  ==============================================================================
+
+    SpectrumTap.cpp
+
+  ==============================================================================
+*/
+
+#include "SpectrumTap.h"
+
+void SpectrumTap::open() {
+    // The audio thread doesn't touch the FIFOs until `opened` is set the first
+    // time, but after a quick close and reopen it may still be inside push().
+    // So only the consumer side moves: whatever the last editor left unread is
+    // skipped, never reset under the writer.
+    for (auto& fifo : fifos) {
+        if (fifo.samples.empty())
+            fifo.samples.resize(static_cast<size_t>(capacity));
+        fifo.indices.finishedRead(fifo.indices.getNumReady());
+    }
+
+    opened.store(true, std::memory_order_release);
+}
+
+void SpectrumTap::push(Point point, const juce::AudioBuffer<float>& buffer, int numChannels) {
+    auto& fifo = fifos[point];
+    const int numSamples = buffer.getNumSamples();
+    numChannels = juce::jmin(numChannels, buffer.getNumChannels());
+    if (numChannels <= 0 || fifo.indices.getFreeSpace() < numSamples)
+        return;
+
+    const float gain = 1.0f / static_cast<float>(numChannels);
+    int start1, size1, start2, size2;
+    fifo.indices.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    // Straight into the ring: no scratch buffer
+    auto mixInto = [&](int ringStart, int sourceStart, int count) {
+        float* destination = fifo.samples.data() + ringStart;
+        juce::FloatVectorOperations::copyWithMultiply(destination, buffer.getReadPointer(0, sourceStart), gain, count);
+        for (int channel = 1; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::addWithMultiply(destination, buffer.getReadPointer(channel, sourceStart), gain, count);
+    };
+
+    if (size1 > 0)
+        mixInto(start1, 0, size1);
+    if (size2 > 0)
+        mixInto(start2, size1, size2);
+
+    fifo.indices.finishedWrite(size1 + size2);
+}
+
+int SpectrumTap::pull(Point point, float* destination, int maxSamples) {
+    auto& fifo = fifos[point];
+    int start1, size1, start2, size2;
+    fifo.indices.prepareToRead(maxSamples, start1, size1, start2, size2);
+
+    if (size1 > 0)
+        std::copy_n(fifo.samples.data() + start1, size1, destination);
+    if (size2 > 0)
+        std::copy_n(fifo.samples.data() + start2, size2, destination + size1);
+
+    fifo.indices.finishedRead(size1 + size2);
+    return size1 + size2;
+}
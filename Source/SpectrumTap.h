@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    SpectrumTap.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <JuceHeader.h>
+#include <atomic>
+#include <vector>
+
+// Audio-thread end of the editor's spectrum analyzer: the input and output of
+// each block, summed to mono, go into two single-producer single-consumer FIFOs
+// that the analyzer drains on the message thread. A full FIFO drops the block,
+// so push() is wait-free.
+//
+// Closed (no editor), push() is a single atomic load. The FIFO memory is
+// allocated the first time an editor opens and kept until the processor goes.
+class SpectrumTap {
+public:
+    enum Point { Input, Output };
+    static constexpr int capacity = 1 << 14;
+
+    SpectrumTap() = default;
+    ~SpectrumTap() = default;
+
+    // Message thread, the same one that pulls
+    void open();
+    void close() { opened.store(false, std::memory_order_release); }
+
+    // Audio thread
+    bool isOpen() const { return opened.load(std::memory_order_acquire); }
+    void push(Point point, const juce::AudioBuffer<float>& buffer, int numChannels);
+
+    // Analyzer, on the message thread: up to maxSamples of the oldest samples, returns how many
+    int pull(Point point, float* destination, int maxSamples);
+
+private:
+    struct Fifo {
+        juce::AbstractFifo indices { capacity };
+        std::vector<float> samples;
+    };
+
+    Fifo fifos[2];
+    std::atomic<bool> opened { false };
+};
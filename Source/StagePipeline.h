@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    StagePipeline.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include <utility>
+
+// Processing chains composed at compile time from stage types. A stage is a
+// struct with
+//     template <typename Context>
+//     static void process(Context& context, float* const* channels, int numChannels, int numSamples);
+// that works in place on one stretch of the channels; Context is whatever owns
+// the state (the processor, StereoClipper, ...).
+//
+// Chain<SubBlockSize, Stages...>::process() runs every stage on SubBlockSize
+// samples before moving on to the next ones, so the signal stays in L1 from
+// the first stage to the last instead of streaming through memory once per
+// stage. processPerStage() is the same chain one whole pass per stage, kept as
+// the reference the benchmark compares against.
+//
+// A stage that's switched off isn't in the chain at all: When<false, Stage> is
+// an empty call the compiler drops. Variants<ChainFor, N> instantiates
+// ChainFor<0> .. ChainFor<N - 1> up front and picks one by index at run time,
+// so each combination of settings gets its own fully inlined loop.
+namespace StagePipeline {
+
+constexpr int maxChannels = 2;
+
+template <int SubBlockSize, typename... Stages>
+struct Chain {
+    static_assert(SubBlockSize > 0, "Sub-blocks need at least one sample");
+
+    template <typename Context>
+    static void process(Context& context, float* const* channels, int numChannels, int numSamples) {
+        assert(numChannels <= maxChannels);
+        numChannels = std::min(numChannels, maxChannels);
+        float* subBlock[maxChannels] = {};
+
+        for (int start = 0; start < numSamples; start += SubBlockSize) {
+            const int count = std::min(SubBlockSize, numSamples - start);
+            for (int channel = 0; channel < numChannels; ++channel)
+                subBlock[channel] = channels[channel] + start;
+
+            (Stages::process(context, subBlock, numChannels, count), ...);
+        }
+    }
+
+    template <typename Context>
+    static void processPerStage(Context& context, float* const* channels, int numChannels, int numSamples) {
+        (Stages::process(context, channels, std::min(numChannels, maxChannels), numSamples), ...);
+    }
+};
+
+template <bool Enabled, typename Stage>
+struct When {
+    template <typename Context>
+    static void process(Context& context, float* const* channels, int numChannels, int numSamples) {
+        if constexpr (Enabled)
+            Stage::process(context, channels, numChannels, numSamples);
+    }
+};
+
+// ChainFor<Index> is a Chain for every Index in [0, NumVariants).
+template <template <int> class ChainFor, int NumVariants>
+struct Variants {
+    template <typename Context>
+    using Function = void (*)(Context&, float* const*, int, int);
+
+    template <typename Context>
+    static Function<Context> get(int index) {
+        assert(index >= 0 && index < NumVariants);
+        return table<Context>(std::make_integer_sequence<int, NumVariants>())[index];
+    }
+
+private:
+    template <typename Context, int... Indices>
+    static const Function<Context>* table(std::integer_sequence<int, Indices...>) {
+        static constexpr Function<Context> functions[] = { &ChainFor<Indices>::template process<Context>... };
+        return functions;
+    }
+};
+
+} // namespace StagePipeline
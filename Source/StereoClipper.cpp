@@ -0,0 +1,116 @@
+/*
+  ==============================================================================
+
+    StereoClipper.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoClipper.h"
+#include <cmath>
+
+template <MidSide::Mode mode>
+struct StereoClipper::ClipStage {
+    static void process(StereoClipper& clipper, float* const* channels, int, int numSamples) {
+        clipper.clipping.processBlock(channels, MidSide::getNumPaths(mode), numSamples, clipper.clipType);
+    }
+};
+
+struct StereoClipper::DitherStage {
+    static void process(StereoClipper& clipper, float* const* channels, int numChannels, int numSamples) {
+        clipper.dither.processBlock(channels, numChannels, numSamples);
+    }
+};
+
+// variant = mode + 3 * dither
+template <int variant>
+struct StereoClipper::StereoChain
+    : StagePipeline::Chain<subBlockSize,
+                           MidSide::EncodeStage<static_cast<MidSide::Mode>(variant % 3)>,
+                           ClipStage<static_cast<MidSide::Mode>(variant % 3)>,
+                           MidSide::DecodeStage<static_cast<MidSide::Mode>(variant % 3)>,
+                           StagePipeline::When<(variant >= 3), DitherStage>> {};
+
+StereoClipper::StereoClipper() {
+    // Same defaults as the plugin parameters
+    setThresholdDecibels(-12.0f);
+    setKneeWidth(0.5f);
+    setUseExactCurves(false);
+}
+
+void StereoClipper::prepare(double newSampleRate, int maximumBlockSize) {
+    sampleRate = newSampleRate;
+    scratchFrames = std::max(1, maximumBlockSize);
+
+    clipping.setSampleRate(static_cast<float>(sampleRate));
+    arena.layout([&](DspArena& a) {
+        clipping.allocateFrom(a, sampleRate, scratchFrames);
+        for (auto& channel : scratch)
+            channel = a.allocate<float>(static_cast<size_t>(scratchFrames));
+    });
+
+    dither.setup(sampleRate, ditherBits > 0 ? ditherBits : 24, ditherShape);
+    reset();
+}
+
+void StereoClipper::reset() {
+    clipping.reset();
+    dither.reset();
+}
+
+void StereoClipper::setThresholdDecibels(float decibels) {
+    decibels = std::clamp(decibels, minThresholdDecibels, maxThresholdDecibels);
+    clipping.setThreshold(std::pow(10.0f, decibels * 0.05f));
+}
+
+void StereoClipper::setDither(int bits, OutputDither::Shape shape) {
+    if (bits > 0 && ditherBits == 0)
+        dither.reset(); // same output from the moment it's turned on, as in the plugin
+
+    ditherBits = bits > 0 ? bits : 0;
+    ditherShape = shape;
+    if (ditherBits > 0)
+        dither.setup(sampleRate, ditherBits, ditherShape);
+}
+
+void StereoClipper::processStereo(float* left, float* right, int numSamples) {
+    float* channels[] = { left, right };
+    const int variant = static_cast<int>(mode) + (ditherBits > 0 ? 3 : 0);
+    StagePipeline::Variants<StereoChain, 6>::get<StereoClipper>(variant)(*this, channels, 2, numSamples);
+}
+
+void StereoClipper::processPlanar(float* const* channels, int numChannels, int numSamples) {
+    clipping.setCustomCurve(customCurve.acquire());
+
+    if (numChannels >= 2) {
+        processStereo(channels[0], channels[1], numSamples);
+        return;
+    }
+
+    if (numChannels == 1) {
+        clipping.processBlock(channels, 1, numSamples, clipType);
+        if (ditherBits > 0)
+            dither.processBlock(channels, 1, numSamples);
+    }
+}
+
+void StereoClipper::processInterleaved(float* frames, int numChannels, int numFrames) {
+    const int numUsed = std::min(numChannels, 2);
+    if (numUsed < 1 || scratch[0] == nullptr)
+        return;
+
+    for (int start = 0; start < numFrames; start += scratchFrames) {
+        const int count = std::min(scratchFrames, numFrames - start);
+        float* chunk = frames + static_cast<size_t>(start) * static_cast<size_t>(numChannels);
+
+        for (int channel = 0; channel < numUsed; ++channel)
+            for (int frame = 0; frame < count; ++frame)
+                scratch[channel][frame] = chunk[frame * numChannels + channel];
+
+        processPlanar(scratch, numUsed, count);
+
+        for (int channel = 0; channel < numUsed; ++channel)
+            for (int frame = 0; frame < count; ++frame)
+                chunk[frame * numChannels + channel] = scratch[channel][frame];
+    }
+}
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    StereoClipper.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include "Clipping.h"
+#include "CustomCurve.h"
+#include "DspArena.h"
+#include "MidSide.h"
+#include "OutputDither.h"
+#include "StagePipeline.h"
+
+// The plugin's time-domain chain without JUCE: mid/side encode, DC blocker and
+// clip curve at the host rate, decode, then the optional dither. This is what
+// the klip_dsp C API (KlipDsp.h) runs; the plugin adds oversampling, the
+// spectral engine and the governor around the same pieces. Stereo runs as a
+// fused StagePipeline chain over subBlockSize samples, one precompiled variant
+// per mode with and without dither.
+//
+// Everything is allocated in prepare(). The process calls work in place on the
+// caller's buffers and never allocate. One channel runs as a single path; with
+// two or more, the first two are left/right and the rest pass through untouched.
+// Not thread safe: the setters and the process calls belong to one thread.
+class StereoClipper {
+public:
+    static constexpr float minThresholdDecibels = -24.0f; // the plugin's threshold range
+    static constexpr float maxThresholdDecibels = 0.0f;
+
+    StereoClipper();
+    ~StereoClipper() = default;
+
+    void prepare(double sampleRate, int maximumBlockSize);
+    void reset();
+
+    void setMode(MidSide::Mode newMode) { mode = newMode; }
+    void setClipType(Clipping::ClipType newClipType) { clipType = newClipType; }
+    void setThresholdDecibels(float decibels);
+    void setKneeWidth(float newKneeWidth) { clipping.setKneeWidth(std::clamp(newKneeWidth, 0.0f, 1.0f)); }
+    void setDCCutoff(float cutoffFrequency) { clipping.setDCCutoff(cutoffFrequency); }
+    void setUseExactCurves(bool shouldUseExactCurves) { clipping.setUseExactCurves(shouldUseExactCurves); }
+
+    // Control points for Clipping::CustomClip (see CustomCurve). Compiles the
+    // curve, so it allocates.
+    void setCustomCurve(const std::vector<CustomCurve::Point>& points) { customCurve.setPoints(points); }
+
+    // 0 turns the dither off, otherwise 16 or 24 (see OutputDither)
+    void setDither(int bits, OutputDither::Shape shape);
+
+    // channels[i] holds numSamples samples of channel i
+    void processPlanar(float* const* channels, int numChannels, int numSamples);
+
+    // Frames of numChannels samples back to back. Left/right go through a
+    // preallocated scratch a chunk at a time.
+    void processInterleaved(float* frames, int numChannels, int numFrames);
+
+    const char* getKernelName() const { return ClipKernels::get().name; }
+
+    static constexpr int subBlockSize = 64;
+
+private:
+    void processStereo(float* left, float* right, int numSamples);
+
+    // Chain stages and variants, see StereoClipper.cpp
+    template <MidSide::Mode mode> struct ClipStage;
+    struct DitherStage;
+    template <int variant> struct StereoChain;
+
+    Clipping clipping;
+    CustomCurve customCurve;
+    OutputDither dither;
+    DspArena arena;
+
+    MidSide::Mode mode = MidSide::Both;
+    Clipping::ClipType clipType = Clipping::SoftClip;
+    double sampleRate = 44100.0;
+    int ditherBits = 0;
+    OutputDither::Shape ditherShape = OutputDither::Flat;
+
+    float* scratch[2] = {};
+    int scratchFrames = 0;
+};
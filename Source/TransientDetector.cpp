@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    TransientDetector.cpp
+
+  ==============================================================================
+*/
+
+#include "TransientDetector.h"
+#include <cmath>
+#include <iterator>
+
+namespace {
+    // One-pole smoothing coefficient reaching 1 - 1/e after `seconds`
+    float getFollowerCoefficient(double seconds, double sampleRate) {
+        return static_cast<float>(1.0 - std::exp(-1.0 / (seconds * sampleRate)));
+    }
+}
+
+TransientDetector::TransientDetector() {
+    updateCoefficients();
+}
+
+void TransientDetector::setSampleRate(double newSampleRate) {
+    if (newSampleRate != sampleRate) {
+        sampleRate = newSampleRate;
+        updateCoefficients();
+    }
+}
+
+void TransientDetector::setSensitivity(float newSensitivity) {
+    newSensitivity = std::clamp(newSensitivity, 0.0f, 1.0f);
+    if (newSensitivity != sensitivity) {
+        sensitivity = newSensitivity;
+        updateCoefficients();
+    }
+}
+
+void TransientDetector::reset() {
+    std::fill(std::begin(state), std::end(state), 0.0f);
+}
+
+void TransientDetector::updateCoefficients() {
+    const float fastAttack = getFollowerCoefficient(fastAttackSeconds, sampleRate);
+    const float slowAttack = getFollowerCoefficient(slowAttackSeconds, sampleRate);
+    const float release = getFollowerCoefficient(releaseSeconds, sampleRate);
+    const float gain = std::exp2(4.0f * sensitivity - 1.0f);
+
+    for (int lane = 0; lane < maxChannels; ++lane) {
+        coefficients.fastAttack[lane] = fastAttack;
+        coefficients.slowAttack[lane] = slowAttack;
+        coefficients.release[lane] = release;
+        coefficients.sensitivity[lane] = gain;
+    }
+}
+
+void TransientDetector::process(const float* const* channels, int numChannels, int numSamples, float* const* weights) {
+    assert(numChannels <= maxChannels);
+    numChannels = std::min(numChannels, maxChannels);
+
+    // Lanes without a channel stay at zero and so do their followers
+    constexpr int chunkFrames = 64;
+    float frames[chunkFrames * maxChannels] = {};
+
+    for (int start = 0; start < numSamples; start += chunkFrames) {
+        const int count = std::min(chunkFrames, numSamples - start);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            const float* source = channels[channel] + start;
+            for (int i = 0; i < count; ++i)
+                frames[i * maxChannels + channel] = source[i];
+        }
+
+        kernels->transientWeights(frames, count, coefficients, state);
+
+        for (int channel = 0; channel < numChannels; ++channel) {
+            float* dest = weights[channel] + start;
+            for (int i = 0; i < count; ++i)
+                dest[i] = frames[i * maxChannels + channel];
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*
+  ==============================================================================
+
+    TransientDetector.h
+
+  ==============================================================================
+*/
+
+#pragma once
+#include <algorithm>
+#include <cassert>
+#include "ClipKernels.h"
+
+// Transient weight for every sample of up to maxChannels channels: 1 on the
+// attack of a transient, 0 on sustained material. A fast and a slow peak
+// follower share the release; the weight is how far the slow one lags behind,
+// relative to the fast one (see ClipKernels::TransientCoefficients).
+//
+// Causal: a weight only depends on the samples up to its own, so the detector
+// adds no latency and rises during the attack it reports. Callers that want
+// it settled by the time the attack comes through delay the signal instead.
+//
+// Runs on the transientWeights kernel with the channels side by side in the
+// lanes, interleaved in small stack chunks like MultiChannelFilter.
+class TransientDetector {
+public:
+    static constexpr int maxChannels = ClipKernels::filterLanes;
+    static constexpr double fastAttackSeconds = 0.0002;
+    static constexpr double slowAttackSeconds = 0.02;
+    static constexpr double releaseSeconds = 0.15;
+    static constexpr float defaultSensitivity = 0.5f;
+
+    TransientDetector();
+    ~TransientDetector() = default;
+
+    // Doesn't clear the followers, so it can follow the parameters.
+    void setSampleRate(double newSampleRate);
+
+    // 0..1, from 0.5x to 8x the relative lag; 0.5 is 2x.
+    void setSensitivity(float newSensitivity);
+
+    void reset();
+
+    // weights[c][i] for channels[c][i]; weights may alias channels.
+    void process(const float* const* channels, int numChannels, int numSamples, float* const* weights);
+
+private:
+    void updateCoefficients();
+
+    const ClipKernels::Table* kernels = &ClipKernels::get();
+    ClipKernels::TransientCoefficients coefficients {};
+    float state[2 * maxChannels] = {};
+
+    double sampleRate = 44100.0;
+    float sensitivity = defaultSensitivity;
+};
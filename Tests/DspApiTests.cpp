@@ -0,0 +1,318 @@
+/*
+  ==============================================================================
+
+    DspApiTests.cpp
+
+    The klip_dsp C API (KlipDsp.h) as a caller sees it:
+
+    - create/destroy and the argument checks of every call, parameters
+      clamped to their ranges;
+    - planar and interleaved processing giving the same samples;
+    - the output not depending on how the signal is cut into blocks;
+    - every clip type staying within its ceiling on a signal well above the
+      threshold, mono and in mid/side.
+
+    Every failure is printed; exits with 1 if there was any.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <vector>
+#include "../Source/Clipping.h"
+#include "../Source/CustomCurve.h"
+#include "../Source/KlipDsp.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int maxBlockSize = 512;
+    constexpr int numFrames = 9000; // several max blocks and a partial one
+    constexpr int numClipChoices = 12;
+
+    bool failed = false;
+
+    void expect(bool condition, const char* what)
+    {
+        if (! condition) {
+            std::cerr << "failed: " << what << std::endl;
+            failed = true;
+        }
+    }
+
+    klip_processor* create()
+    {
+        klip_config config;
+        klip_config_init(&config);
+        config.sample_rate = sampleRate;
+        config.max_block_size = maxBlockSize;
+
+        klip_processor* processor = nullptr;
+        if (klip_create(&config, &processor) != KLIP_OK || processor == nullptr) {
+            std::cerr << "failed: klip_create with a valid config" << std::endl;
+            failed = true;
+        }
+        return processor;
+    }
+
+    // Two sines a few dB over full scale with a DC offset, so the DC blocker and
+    // every curve have something to do; channel 1 differs so mid and side aren't 0
+    std::vector<float> makeSignal(int channel, float amplitude)
+    {
+        std::vector<float> signal(static_cast<size_t>(numFrames));
+        const double frequency = channel == 0 ? 220.0 : 330.0;
+        for (size_t i = 0; i < signal.size(); ++i) {
+            const double phase = 2.0 * 3.14159265358979 * frequency * static_cast<double>(i) / sampleRate;
+            signal[i] = static_cast<float>(amplitude * (0.8 * std::sin(phase) + 0.3 * std::sin(7.0 * phase) + 0.1));
+        }
+        return signal;
+    }
+
+    // Highest output of each curve in units of the threshold, 0 for the ones
+    // that keep rising (see KernelTests.cpp)
+    double getOutputCeiling(Clipping::ClipType clipType)
+    {
+        switch (clipType) {
+        case Clipping::ExponentialClip: return 1.25;
+        case Clipping::CustomClip:      return CustomCurve::maxOutput;
+        case Clipping::LinearClip:
+        case Clipping::AsymmetricClip:
+        case Clipping::SaturationClip:  return 0.0;
+        default:                        return 1.0;
+        }
+    }
+
+    void checkArguments()
+    {
+        expect(klip_get_api_version() == KLIP_API_VERSION, "klip_get_api_version");
+        expect(klip_get_kernel_name() != nullptr && *klip_get_kernel_name() != '\0', "klip_get_kernel_name");
+
+        klip_config config;
+        klip_config_init(&config);
+        expect(config.struct_size == sizeof(klip_config) && config.sample_rate == 44100.0 && config.max_block_size == 512,
+               "klip_config_init defaults");
+        klip_config_init(nullptr);
+
+        klip_processor* processor = reinterpret_cast<klip_processor*>(&config);
+        expect(klip_create(nullptr, &processor) == KLIP_ERROR_INVALID_ARGUMENT && processor == nullptr,
+               "klip_create without a config fails and clears the result");
+        expect(klip_create(&config, nullptr) == KLIP_ERROR_INVALID_ARGUMENT, "klip_create without a result");
+
+        auto rejects = [](klip_config invalid) {
+            klip_processor* result = nullptr;
+            return klip_create(&invalid, &result) == KLIP_ERROR_INVALID_ARGUMENT && result == nullptr;
+        };
+        klip_config invalid = config;
+        invalid.struct_size = sizeof(klip_config) - 1;
+        expect(rejects(invalid), "klip_create with an older struct_size");
+        invalid = config;
+        invalid.sample_rate = 0.0;
+        expect(rejects(invalid), "klip_create with a zero sample rate");
+        invalid.sample_rate = std::nan("");
+        expect(rejects(invalid), "klip_create with a NaN sample rate");
+        invalid = config;
+        invalid.max_block_size = 0;
+        expect(rejects(invalid), "klip_create with a zero block size");
+
+        klip_destroy(nullptr);
+        klip_reset(nullptr);
+
+        processor = create();
+        if (processor == nullptr)
+            return;
+
+        float value = 0.0f;
+        expect(klip_get_parameter(processor, KLIP_PARAM_THRESHOLD_DB, &value) == KLIP_OK && value == -12.0f, "default threshold");
+        expect(klip_get_parameter(processor, KLIP_PARAM_MS_MODE, &value) == KLIP_OK && value == 2.0f, "default mode");
+        expect(klip_get_parameter(nullptr, KLIP_PARAM_THRESHOLD_DB, &value) == KLIP_ERROR_INVALID_ARGUMENT, "klip_get_parameter without a processor");
+        expect(klip_get_parameter(processor, KLIP_PARAM_THRESHOLD_DB, nullptr) == KLIP_ERROR_INVALID_ARGUMENT, "klip_get_parameter without a result");
+        expect(klip_get_parameter(processor, static_cast<klip_parameter>(99), &value) == KLIP_ERROR_UNKNOWN_PARAMETER, "klip_get_parameter with an unknown id");
+
+        expect(klip_set_parameter(nullptr, KLIP_PARAM_THRESHOLD_DB, -6.0f) == KLIP_ERROR_INVALID_ARGUMENT, "klip_set_parameter without a processor");
+        expect(klip_set_parameter(processor, KLIP_PARAM_THRESHOLD_DB, std::nanf("")) == KLIP_ERROR_INVALID_ARGUMENT, "klip_set_parameter with NaN");
+        expect(klip_set_parameter(processor, static_cast<klip_parameter>(99), 0.0f) == KLIP_ERROR_UNKNOWN_PARAMETER, "klip_set_parameter with an unknown id");
+
+        // Out of range values are clamped, and read back as used
+        klip_set_parameter(processor, KLIP_PARAM_THRESHOLD_DB, 10.0f);
+        expect(klip_get_parameter(processor, KLIP_PARAM_THRESHOLD_DB, &value) == KLIP_OK && value == 0.0f, "threshold clamped to 0 dB");
+        klip_set_parameter(processor, KLIP_PARAM_CLIP_TYPE, 40.0f);
+        expect(klip_get_parameter(processor, KLIP_PARAM_CLIP_TYPE, &value) == KLIP_OK && value == 11.0f, "clip type clamped to the last choice");
+        klip_set_parameter(processor, KLIP_PARAM_DITHER_BITS, 17.0f);
+        expect(klip_get_parameter(processor, KLIP_PARAM_DITHER_BITS, &value) == KLIP_OK && value == 16.0f, "dither bits rounded to 16");
+
+        const float points[] = { 0.0f, 0.0f, 1.0f, 1.0f };
+        expect(klip_set_custom_curve(processor, points, -1) == KLIP_ERROR_INVALID_ARGUMENT, "klip_set_custom_curve with a negative count");
+        expect(klip_set_custom_curve(processor, nullptr, 2) == KLIP_ERROR_INVALID_ARGUMENT, "klip_set_custom_curve without points");
+        expect(klip_set_custom_curve(processor, points, 2) == KLIP_OK, "klip_set_custom_curve");
+
+        std::vector<float> left(64, 0.5f), right(64, 0.5f);
+        float* channels[] = { left.data(), right.data() };
+        float* missing[] = { left.data(), nullptr };
+        expect(klip_process_planar(nullptr, channels, 2, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_planar without a processor");
+        expect(klip_process_planar(processor, nullptr, 2, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_planar without channels");
+        expect(klip_process_planar(processor, missing, 2, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_planar with a null channel");
+        expect(klip_process_planar(processor, channels, -1, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_planar with negative channels");
+        expect(klip_process_planar(processor, channels, 2, -1) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_planar with negative frames");
+        expect(klip_process_planar(processor, channels, 2, 0) == KLIP_OK, "klip_process_planar with no frames");
+        expect(klip_process_planar(processor, channels, 2, 64) == KLIP_OK, "klip_process_planar");
+
+        std::vector<float> frames(128, 0.5f);
+        expect(klip_process_interleaved(nullptr, frames.data(), 2, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_interleaved without a processor");
+        expect(klip_process_interleaved(processor, nullptr, 2, 64) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_interleaved without frames");
+        expect(klip_process_interleaved(processor, frames.data(), 2, -1) == KLIP_ERROR_INVALID_ARGUMENT, "klip_process_interleaved with negative frames");
+        expect(klip_process_interleaved(processor, nullptr, 2, 0) == KLIP_OK, "klip_process_interleaved with no frames");
+        expect(klip_process_interleaved(processor, frames.data(), 2, 64) == KLIP_OK, "klip_process_interleaved");
+
+        expect(klip_get_latency(processor) == 0, "klip_get_latency");
+
+        klip_reset(processor);
+        klip_destroy(processor);
+    }
+
+    // Same settings on every processor: dither on, so the noise has to line up too
+    void configure(klip_processor* processor, int clipChoice)
+    {
+        klip_set_parameter(processor, KLIP_PARAM_CLIP_TYPE, static_cast<float>(clipChoice));
+        klip_set_parameter(processor, KLIP_PARAM_DITHER_BITS, 24.0f);
+        klip_set_parameter(processor, KLIP_PARAM_NOISE_SHAPING, 1.0f);
+    }
+
+    void checkPlanarMatchesInterleaved()
+    {
+        for (int clipChoice = 0; clipChoice < numClipChoices; ++clipChoice) {
+            klip_processor* planar = create();
+            klip_processor* interleaved = create();
+            if (planar == nullptr || interleaved == nullptr)
+                return;
+
+            configure(planar, clipChoice);
+            configure(interleaved, clipChoice);
+
+            auto left = makeSignal(0, 2.0f), right = makeSignal(1, 2.0f);
+            std::vector<float> frames(static_cast<size_t>(numFrames) * 2);
+            for (size_t i = 0; i < left.size(); ++i) {
+                frames[2 * i] = left[i];
+                frames[2 * i + 1] = right[i];
+            }
+
+            // The interleaved call is split by max_block_size, so blocks of that size line up
+            for (int start = 0; start < numFrames; start += maxBlockSize) {
+                float* channels[] = { left.data() + start, right.data() + start };
+                klip_process_planar(planar, channels, 2, std::min(maxBlockSize, numFrames - start));
+            }
+            klip_process_interleaved(interleaved, frames.data(), 2, numFrames);
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < left.size(); ++i)
+                mismatches += (frames[2 * i] != left[i] ? 1u : 0u) + (frames[2 * i + 1] != right[i] ? 1u : 0u);
+
+            if (mismatches != 0) {
+                std::cerr << "failed: clip type " << clipChoice << ": interleaved output differs from planar in "
+                          << mismatches << " samples" << std::endl;
+                failed = true;
+            }
+
+            klip_destroy(planar);
+            klip_destroy(interleaved);
+        }
+    }
+
+    void checkBlockSizeIndependence()
+    {
+        // Shorter and longer than max_block_size, not multiples of the kernels' vector width
+        const int blockSizes[] = { 1, 7, 64, 333, 512, 1000, 4096 };
+
+        for (int clipChoice = 0; clipChoice < numClipChoices; ++clipChoice) {
+            klip_processor* whole = create();
+            klip_processor* split = create();
+            if (whole == nullptr || split == nullptr)
+                return;
+
+            configure(whole, clipChoice);
+            configure(split, clipChoice);
+
+            auto expectedLeft = makeSignal(0, 2.0f), expectedRight = makeSignal(1, 2.0f);
+            float* wholeChannels[] = { expectedLeft.data(), expectedRight.data() };
+            klip_process_planar(whole, wholeChannels, 2, numFrames);
+
+            auto left = makeSignal(0, 2.0f), right = makeSignal(1, 2.0f);
+            for (int start = 0, block = 0; start < numFrames; ++block) {
+                const int count = std::min(blockSizes[block % static_cast<int>(std::size(blockSizes))], numFrames - start);
+                float* channels[] = { left.data() + start, right.data() + start };
+                klip_process_planar(split, channels, 2, count);
+                start += count;
+            }
+
+            // The vector loops and their scalar tails see different samples, so allow
+            // a few roundings
+            float worst = 0.0f;
+            for (size_t i = 0; i < left.size(); ++i)
+                worst = std::max({ worst, std::abs(left[i] - expectedLeft[i]), std::abs(right[i] - expectedRight[i]) });
+
+            if (! (worst <= 1.0e-6f)) {
+                std::cerr << "failed: clip type " << clipChoice << ": output depends on the block size, up to " << worst << std::endl;
+                failed = true;
+            }
+
+            klip_destroy(whole);
+            klip_destroy(split);
+        }
+    }
+
+    void checkBoundedOutput()
+    {
+        for (float thresholdDecibels : { -24.0f, -12.0f, 0.0f }) {
+            const double threshold = std::pow(10.0, thresholdDecibels / 20.0);
+
+            for (int clipChoice = 0; clipChoice < numClipChoices; ++clipChoice) {
+                // The change from the default curve crossfades, so the default's ceiling counts too
+                const double ceiling = std::max(1.0, getOutputCeiling(Clipping::getClipTypeForChoice(clipChoice)));
+
+                // Mono is one path; mid/side decodes two clipped paths into each channel
+                for (int numChannels : { 1, 2 }) {
+                    klip_processor* processor = create();
+                    if (processor == nullptr)
+                        return;
+
+                    klip_set_parameter(processor, KLIP_PARAM_THRESHOLD_DB, thresholdDecibels);
+                    klip_set_parameter(processor, KLIP_PARAM_CLIP_TYPE, static_cast<float>(clipChoice));
+
+                    auto left = makeSignal(0, 8.0f), right = makeSignal(1, 8.0f);
+                    float* channels[] = { left.data(), right.data() };
+                    klip_process_planar(processor, channels, numChannels, numFrames);
+                    klip_destroy(processor);
+
+                    const double bound = ceiling * threshold * numChannels * (1.0 + 8.0 * FLT_EPSILON);
+                    for (int channel = 0; channel < numChannels; ++channel) {
+                        for (float sample : channel == 0 ? left : right) {
+                            // The rising curves only have to stay finite
+                            const bool inRange = std::isfinite(sample) && (getOutputCeiling(Clipping::getClipTypeForChoice(clipChoice)) == 0.0
+                                                                           || std::abs(sample) <= bound);
+                            if (! inRange) {
+                                std::cerr << "failed: clip type " << clipChoice << " at " << thresholdDecibels << " dB, "
+                                          << numChannels << " channels: " << sample << " above " << bound << std::endl;
+                                failed = true;
+                                break;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+int main()
+{
+    checkArguments();
+    checkPlanarMatchesInterleaved();
+    checkBlockSizeIndependence();
+    checkBoundedOutput();
+
+    std::cout << "klip_dsp C API (" << klip_get_kernel_name() << "): " << (failed ? "failed" : "passed") << std::endl;
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,153 @@
+/*
+  ==============================================================================
+
+    KernelTests.cpp
+
+    Every compiled kernel table the CPU can run against the scalar reference,
+    Clipping::processClip, for every clip type: clip (exact curves) and
+    clipLookup (exp/log from the shared tables) on blocks long enough to go
+    through the vector loops and their tails, at two thresholds.
+
+    Every saturating curve must also stay within its ceiling (the threshold
+    for most), in the reference as much as in the kernels.
+
+    The allowed error per curve is the bound documented next to its kernel
+    (ClipKernelsImpl.h, ClipKernels.h) plus a few float roundings of the
+    output. Every failure is printed; exits with 1 if there was any.
+
+  ==============================================================================
+*/
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+#include <vector>
+#include "../Source/Clipping.h"
+#include "../Source/ClipKernels.h"
+#include "../Source/CustomCurve.h"
+
+namespace
+{
+    constexpr float kneeWidth = 0.5f;
+    constexpr int numClipTypes = Clipping::CustomClip + 1;
+
+    const char* const isaNames[] = { "baseline", "AVX2", "AVX-512", "NEON" };
+
+    // Documented approximation error in units of the threshold
+    double getCurveBound(int clipType)
+    {
+        switch (clipType) {
+        case Clipping::TanhClip:     return 2.1e-7;
+        case Clipping::ArctanClip:   return 1.2e-6;
+        case Clipping::SineFoldClip: return 1.5e-6;
+        default:                     return 0.0;
+        }
+    }
+
+    // Absolute error the lookup tables add: 1 - exp(-3u) is scaled by t / 4, log(1 + d)
+    // divided by ln 2 above the threshold (ln 3 below it)
+    double getLookupBound(int clipType, float threshold)
+    {
+        switch (clipType) {
+        case Clipping::ExponentialClip: return 7.0e-5 * threshold / 4.0;
+        case Clipping::AsymmetricClip:  return 3.1e-5 / 0.69314718;
+        default:                        return 0.0;
+        }
+    }
+
+    // Highest output of each saturating curve in units of the threshold, 0 for the
+    // ones that keep rising (linear, asymmetric, saturation passes through)
+    double getOutputCeiling(int clipType)
+    {
+        switch (clipType) {
+        case Clipping::ExponentialClip: return 1.25;
+        case Clipping::CustomClip:      return CustomCurve::maxOutput;
+        case Clipping::LinearClip:
+        case Clipping::AsymmetricClip:
+        case Clipping::SaturationClip:  return 0.0;
+        default:                        return 1.0;
+        }
+    }
+
+    bool check(const ClipKernels::Table& table, bool lookup, int clipType, float threshold, const ClipKernels::CurveSegments& segments)
+    {
+        Clipping reference;
+        reference.setThreshold(threshold);
+        reference.setKneeWidth(kneeWidth);
+        reference.setCustomCurve(&segments);
+
+        // +-4x the threshold, plus the values flushed to zero
+        std::vector<float> block;
+        for (int i = -4000; i <= 4000; ++i)
+            block.push_back(static_cast<float>(i) * threshold / 1000.0f);
+        block.push_back(5.0e-9f);
+        block.push_back(-5.0e-9f);
+
+        std::vector<float> expected(block.size());
+        for (size_t i = 0; i < block.size(); ++i)
+            expected[i] = std::abs(block[i]) < 1.0e-8f ? 0.0f : reference.processClip(block[i], static_cast<Clipping::ClipType>(clipType));
+
+        const ClipKernels::CurveShape shape { threshold, kneeWidth, &segments };
+        if (lookup)
+            table.clipLookup(block.data(), static_cast<int>(block.size()), clipType, shape, ClipKernels::getLookupTables());
+        else
+            table.clip(block.data(), static_cast<int>(block.size()), clipType, shape);
+
+        const double curveBound = getCurveBound(clipType) * threshold + (lookup ? getLookupBound(clipType, threshold) : 0.0);
+        const double ceiling = getOutputCeiling(clipType) * threshold * (1.0 + 8.0 * FLT_EPSILON);
+        for (size_t i = 0; i < block.size(); ++i) {
+            const double rounding = 8.0 * FLT_EPSILON * std::max(static_cast<double>(std::abs(expected[i])), static_cast<double>(threshold));
+            const double error = std::abs(static_cast<double>(block[i]) - expected[i]);
+
+            // Matching the reference proves nothing if the reference itself overshoots
+            if (ceiling > 0.0 && ! (std::abs(expected[i]) <= ceiling && std::abs(block[i]) <= ceiling)) {
+                std::cerr << table.name << (lookup ? " clipLookup" : " clip") << " type " << clipType << " threshold " << threshold
+                          << ": " << block[i] << " (reference " << expected[i] << ") above the ceiling " << ceiling << std::endl;
+                return false;
+            }
+
+            if (! (error <= curveBound + rounding)) {
+                std::cerr << table.name << (lookup ? " clipLookup" : " clip") << " type " << clipType << " threshold " << threshold
+                          << ": " << block[i] << " instead of " << expected[i] << " (error " << error << ", bound " << curveBound + rounding << ")"
+                          << std::endl;
+                return false;
+            }
+        }
+
+        return true;
+    }
+}
+
+int main()
+{
+    ClipKernels::CurveSegments segments;
+    CustomCurve::compile(CustomCurve::sanitise(CustomCurve::getDefaultPoints()), segments);
+
+    int numTables = 0;
+    bool passed = true;
+
+    for (auto isa : { ClipKernels::Isa::Baseline, ClipKernels::Isa::AVX2, ClipKernels::Isa::AVX512, ClipKernels::Isa::NEON }) {
+        const auto* table = ClipKernels::getForIsa(isa);
+        if (table == nullptr) {
+            std::cout << isaNames[static_cast<int>(isa)] << ": not compiled in or not supported by this CPU, skipped" << std::endl;
+            continue;
+        }
+
+        ++numTables;
+        for (float threshold : { 0.25f, 1.0f })
+            for (int clipType = 0; clipType < numClipTypes; ++clipType)
+                for (bool lookup : { false, true })
+                    passed = check(*table, lookup, clipType, threshold, segments) && passed;
+
+        std::cout << table->name << ": " << numClipTypes << " clip types checked" << std::endl;
+    }
+
+    // The baseline table always exists
+    if (numTables == 0) {
+        std::cerr << "no kernel table available" << std::endl;
+        return 1;
+    }
+
+    return passed ? 0 : 1;
+}
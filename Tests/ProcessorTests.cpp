@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    ProcessorTests.cpp
+
+    Hosts KlipAudioProcessor with the allocation guard on (built with
+    KLIP_DETECT_AUDIO_THREAD_ALLOCATIONS=1, see AllocationGuard.h) and drives
+    processBlock through realtime playback and then an offline render:
+    every parameter but the flight recorder randomised every few blocks,
+    block sizes from 1 sample to the prepared maximum, every third block
+    with timestamped parameter events. Fails if processBlock allocated or
+    produced anything but finite samples. The guard sees operator new on
+    every platform and the C allocator (juce::HeapBlock, AudioBuffer) on
+    glibc only, so elsewhere a malloc on the audio thread goes unnoticed.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <cmath>
+#include "../Source/PluginProcessor.h"
+#include "../Source/AllocationGuard.h"
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int maxBlockSize = 512;
+    constexpr int blocksPerPass = 3000;
+
+    // Writes captures to disk on a late block; the tools cover it
+    const juce::String skippedParameterID = "flightRecorder";
+
+    bool isFinite(const juce::AudioBuffer<float>& buffer, int numSamples)
+    {
+        for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+            for (int i = 0; i < numSamples; ++i)
+                if (! std::isfinite(buffer.getSample(channel, i)))
+                    return false;
+
+        return true;
+    }
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::Random random(2026);
+
+    KlipAudioProcessor processor;
+    processor.setPlayConfigDetails(2, 2, sampleRate, maxBlockSize);
+    processor.prepareToPlay(sampleRate, maxBlockSize);
+
+    juce::Array<juce::RangedAudioParameter*> parameters;
+    for (auto* parameter : static_cast<juce::AudioProcessor&>(processor).getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            if (ranged->getParameterID() != skippedParameterID)
+                parameters.add(ranged);
+
+    juce::AudioBuffer<float> buffer(2, maxBlockSize);
+    juce::MidiBuffer midi;
+    const int violationsBefore = ScopedAllocationGuard::getViolationCount();
+    int failures = 0;
+
+    for (bool offline : { false, true }) {
+        // Builds what the render needs here, outside processBlock
+        processor.setNonRealtime(offline);
+
+        for (int block = 0; block < blocksPerPass; ++block) {
+            if (block % 8 == 0)
+                for (auto* parameter : parameters)
+                    parameter->setValueNotifyingHost(random.nextFloat());
+
+            const int numSamples = 1 + random.nextInt(maxBlockSize);
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    buffer.setSample(channel, i, (random.nextFloat() * 2.0f - 1.0f) * 2.0f);
+
+            // Refers to the buffer's channels, like a host's block
+            juce::AudioBuffer<float> hostBlock(buffer.getArrayOfWritePointers(), 2, numSamples);
+
+            if (block % 3 == 0) {
+                auto* parameter = parameters[random.nextInt(parameters.size())];
+                const KlipAudioProcessor::ParameterEvent events[] = {
+                    { numSamples / 3, parameter->getParameterIndex(), random.nextFloat() },
+                    { (2 * numSamples) / 3, parameter->getParameterIndex(), random.nextFloat() }
+                };
+                processor.processBlockWithParameterEvents(hostBlock, events, static_cast<int>(std::size(events)));
+            }
+            else {
+                processor.processBlock(hostBlock, midi);
+            }
+
+            if (! isFinite(buffer, numSamples) && failures++ < 10)
+                std::cerr << (offline ? "offline" : "realtime") << " block " << block << ": non-finite output" << std::endl;
+        }
+    }
+
+    processor.releaseResources();
+
+    const int violations = ScopedAllocationGuard::getViolationCount() - violationsBefore;
+    if (violations > 0)
+        std::cerr << violations << " heap allocations inside processBlock" << std::endl;
+
+    std::cout << 2 * blocksPerPass << " blocks, " << violations << " allocations, " << failures << " non-finite blocks" << std::endl;
+    return violations == 0 && failures == 0 ? 0 : 1;
+}
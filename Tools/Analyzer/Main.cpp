@@ -0,0 +1,391 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Quality against CPU for every clip curve and anti-aliasing configuration.
+    Each configuration is the clipper chain as the processor runs it: JUCE
+    oversampling (none, 2x-8x, IIR or FIR half-bands) around Clipping, with
+    lookup or exact curves. Stimuli are rendered at the host rate and measured
+    with one FFT each after the filters have settled:
+
+    - THD: 1 kHz sine, harmonics below Nyquist against the fundamental.
+    - Aliasing: stepped sine sweep (1 to 16 kHz); everything between 20 Hz and
+      the fundamental against the fundamental. An odd or DC-blocked curve puts
+      nothing there, so it is all folded harmonics. The worst step is reported.
+    - IMD: CCIF twin tone (19 + 20 kHz); second- to fifth-order difference
+      products against the two tones.
+
+    Every frequency sits exactly on an FFT bin and the stimuli repeat every
+    FFT frame, so a rectangular window measures them without leakage. The cost
+    is ns per host-rate sample for the whole chain, oversampling included.
+
+    The JSON report also names, per curve, the cheapest configuration meeting
+    the targets given with --max-thd, --max-aliasing and --max-imd (dB).
+
+    Usage: KlipAnalyzer [--sample-rate R] [--drive dB] [--knee K]
+                        [--max-thd dB] [--max-aliasing dB] [--max-imd dB]
+                        [--output file.json]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <optional>
+#include "../../Source/Clipping.h"
+#include "../../Source/CustomCurve.h"
+#include "../../Source/ProcessingQuality.h"
+
+namespace
+{
+    constexpr int fftOrder = 14;
+    constexpr int fftSize = 1 << fftOrder;
+    constexpr int blockSize = 512;
+    constexpr float inputPeak = 0.5f;
+    constexpr double lowestAnalysedFrequency = 20.0; // below this is DC blocker territory
+    constexpr double sweepFrequencies[] = { 1000.0, 2500.0, 5000.0, 8000.0, 12000.0, 16000.0 };
+
+    // Indexed by Clipping::ClipType
+    const char* const clipTypeNames[] = { "Soft", "Hard", "Linear", "Exponential", "Asymmetric", "Saturation",
+                                          "Tanh", "Arctan", "Algebraic", "CubicKnee", "QuinticKnee", "SineFold", "Custom" };
+    constexpr int numClipTypes = static_cast<int>(std::size(clipTypeNames));
+
+    struct Configuration
+    {
+        const char* name;
+        ProcessingQuality quality;
+    };
+
+    // Cheapest first. "2x iir" is what the plugin runs live, "8x fir exact" offline.
+    const Configuration configurations[] = {
+        { "host rate",    { 0, false, false } },
+        { "2x iir",       ProcessingQuality::realtime() },
+        { "2x fir",       { 1, true, false } },
+        { "4x iir",       { 2, false, false } },
+        { "4x fir",       { 2, true, false } },
+        { "8x iir",       { 3, false, false } },
+        { "8x fir exact", ProcessingQuality::offline() },
+    };
+
+    struct Config
+    {
+        double sampleRate = 48000.0;
+        float driveDecibels = 12.0f; // input peak over the threshold
+        float kneeWidth = 0.5f;
+        std::optional<double> maxThd, maxAliasing, maxImd; // unset: no target
+        juce::File output;
+    };
+
+    struct Result
+    {
+        double thd = 0.0;
+        double aliasing = 0.0;
+        double aliasingPerStep[std::size(sweepFrequencies)] = {};
+        double imd = 0.0;
+        double nanosPerSample = 0.0;
+    };
+
+    // The processor's clip path for one configuration, mono
+    class ClipChain
+    {
+    public:
+        ClipChain(const ProcessingQuality& quality, const Config& config, Clipping::ClipType type,
+                  const ClipKernels::CurveSegments* customCurve)
+            : clipType(type)
+        {
+            const int factor = quality.getOversamplingFactor();
+            if (quality.oversamplingOrder > 0) {
+                const auto filterType = quality.linearPhaseFilters
+                    ? juce::dsp::Oversampling<float>::filterHalfBandFIREquiripple
+                    : juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR;
+                oversampler = std::make_unique<juce::dsp::Oversampling<float>>(1, quality.oversamplingOrder, filterType, true, true);
+                oversampler->initProcessing(static_cast<size_t>(blockSize));
+            }
+
+            clipping.prepare(config.sampleRate * factor, blockSize * factor);
+            clipping.setThreshold(inputPeak * juce::Decibels::decibelsToGain(-config.driveDecibels));
+            clipping.setKneeWidth(config.kneeWidth);
+            clipping.setUseExactCurves(quality.exactCurves);
+            clipping.setCustomCurve(customCurve);
+        }
+
+        // numSamples <= blockSize
+        void process(float* data, int numSamples)
+        {
+            float* paths[] = { data };
+            if (oversampler == nullptr) {
+                clipping.processBlock(paths, 1, numSamples, clipType);
+                return;
+            }
+
+            juce::dsp::AudioBlock<float> block(paths, 1, static_cast<size_t>(numSamples));
+            auto oversampledBlock = oversampler->processSamplesUp(block);
+            float* oversampledPaths[] = { oversampledBlock.getChannelPointer(0) };
+            clipping.processBlock(oversampledPaths, 1, static_cast<int>(oversampledBlock.getNumSamples()), clipType);
+            oversampler->processSamplesDown(block);
+        }
+
+    private:
+        std::unique_ptr<juce::dsp::Oversampling<float>> oversampler;
+        Clipping clipping;
+        Clipping::ClipType clipType;
+    };
+
+    int toBin(double frequency, double sampleRate)
+    {
+        return juce::roundToInt(frequency * fftSize / sampleRate);
+    }
+
+    // One FFT frame of a sum of sines, all on exact bins, so it tiles seamlessly
+    std::vector<float> makeFrame(std::initializer_list<int> bins, float peak)
+    {
+        std::vector<float> frame(fftSize, 0.0f);
+        const float amplitude = peak / static_cast<float>(bins.size());
+        for (int n = 0; n < fftSize; ++n) {
+            double sum = 0.0;
+            for (int bin : bins)
+                sum += std::sin(juce::MathConstants<double>::twoPi * static_cast<double>((static_cast<juce::int64>(bin) * n) % fftSize) / fftSize);
+            frame[static_cast<size_t>(n)] = static_cast<float>(amplitude * sum);
+        }
+        return frame;
+    }
+
+    // Power per bin of the chain's output for the periodic stimulus, after settling
+    std::vector<double> renderSpectrum(ClipChain& chain, const std::vector<float>& frame, double sampleRate)
+    {
+        const int settleSamples = juce::roundToInt(sampleRate * 0.5);
+        const int totalSamples = settleSamples + fftSize;
+        std::vector<float> output(static_cast<size_t>(2 * fftSize), 0.0f);
+        float block[blockSize];
+
+        for (int position = 0; position < totalSamples; position += blockSize) {
+            const int numSamples = juce::jmin(blockSize, totalSamples - position);
+            for (int i = 0; i < numSamples; ++i)
+                block[i] = frame[static_cast<size_t>((position + i) % fftSize)];
+
+            chain.process(block, numSamples);
+
+            for (int i = 0; i < numSamples; ++i)
+                if (position + i >= settleSamples)
+                    output[static_cast<size_t>(position + i - settleSamples)] = block[i];
+        }
+
+        juce::dsp::FFT fft(fftOrder);
+        fft.performFrequencyOnlyForwardTransform(output.data());
+
+        std::vector<double> power(static_cast<size_t>(fftSize / 2 + 1));
+        for (size_t bin = 0; bin < power.size(); ++bin)
+            power[bin] = static_cast<double>(output[bin]) * output[bin];
+        return power;
+    }
+
+    double toDecibels(double ratio)
+    {
+        return 10.0 * std::log10(juce::jmax(ratio, 1.0e-30));
+    }
+
+    double measureThd(ClipChain& chain, double sampleRate)
+    {
+        const int fundamental = toBin(1000.0, sampleRate);
+        const auto power = renderSpectrum(chain, makeFrame({ fundamental }, inputPeak), sampleRate);
+
+        double harmonics = 0.0;
+        for (int bin = 2 * fundamental; bin < fftSize / 2; bin += fundamental)
+            harmonics += power[static_cast<size_t>(bin)];
+        return toDecibels(harmonics / power[static_cast<size_t>(fundamental)]);
+    }
+
+    double measureAliasing(ClipChain& chain, double sampleRate, double frequency)
+    {
+        const int fundamental = toBin(frequency, sampleRate);
+        const auto power = renderSpectrum(chain, makeFrame({ fundamental }, inputPeak), sampleRate);
+
+        double aliases = 0.0;
+        for (int bin = juce::jmax(1, toBin(lowestAnalysedFrequency, sampleRate)); bin < fundamental; ++bin)
+            aliases += power[static_cast<size_t>(bin)];
+        return toDecibels(aliases / power[static_cast<size_t>(fundamental)]);
+    }
+
+    double measureImd(ClipChain& chain, double sampleRate)
+    {
+        const int low = toBin(19000.0, sampleRate);
+        const int high = toBin(20000.0, sampleRate);
+        const auto power = renderSpectrum(chain, makeFrame({ low, high }, inputPeak), sampleRate);
+
+        // m * high - n * low and m * low - n * high for orders 2 to 5, in band
+        std::vector<int> products;
+        for (int m = 1; m <= 4; ++m) {
+            for (int n = 1; m + n <= 5; ++n) {
+                for (int bin : { m * high - n * low, m * low - n * high }) {
+                    if (bin >= toBin(lowestAnalysedFrequency, sampleRate) && bin < fftSize / 2 && bin != low && bin != high
+                        && std::find(products.begin(), products.end(), bin) == products.end())
+                        products.push_back(bin);
+                }
+            }
+        }
+
+        double distortion = 0.0;
+        for (int bin : products)
+            distortion += power[static_cast<size_t>(bin)];
+        return toDecibels(distortion / (power[static_cast<size_t>(low)] + power[static_cast<size_t>(high)]));
+    }
+
+    double measureNanosPerSample(ClipChain& chain, double sampleRate)
+    {
+        const auto frame = makeFrame({ toBin(1000.0, sampleRate) }, inputPeak);
+        float block[blockSize];
+        constexpr int blocks = 2000;
+
+        auto run = [&](int numBlocks) {
+            for (int b = 0; b < numBlocks; ++b) {
+                std::copy(frame.begin() + (b * blockSize) % fftSize, frame.begin() + (b * blockSize) % fftSize + blockSize, block);
+                chain.process(block, blockSize);
+            }
+        };
+
+        run(blocks / 10);
+        const auto start = std::chrono::steady_clock::now();
+        run(blocks);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / (double(blocks) * blockSize);
+    }
+
+    bool meetsTargets(const Result& result, const Config& config)
+    {
+        return (! config.maxThd || result.thd <= *config.maxThd)
+            && (! config.maxAliasing || result.aliasing <= *config.maxAliasing)
+            && (! config.maxImd || result.imd <= *config.maxImd);
+    }
+
+    Config parseArguments(const juce::ArgumentList& arguments)
+    {
+        Config config;
+        auto doubleOption = [&](const char* option, double fallback) {
+            const auto value = arguments.getValueForOption(option);
+            return value.isEmpty() ? fallback : value.getDoubleValue();
+        };
+        auto targetOption = [&](const char* option) -> std::optional<double> {
+            const auto value = arguments.getValueForOption(option);
+            if (value.isEmpty())
+                return std::nullopt;
+            return value.getDoubleValue();
+        };
+
+        config.sampleRate = juce::jlimit(44100.0, 192000.0, doubleOption("--sample-rate", config.sampleRate));
+        config.driveDecibels = static_cast<float>(juce::jlimit(0.0, 24.0, doubleOption("--drive", config.driveDecibels)));
+        config.kneeWidth = static_cast<float>(juce::jlimit(0.0, 1.0, doubleOption("--knee", config.kneeWidth)));
+        config.maxThd = targetOption("--max-thd");
+        config.maxAliasing = targetOption("--max-aliasing");
+        config.maxImd = targetOption("--max-imd");
+
+        const auto output = arguments.getValueForOption("--output|-o");
+        if (output.isNotEmpty())
+            config.output = juce::File::getCurrentWorkingDirectory().getChildFile(output);
+
+        return config;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto config = parseArguments(juce::ArgumentList(argc, argv));
+
+    // The Custom type runs the default curve
+    ClipKernels::CurveSegments customSegments;
+    CustomCurve::compile(CustomCurve::sanitise(CustomCurve::getDefaultPoints()), customSegments);
+
+    std::cerr << "Klip analyzer: " << config.sampleRate << " Hz, drive " << config.driveDecibels << " dB, kernels "
+              << ClipKernels::get().name << std::endl;
+    std::cerr << juce::String("curve").paddedRight(' ', 13) << juce::String("config").paddedRight(' ', 14)
+              << "     thd  aliasing       imd   ns/sample" << std::endl;
+
+    juce::Array<juce::var> curves;
+    for (int type = 0; type < numClipTypes; ++type) {
+        const auto clipType = static_cast<Clipping::ClipType>(type);
+        juce::Array<juce::var> results;
+        juce::var recommended;
+        double recommendedNanos = 0.0;
+
+        for (const auto& configuration : configurations) {
+            auto makeChain = [&] { return std::make_unique<ClipChain>(configuration.quality, config, clipType, &customSegments); };
+            Result result;
+
+            // A fresh chain per stimulus so no measurement inherits another's state
+            result.thd = measureThd(*makeChain(), config.sampleRate);
+            result.imd = measureImd(*makeChain(), config.sampleRate);
+            result.aliasing = -300.0;
+            juce::Array<juce::var> steps;
+            for (size_t step = 0; step < std::size(sweepFrequencies); ++step) {
+                result.aliasingPerStep[step] = measureAliasing(*makeChain(), config.sampleRate, sweepFrequencies[step]);
+                result.aliasing = juce::jmax(result.aliasing, result.aliasingPerStep[step]);
+
+                auto* stepObject = new juce::DynamicObject();
+                stepObject->setProperty("frequency", sweepFrequencies[step]);
+                stepObject->setProperty("aliasingDb", result.aliasingPerStep[step]);
+                steps.add(juce::var(stepObject));
+            }
+            result.nanosPerSample = measureNanosPerSample(*makeChain(), config.sampleRate);
+
+            std::cerr << juce::String(clipTypeNames[type]).paddedRight(' ', 13) << juce::String(configuration.name).paddedRight(' ', 14)
+                      << juce::String(result.thd, 1).paddedLeft(' ', 8) << juce::String(result.aliasing, 1).paddedLeft(' ', 10)
+                      << juce::String(result.imd, 1).paddedLeft(' ', 10) << juce::String(result.nanosPerSample, 2).paddedLeft(' ', 12)
+                      << std::endl;
+
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty("config", configuration.name);
+            entry->setProperty("oversampling", configuration.quality.getOversamplingFactor());
+            entry->setProperty("linearPhase", configuration.quality.linearPhaseFilters);
+            entry->setProperty("exactCurves", configuration.quality.exactCurves);
+            entry->setProperty("thdDb", result.thd);
+            entry->setProperty("aliasingDb", result.aliasing);
+            entry->setProperty("aliasingSweep", steps);
+            entry->setProperty("imdDb", result.imd);
+            entry->setProperty("nanosPerSample", result.nanosPerSample);
+            entry->setProperty("meetsTargets", meetsTargets(result, config));
+            results.add(juce::var(entry));
+
+            if (meetsTargets(result, config) && (recommended.isVoid() || result.nanosPerSample < recommendedNanos)) {
+                recommended = configuration.name;
+                recommendedNanos = result.nanosPerSample;
+            }
+        }
+
+        auto* curve = new juce::DynamicObject();
+        curve->setProperty("clipType", clipTypeNames[type]);
+        curve->setProperty("recommended", recommended);
+        curve->setProperty("results", results);
+        curves.add(juce::var(curve));
+
+        std::cerr << "  -> " << (recommended.isVoid() ? juce::String("no configuration meets the targets") : recommended.toString()) << std::endl;
+    }
+
+    auto* targets = new juce::DynamicObject();
+    targets->setProperty("maxThdDb", config.maxThd ? juce::var(*config.maxThd) : juce::var());
+    targets->setProperty("maxAliasingDb", config.maxAliasing ? juce::var(*config.maxAliasing) : juce::var());
+    targets->setProperty("maxImdDb", config.maxImd ? juce::var(*config.maxImd) : juce::var());
+
+    auto* configObject = new juce::DynamicObject();
+    configObject->setProperty("sampleRate", config.sampleRate);
+    configObject->setProperty("driveDb", config.driveDecibels);
+    configObject->setProperty("kneeWidth", config.kneeWidth);
+    configObject->setProperty("inputPeak", inputPeak);
+    configObject->setProperty("fftSize", fftSize);
+    configObject->setProperty("kernels", juce::String(ClipKernels::get().name));
+    configObject->setProperty("cpu", juce::SystemStats::getCpuModel());
+    configObject->setProperty("targets", juce::var(targets));
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("config", juce::var(configObject));
+    report->setProperty("curves", curves);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+    if (config.output == juce::File())
+        std::cout << json << std::endl;
+    else
+        config.output.replaceWithText(json);
+
+    return 0;
+}
@@ -0,0 +1,431 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Micro-benchmark for the clip kernels: every compiled ISA variant against
+    the scalar per-sample path, reported in ns/sample together with the largest
+    deviation from the scalar reference curve, then the filter, transient
+    detector and dither kernels, the block path with and without the
+    transient split, and a StagePipeline chain run fused in sub-blocks
+    against the same stages one pass each. The last sections time
+    constructing and preparing processor instances, run the whole processor
+    and the klip_dsp C API, and exit with 1 if processBlock or klip_process_*
+    touched the heap.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <thread>
+#include "../../Source/Clipping.h"
+#include "../../Source/ClipKernels.h"
+#include "../../Source/CustomCurve.h"
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/AllocationGuard.h"
+#include "../../Source/MultiChannelFilter.h"
+#include "../../Source/OutputDither.h"
+#include "../../Source/TransientDetector.h"
+#include "../../Source/KlipDsp.h"
+#include "../../Source/MidSide.h"
+#include "../../Source/StagePipeline.h"
+
+namespace
+{
+    constexpr int blockSize = 512;
+    constexpr int iterations = 4000;
+    constexpr float threshold = 0.25f;
+    constexpr float kneeWidth = 0.5f;
+
+    // Indexed by Clipping::ClipType
+    const char* const clipTypeNames[] = { "Soft", "Hard", "Linear", "Exponential", "Asymmetric", "Saturation",
+                                          "Tanh", "Arctan", "Algebraic", "CubicKnee", "QuinticKnee", "SineFold", "Custom" };
+    constexpr int numClipTypes = static_cast<int>(std::size(clipTypeNames));
+
+    // The Custom type runs the default curve, compiled at startup
+    ClipKernels::CurveSegments customSegments;
+    const ClipKernels::CurveShape curveShape { threshold, kneeWidth, &customSegments };
+
+    // Runs fn(iteration) on `iterations` blocks' worth of samples, samplesPerCall
+    // at a time, and returns the average ns per sample.
+    template <typename Fn>
+    double measure(Fn&& fn, int samplesPerCall = blockSize)
+    {
+        const int calls = std::max(1, static_cast<int>(static_cast<long long>(iterations) * blockSize / samplesPerCall));
+        for (int i = 0; i < std::max(1, calls / 10); ++i)
+            fn(i);
+
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i)
+            fn(i);
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+
+        return std::chrono::duration<double, std::nano>(elapsed).count() / (double(calls) * samplesPerCall);
+    }
+
+    // The klip_dsp stereo chain as StagePipeline stages over a context of its own
+    struct ChainContext
+    {
+        Clipping clipping;
+        OutputDither dither;
+    };
+
+    struct ChainClipStage
+    {
+        static void process(ChainContext& context, float* const* channels, int, int numSamples)
+        {
+            context.clipping.processBlock(channels, 2, numSamples, Clipping::TanhClip);
+        }
+    };
+
+    struct ChainDitherStage
+    {
+        static void process(ChainContext& context, float* const* channels, int numChannels, int numSamples)
+        {
+            context.dither.processBlock(channels, numChannels, numSamples);
+        }
+    };
+
+    using StereoChain = StagePipeline::Chain<64, MidSide::EncodeStage<MidSide::Both>, ChainClipStage,
+                                             MidSide::DecodeStage<MidSide::Both>, ChainDitherStage>;
+
+    void printRow(const juce::String& variant, const juce::String& curve, double nanosPerSample, double maxError = -1.0)
+    {
+        std::cout << variant.paddedRight(' ', 14) << curve.paddedRight(' ', 14)
+                  << juce::String(nanosPerSample, 3) << " ns/sample";
+
+        if (maxError >= 0.0)
+            std::cout << "   max error " << juce::String(maxError, 9);
+
+        std::cout << std::endl;
+    }
+
+    void printMicros(const juce::String& variant, const juce::String& what, double micros)
+    {
+        std::cout << variant.paddedRight(' ', 14) << what.paddedRight(' ', 14) << juce::String(micros, 1) << " us" << std::endl;
+    }
+
+    double microsSince(std::chrono::steady_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Largest difference between a kernel and Clipping::processClip over +-4x the threshold
+    double measureMaxError(const ClipKernels::Table& table, int clipType)
+    {
+        Clipping reference;
+        reference.setThreshold(threshold);
+        reference.setKneeWidth(kneeWidth);
+        reference.setCustomCurve(&customSegments);
+
+        double maxError = 0.0;
+        for (int i = -4000; i <= 4000; ++i) {
+            float x = static_cast<float>(i) * threshold / 1000.0f;
+            const float expected = std::abs(x) < 1.0e-8f ? 0.0f : reference.processClip(x, static_cast<Clipping::ClipType>(clipType));
+            table.clip(&x, 1, clipType, curveShape);
+            maxError = std::max(maxError, static_cast<double>(std::abs(x - expected)));
+        }
+
+        return maxError;
+    }
+}
+
+int main()
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::Random random(1234);
+    std::vector<float> input(blockSize);
+    for (auto& sample : input)
+        sample = random.nextFloat() * 2.0f - 1.0f;
+
+    std::vector<float> work(blockSize);
+    volatile float sink = 0.0f;
+
+    CustomCurve::compile(CustomCurve::sanitise(CustomCurve::getDefaultPoints()), customSegments);
+
+    std::cout << "Selected kernels: " << ClipKernels::get().name << std::endl << std::endl;
+
+    // Scalar reference: the original one-sample-at-a-time path
+    for (int type = 0; type < numClipTypes; ++type) {
+        Clipping clipping;
+        clipping.prepare(48000.0, blockSize);
+        clipping.setThreshold(threshold);
+        clipping.setKneeWidth(kneeWidth);
+        clipping.setCustomCurve(&customSegments);
+        const auto clipType = static_cast<Clipping::ClipType>(type);
+
+        printRow("scalar", clipTypeNames[type], measure([&](int) {
+            for (size_t i = 0; i < work.size(); ++i)
+                work[i] = clipping.processSample(input[i], clipType);
+            sink = sink + work[0];
+        }));
+    }
+
+    // Raw curve kernels for every ISA the build and the CPU support
+    for (auto isa : { ClipKernels::Isa::Baseline, ClipKernels::Isa::AVX2, ClipKernels::Isa::AVX512, ClipKernels::Isa::NEON }) {
+        const auto* table = ClipKernels::getForIsa(isa);
+        if (table == nullptr)
+            continue;
+
+        for (int type = 0; type < numClipTypes; ++type) {
+            printRow(table->name, clipTypeNames[type], measure([&](int) {
+                std::copy(input.begin(), input.end(), work.begin());
+                table->clip(work.data(), blockSize, type, curveShape);
+                sink = sink + work[0];
+            }), measureMaxError(*table, type));
+        }
+    }
+
+    // Filters: two channels (mid/side) in one pass through the lane kernels
+    for (auto type : { MultiChannelFilter::OnePoleHighPass, MultiChannelFilter::AllPass }) {
+        MultiChannelFilter filter;
+        filter.setup(type, 48000.0, 1000.0f);
+        std::vector<float> second(input);
+        float* channels[] = { work.data(), second.data() };
+
+        printRow("filter x2", type == MultiChannelFilter::AllPass ? "svf allpass" : "onepole hp", measure([&](int) {
+            std::copy(input.begin(), input.end(), work.begin());
+            filter.processBlock(channels, 2, blockSize);
+            sink = sink + work[0];
+        }));
+    }
+
+    // Transient detector: the raw kernel for every ISA on four lanes of interleaved
+    // frames, then two channels through TransientDetector (interleave included)
+    for (auto isa : { ClipKernels::Isa::Baseline, ClipKernels::Isa::AVX2, ClipKernels::Isa::AVX512, ClipKernels::Isa::NEON }) {
+        const auto* table = ClipKernels::getForIsa(isa);
+        if (table == nullptr)
+            continue;
+
+        ClipKernels::TransientCoefficients coefficients {};
+        for (int lane = 0; lane < ClipKernels::filterLanes; ++lane) {
+            coefficients.fastAttack[lane] = 0.1f;
+            coefficients.slowAttack[lane] = 0.001f;
+            coefficients.release[lane] = 0.0001f;
+            coefficients.sensitivity[lane] = 2.0f;
+        }
+
+        std::vector<float> frames(static_cast<size_t>(blockSize) * ClipKernels::filterLanes);
+        float state[2 * ClipKernels::filterLanes] = {};
+
+        printRow(table->name, "transients x4", measure([&](int) {
+            for (size_t i = 0; i < input.size(); ++i)
+                std::fill_n(frames.data() + i * ClipKernels::filterLanes, ClipKernels::filterLanes, input[i]);
+            table->transientWeights(frames.data(), blockSize, coefficients, state);
+            sink = sink + frames[0];
+        }));
+    }
+
+    {
+        TransientDetector detector;
+        detector.setSampleRate(48000.0);
+        std::vector<float> second(input), weights(blockSize), secondWeights(blockSize);
+        const float* channels[] = { input.data(), second.data() };
+        float* channelWeights[] = { weights.data(), secondWeights.data() };
+
+        printRow("detector x2", "transients", measure([&](int) {
+            detector.process(channels, 2, blockSize, channelWeights);
+            sink = sink + weights[0];
+        }));
+    }
+
+    // Output dither on two channels, 16 bit, for each noise shaping curve
+    const char* const shapeNames[] = { "tpdf flat", "tpdf hp", "tpdf e-wt", "tpdf f-wt" };
+    for (auto shape : { OutputDither::Flat, OutputDither::Highpass, OutputDither::EWeighted, OutputDither::FWeighted }) {
+        OutputDither dither;
+        dither.setup(44100.0, 16, shape);
+        std::vector<float> second(input);
+        float* channels[] = { work.data(), second.data() };
+
+        printRow("dither x2", shapeNames[shape], measure([&](int) {
+            std::copy(input.begin(), input.end(), work.begin());
+            dither.processBlock(channels, 2, blockSize);
+            sink = sink + work[0];
+        }));
+    }
+
+    // Full block path (DC removal + curve) with the selected kernels
+    for (int type = 0; type < numClipTypes; ++type) {
+        Clipping clipping;
+        clipping.prepare(48000.0, blockSize);
+        clipping.setThreshold(threshold);
+        clipping.setKneeWidth(kneeWidth);
+        clipping.setCustomCurve(&customSegments);
+        const auto clipType = static_cast<Clipping::ClipType>(type);
+        float* paths[] = { work.data() };
+
+        printRow("block", clipTypeNames[type], measure([&](int) {
+            std::copy(input.begin(), input.end(), work.begin());
+            clipping.processBlock(paths, 1, blockSize, clipType);
+            sink = sink + work[0];
+        }));
+    }
+
+    // Transient split on top of the block path: detector, second curve (hard) and the weighted mix
+    for (int type = 0; type < numClipTypes; ++type) {
+        Clipping clipping;
+        clipping.prepare(48000.0, blockSize);
+        clipping.setThreshold(threshold);
+        clipping.setKneeWidth(kneeWidth);
+        clipping.setCustomCurve(&customSegments);
+        clipping.setTransientSplit(true, Clipping::HardClip, threshold * 1.5f);
+        const auto clipType = static_cast<Clipping::ClipType>(type);
+        float* paths[] = { work.data() };
+
+        printRow("block split", clipTypeNames[type], measure([&](int) {
+            std::copy(input.begin(), input.end(), work.begin());
+            clipping.processBlock(paths, 1, blockSize, clipType);
+            sink = sink + work[0];
+        }));
+    }
+
+    // Fused against per-stage: encode, clip, decode and dither on two channels. Per
+    // stage streams the block through memory four times, which starts to cost once
+    // it outgrows the caches; fused keeps each 64-sample sub-block in L1.
+    for (int chainBlockSize : { 512, 8192, 65536 }) {
+        std::vector<float> left(static_cast<size_t>(chainBlockSize)), right(left);
+        std::vector<float> sourceLeft(left.size()), sourceRight(left.size());
+        for (size_t i = 0; i < left.size(); ++i) {
+            sourceLeft[i] = random.nextFloat() * 2.0f - 1.0f;
+            sourceRight[i] = random.nextFloat() * 2.0f - 1.0f;
+        }
+        float* channels[] = { left.data(), right.data() };
+
+        for (bool fused : { true, false }) {
+            ChainContext context;
+            context.clipping.prepare(48000.0, chainBlockSize);
+            context.clipping.setThreshold(threshold);
+            context.dither.setup(48000.0, 16, OutputDither::Highpass);
+
+            printRow(fused ? "chain fused" : "chain staged", juce::String(chainBlockSize) + " x2", measure([&](int) {
+                std::copy(sourceLeft.begin(), sourceLeft.end(), left.begin());
+                std::copy(sourceRight.begin(), sourceRight.end(), right.begin());
+                if (fused)
+                    StereoChain::process(context, channels, 2, chainBlockSize);
+                else
+                    StereoChain::processPerStage(context, channels, 2, chainBlockSize);
+                sink = sink + left[0];
+            }, chainBlockSize));
+        }
+    }
+
+    // Instantiation with the default settings, averaged over a session's worth of
+    // instances; then how long a running instance takes to get the spectral engine
+    // built in the background once it's selected (blocks keep going meanwhile)
+    {
+        constexpr int numInstances = 32;
+        std::vector<std::unique_ptr<KlipAudioProcessor>> instances;
+        double constructMicros = 0.0;
+        double prepareMicros = 0.0;
+
+        for (int i = 0; i < numInstances; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            instances.push_back(std::make_unique<KlipAudioProcessor>());
+            constructMicros += microsSince(start);
+
+            start = std::chrono::steady_clock::now();
+            instances.back()->setPlayConfigDetails(2, 2, 48000.0, blockSize);
+            instances.back()->prepareToPlay(48000.0, blockSize);
+            prepareMicros += microsSince(start);
+        }
+
+        std::cout << std::endl;
+        printMicros("instance", "construct", constructMicros / numInstances);
+        printMicros("instance", "prepare", prepareMicros / numInstances);
+
+        auto& instance = *instances.front();
+        juce::AudioBuffer<float> block(2, blockSize);
+        juce::MidiBuffer midi;
+        instance.getParameters().getParameter("engine")->setValueNotifyingHost(1.0f);
+
+        const auto start = std::chrono::steady_clock::now();
+        while (! instance.isSpectralEngineReady() && microsSince(start) < 5.0e6) {
+            block.clear();
+            instance.processBlock(block, midi);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        printMicros("instance", "spectral ready", microsSince(start));
+        std::cout << std::endl;
+    }
+
+    // Whole processor with parameters changing every few blocks. Prepared on the
+    // spectral engine so it's built up front: the timing must not depend on when
+    // the background builder gets to it.
+    KlipAudioProcessor processor;
+    processor.getParameters().getParameter("engine")->setValueNotifyingHost(1.0f);
+    processor.setPlayConfigDetails(2, 2, 48000.0, blockSize);
+    processor.prepareToPlay(48000.0, blockSize);
+
+    juce::AudioBuffer<float> buffer(2, blockSize);
+    juce::MidiBuffer midi;
+    auto& parameters = processor.getParameters();
+    const int violationsBefore = ScopedAllocationGuard::getViolationCount();
+
+    printRow("processor", "random params", measure([&](int iteration) {
+        if (iteration % 16 == 0) {
+            for (auto* parameterID : { "threshold", "clipType", "msProcessing", "kneeWidth", "dcCutoff", "engine", "fftSize", "fftOverlap",
+                                       "transientSplit", "transientClipType", "transientThreshold", "transientLookahead", "mix" })
+                parameters.getParameter(parameterID)->setValueNotifyingHost(random.nextFloat());
+        }
+
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(channel), input.data(), blockSize);
+
+        processor.processBlock(buffer, midi);
+    }));
+
+    // Same, with timestamped threshold/clip type changes splitting every block
+    const int thresholdIndex = parameters.getParameter("threshold")->getParameterIndex();
+    const int clipTypeIndex = parameters.getParameter("clipType")->getParameterIndex();
+
+    printRow("processor", "param events", measure([&](int iteration) {
+        const KlipAudioProcessor::ParameterEvent events[] = {
+            { 37, thresholdIndex, random.nextFloat() },
+            { 200, clipTypeIndex, static_cast<float>(iteration % 11) / 10.0f },
+            { 401, thresholdIndex, random.nextFloat() }
+        };
+
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::copy(buffer.getWritePointer(channel), input.data(), blockSize);
+
+        processor.processBlockWithParameterEvents(buffer, events, static_cast<int>(std::size(events)));
+    }));
+
+    // The library on its own through the C API: stereo, mid+side, default settings
+    klip_config config;
+    klip_config_init(&config);
+    config.sample_rate = 48000.0;
+    config.max_block_size = blockSize;
+
+    klip_processor* dsp = nullptr;
+    if (klip_create(&config, &dsp) != KLIP_OK)
+        return 1;
+
+    std::vector<float> interleaved(static_cast<size_t>(blockSize) * 2);
+    float* channels[] = { buffer.getWritePointer(0), buffer.getWritePointer(1) };
+
+    printRow("c api", "planar", measure([&](int) {
+        for (int channel = 0; channel < 2; ++channel)
+            juce::FloatVectorOperations::copy(channels[channel], input.data(), blockSize);
+
+        ScopedAllocationGuard guard;
+        klip_process_planar(dsp, channels, 2, blockSize);
+    }));
+
+    printRow("c api", "interleaved", measure([&](int) {
+        for (size_t i = 0; i < input.size(); ++i)
+            interleaved[2 * i] = interleaved[2 * i + 1] = input[i];
+
+        ScopedAllocationGuard guard;
+        klip_process_interleaved(dsp, interleaved.data(), 2, blockSize);
+    }));
+
+    klip_destroy(dsp);
+
+    const int allocations = ScopedAllocationGuard::getViolationCount() - violationsBefore;
+    std::cout << std::endl << "Heap allocations inside processBlock and klip_process_*: " << allocations << std::endl;
+
+    return allocations == 0 ? 0 : 1;
+}
@@ -0,0 +1,741 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Offline command line front end for KlipAudioProcessor.
+
+    process  Renders a file through the processor in offline quality, latency
+             compensated. --set takes plain parameter values (threshold=0.4,
+             clipType=3, dcCutoff=20, ...). --auto-threshold analyses the
+             file first, on the same read: the threshold is set to the level
+             that P percent of its 5 ms peaks exceed (mid/side as the clipper
+             sees them), then the file is rendered with it.
+
+    replay   Feeds a flight recorder capture back through the processor block
+             by block: same block sizes, parameter values, governor levels and
+             realtime/offline flag as when it was recorded. Every output block
+             is hashed and compared with the recorded hash, and the timing of
+             each pass is reported next to the recorded one for profiling.
+
+    sweep    Renders one file at every point of a parameter grid (--grid, one
+             axis per parameter, all combinations) in offline quality. The
+             input is decoded once; worker threads each take a share of the
+             variants and run all of theirs on a block before the next. Writes
+             one WAV per variant and sweep.json with integrated loudness
+             (BS.1770), sample peak and RMS for every variant and the input.
+
+    Usage: KlipCli process <input> <output.wav> [--block-size N] [--set id=value ...] [--auto-threshold P]
+           KlipCli replay <capture.klipcapture> [--repeat N] [--output out.wav]
+           KlipCli sweep <input> <output dir> --grid id=v1,v2,... [--grid ...]
+                         [--set id=value ...] [--block-size N] [--threads T]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/FlightRecorder.h"
+#include "../../Source/ClipKernels.h"
+#include "../../Source/PeakSketch.h"
+#include "../../Source/MidSide.h"
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    int fail(const juce::String& message)
+    {
+        std::cerr << message << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<juce::AudioFormatWriter> createWavWriter(const juce::File& file, double sampleRate, int numChannels)
+    {
+        file.deleteFile();
+        auto stream = std::make_unique<juce::FileOutputStream>(file);
+        if (! stream->openedOk())
+            return nullptr;
+
+        juce::WavAudioFormat wav;
+        std::unique_ptr<juce::AudioFormatWriter> writer(
+            wav.createWriterFor(stream.get(), sampleRate, static_cast<unsigned int>(numChannels), 32, {}, 0));
+        if (writer != nullptr)
+            stream.release(); // owned by the writer now
+        return writer;
+    }
+
+    bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& audio, double sampleRate)
+    {
+        auto writer = createWavWriter(file, sampleRate, audio.getNumChannels());
+        return writer != nullptr && writer->writeFromAudioSampleBuffer(audio, 0, audio.getNumSamples());
+    }
+
+    // Level (dBFS) exceeded by `percent` of the file's peaks, on the paths the
+    // clipper will get. Every peak of the file counts the same.
+    float analysePeaks(const juce::AudioBuffer<float>& audio, int length, double sampleRate, MidSide::Mode mode, double percent)
+    {
+        constexpr int chunkSize = 4096;
+        juce::AudioBuffer<float> chunk(2, chunkSize);
+        PeakSketch sketch;
+        sketch.prepare(sampleRate, 0.0);
+
+        for (int position = 0; position < length; position += chunkSize) {
+            const int count = juce::jmin(chunkSize, length - position);
+            for (int channel = 0; channel < 2; ++channel)
+                chunk.copyFrom(channel, 0, audio, channel, position, count);
+
+            MidSide::encode(mode, chunk.getWritePointer(0), chunk.getWritePointer(1), count);
+            sketch.process(chunk.getArrayOfReadPointers(), MidSide::getNumPaths(mode), count);
+        }
+
+        return sketch.getDecibelsExceededBy(percent * 0.01);
+    }
+
+    //==============================================================================
+    int runProcess(const juce::ArgumentList& arguments)
+    {
+        if (arguments.size() < 3)
+            return fail("Usage: KlipCli process <input> <output.wav> [--block-size N] [--set id=value ...] [--auto-threshold P]");
+
+        const auto inputFile = arguments[1].resolveAsFile();
+        const auto outputFile = arguments[2].resolveAsFile();
+
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(inputFile));
+        if (reader == nullptr)
+            return fail("Can't read " + inputFile.getFullPathName());
+
+        const int length = static_cast<int>(reader->lengthInSamples);
+        const double sampleRate = reader->sampleRate;
+        const auto blockSizeOption = arguments.getValueForOption("--block-size");
+        const int blockSize = juce::jlimit(16, 65536, blockSizeOption.isEmpty() ? 512 : blockSizeOption.getIntValue());
+
+        // Settings first: prepareToPlay builds what they use (the spectral engine)
+        // instead of leaving it to the background builder mid-render
+        KlipAudioProcessor processor;
+        for (int i = 1; i < arguments.size(); ++i) {
+            if (arguments[i] != "--set" || i + 1 >= arguments.size())
+                continue;
+
+            const auto assignment = arguments[++i].text;
+            const auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false);
+            auto* parameter = processor.getParameters().getParameter(parameterID);
+            if (parameter == nullptr)
+                return fail("Unknown parameter " + parameterID);
+
+            const float value = assignment.fromFirstOccurrenceOf("=", false, false).getFloatValue();
+            parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+        }
+
+        processor.setNonRealtime(true);
+        processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+        processor.prepareToPlay(sampleRate, blockSize);
+
+        // Mono files go to both channels; the tail flushes the latency out
+        const int latency = processor.getLatencySamples();
+        juce::AudioBuffer<float> audio(2, length + latency);
+        audio.clear();
+        reader->read(&audio, 0, length, 0, true, true);
+
+        // Analyse then process: a fixed threshold for the whole file instead of the streaming auto mode
+        const auto autoTarget = arguments.getValueForOption("--auto-threshold");
+        if (autoTarget.isNotEmpty()) {
+            auto& parameters = processor.getParameters();
+            const auto mode = static_cast<MidSide::Mode>(static_cast<int>(parameters.getRawParameterValue("msProcessing")->load()));
+            const float peakDecibels = analysePeaks(audio, length, sampleRate, mode, autoTarget.getDoubleValue());
+
+            // The threshold knob spans -24..0 dB
+            const float thresholdDecibels = juce::jlimit(-24.0f, 0.0f, peakDecibels);
+            parameters.getParameter("threshold")->setValueNotifyingHost((thresholdDecibels + 24.0f) / 24.0f);
+            parameters.getParameter("autoThreshold")->setValueNotifyingHost(0.0f);
+
+            std::cout << autoTarget << "% of peaks above " << juce::String(peakDecibels, 2) << " dBFS, threshold "
+                      << juce::String(thresholdDecibels, 2) << " dB" << std::endl;
+        }
+
+        juce::MidiBuffer midi;
+        const auto start = Clock::now();
+        for (int position = 0; position < audio.getNumSamples(); position += blockSize) {
+            const int count = juce::jmin(blockSize, audio.getNumSamples() - position);
+            juce::AudioBuffer<float> block(audio.getArrayOfWritePointers(), 2, position, count);
+            processor.processBlock(block, midi);
+        }
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        // The trim below is only right if the render kept the latency prepareToPlay reported
+        if (processor.getLatencySamples() != latency)
+            return fail("Latency changed during the render (" + juce::String(latency) + " to "
+                        + juce::String(processor.getLatencySamples()) + " samples)");
+
+        juce::AudioBuffer<float> output(2, length);
+        for (int channel = 0; channel < 2; ++channel)
+            output.copyFrom(channel, 0, audio, channel, latency, length);
+
+        if (! writeWav(outputFile, output, sampleRate))
+            return fail("Can't write " + outputFile.getFullPathName());
+
+        std::cout << "Processed " << length << " samples in " << seconds << " s ("
+                  << (length > 0 ? seconds * 1.0e9 / length : 0.0) << " ns/sample), latency " << latency << std::endl;
+        return 0;
+    }
+
+    //==============================================================================
+    struct ReplayPass
+    {
+        std::vector<uint64_t> hashes;
+        std::vector<double> micros;
+        juce::AudioBuffer<float> output;
+    };
+
+    ReplayPass replayOnce(const FlightRecorder::Capture& capture, bool keepOutput)
+    {
+        auto processor = std::make_unique<KlipAudioProcessor>();
+        if (! capture.customCurvePoints.empty())
+            processor->setCustomCurvePoints(capture.customCurvePoints);
+
+        // Raw values go straight into the atomics the processor reads, so they
+        // are bit for bit what the recorded blocks saw. The recorder stays off.
+        std::vector<std::atomic<float>*> values;
+        for (const auto& parameterID : capture.parameterIDs) {
+            auto* value = parameterID == "flightRecorder" ? nullptr : processor->getParameters().getRawParameterValue(parameterID);
+            if (value == nullptr && parameterID != "flightRecorder")
+                std::cerr << "Parameter " << parameterID << " no longer exists, ignored" << std::endl;
+            values.push_back(value);
+        }
+
+        auto applyRecord = [&](const FlightRecorder::BlockRecord& record) {
+            for (size_t i = 0; i < values.size(); ++i)
+                if (values[i] != nullptr)
+                    values[i]->store(record.parameters[i]);
+
+            processor->setLiveMode((record.flags & FlightRecorder::LiveMode) != 0);
+            processor->setNonRealtime((record.flags & FlightRecorder::NonRealtime) != 0);
+            processor->setQualityLevelOverride(record.qualityLevel);
+        };
+
+        // The first block's settings go in before prepareToPlay, as a host restores
+        // the session before playback: it builds what they use (the spectral engine)
+        // instead of the background builder, whenever it gets to it
+        applyRecord(capture.blocks.front());
+        processor->setPlayConfigDetails(capture.numChannels, capture.numChannels, capture.sampleRate, capture.maxBlockSize);
+        processor->prepareToPlay(capture.sampleRate, capture.maxBlockSize);
+
+        ReplayPass pass;
+        pass.hashes.reserve(capture.blocks.size());
+        pass.micros.reserve(capture.blocks.size());
+        if (keepOutput)
+            pass.output.setSize(capture.numChannels, capture.input.getNumSamples());
+
+        juce::AudioBuffer<float> block(capture.numChannels, capture.maxBlockSize);
+        juce::MidiBuffer midi;
+        int position = 0;
+
+        for (const auto& record : capture.blocks) {
+            applyRecord(record);
+
+            block.setSize(capture.numChannels, record.numSamples, false, false, true);
+            for (int channel = 0; channel < capture.numChannels; ++channel)
+                block.copyFrom(channel, 0, capture.input, channel, position, record.numSamples);
+
+            const auto start = Clock::now();
+            processor->processBlock(block, midi);
+            pass.micros.push_back(std::chrono::duration<double, std::micro>(Clock::now() - start).count());
+
+            bool nonFinite = false;
+            pass.hashes.push_back(FlightRecorder::hashBlock(block, capture.numChannels, record.numSamples, nonFinite));
+
+            if (keepOutput)
+                for (int channel = 0; channel < capture.numChannels; ++channel)
+                    pass.output.copyFrom(channel, position, block, channel, 0, record.numSamples);
+
+            position += record.numSamples;
+        }
+
+        return pass;
+    }
+
+    void printTiming(const char* label, const std::vector<double>& micros, int numSamples)
+    {
+        double total = 0.0, worst = 0.0;
+        for (auto value : micros) {
+            total += value;
+            worst = juce::jmax(worst, value);
+        }
+
+        std::cout << label << ": mean " << total / static_cast<double>(juce::jmax<size_t>(1, micros.size())) << " us/block, max " << worst
+                  << " us, " << (numSamples > 0 ? total * 1000.0 / numSamples : 0.0) << " ns/sample" << std::endl;
+    }
+
+    int runReplay(const juce::ArgumentList& arguments)
+    {
+        if (arguments.size() < 2)
+            return fail("Usage: KlipCli replay <capture.klipcapture> [--repeat N] [--output out.wav]");
+
+        const auto captureFile = arguments[1].resolveAsFile();
+        FlightRecorder::Capture capture;
+        if (! FlightRecorder::readCapture(captureFile, capture))
+            return fail("Can't read capture " + captureFile.getFullPathName());
+
+        const auto& blocks = capture.blocks;
+        const int numSamples = capture.input.getNumSamples();
+        const bool fromStart = blocks.front().sampleStart == 0;
+
+        std::cout << "Capture " << captureFile.getFileName() << " (" << capture.reason << "): " << blocks.size() << " blocks, "
+                  << numSamples / capture.sampleRate << " s @ " << capture.sampleRate << " Hz, " << capture.numChannels
+                  << " channels, recorded with " << capture.kernels << " kernels" << std::endl;
+
+        if (capture.kernels != juce::String(ClipKernels::get().name))
+            std::cout << "Warning: replaying with " << ClipKernels::get().name << " kernels, results may differ in the last bits" << std::endl;
+        if (! fromStart)
+            std::cout << "Starts " << blocks.front().sampleStart << " samples after prepareToPlay: the filter state "
+                      << "before it isn't in the capture, early blocks can differ until it settles" << std::endl;
+
+        // Neither the dither noise streams nor the FFT hop phase ever settle
+        const int ditherIndex = capture.parameterIDs.indexOf("ditherDepth");
+        const int engineIndex = capture.parameterIDs.indexOf("engine");
+        const bool unsettled = std::any_of(blocks.begin(), blocks.end(), [&](const FlightRecorder::BlockRecord& record) {
+            return (ditherIndex >= 0 && record.parameters[ditherIndex] >= 0.5f)
+                || (engineIndex >= 0 && record.parameters[engineIndex] >= 0.5f);
+        });
+        if (! fromStart && unsettled)
+            std::cout << "Uses dither or the spectral engine: their state isn't in the capture and never settles, "
+                      << "those blocks can only match in a capture that starts at prepareToPlay" << std::endl;
+
+        int flagged = 0;
+        std::vector<double> recordedMicros;
+        for (size_t b = 0; b < blocks.size(); ++b) {
+            recordedMicros.push_back(blocks[b].elapsedMicros);
+            const auto flags = blocks[b].flags;
+            if ((flags & (FlightRecorder::NonFiniteOutput | FlightRecorder::BudgetOverrun)) != 0 && ++flagged <= 20)
+                std::cout << "  block " << b << " @ " << blocks[b].sampleStart << ": "
+                          << ((flags & FlightRecorder::NonFiniteOutput) != 0 ? "non-finite output " : "")
+                          << ((flags & FlightRecorder::BudgetOverrun) != 0 ? "over budget " : "")
+                          << blocks[b].elapsedMicros << " us" << std::endl;
+        }
+
+        const auto repeatOption = arguments.getValueForOption("--repeat");
+        const int repeats = juce::jmax(1, repeatOption.isEmpty() ? 1 : repeatOption.getIntValue());
+        const auto outputOption = arguments.getValueForOption("--output|-o");
+
+        printTiming("Recorded", recordedMicros, numSamples);
+
+        bool deterministic = true;
+        ReplayPass first;
+        for (int repeat = 0; repeat < repeats; ++repeat) {
+            auto pass = replayOnce(capture, repeat == 0 && outputOption.isNotEmpty());
+            printTiming(("Replay " + juce::String(repeat + 1)).toRawUTF8(), pass.micros, numSamples);
+
+            if (repeat == 0)
+                first = std::move(pass);
+            else
+                deterministic = deterministic && pass.hashes == first.hashes;
+        }
+
+        // Blocks matching the recording, and the point from which all of them do
+        size_t matching = 0, convergedFrom = blocks.size();
+        for (size_t b = blocks.size(); b > 0; --b) {
+            if (first.hashes[b - 1] != blocks[b - 1].outputHash)
+                break;
+            convergedFrom = b - 1;
+        }
+        for (size_t b = 0; b < blocks.size(); ++b)
+            if (first.hashes[b] == blocks[b].outputHash)
+                ++matching;
+
+        std::cout << "Output: " << matching << "/" << blocks.size() << " blocks bit-exact";
+        if (convergedFrom < blocks.size())
+            std::cout << ", all of them from block " << convergedFrom;
+        std::cout << std::endl;
+
+        if (repeats > 1)
+            std::cout << "Repeated replays " << (deterministic ? "identical" : "DIFFER") << std::endl;
+
+        if (outputOption.isNotEmpty()) {
+            const auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(outputOption);
+            if (! writeWav(outputFile, first.output, capture.sampleRate))
+                return fail("Can't write " + outputFile.getFullPathName());
+        }
+
+        // From prepareToPlay there is no excuse for a difference
+        return (fromStart && matching != blocks.size()) || ! deterministic ? 2 : 0;
+    }
+
+    //==============================================================================
+    // ITU-R BS.1770-4 integrated loudness (K-weighting, 400 ms blocks every 100 ms,
+    // absolute and relative gates) plus sample peak and RMS, fed block by block.
+    class LoudnessMeter
+    {
+    public:
+        void prepare(double sampleRate, int channels)
+        {
+            numChannels = juce::jlimit(1, maxChannels, channels);
+            stepLength = juce::jmax(1, juce::roundToInt(sampleRate * 0.1));
+
+            // The two stages redesigned for any rate from their analog parameters;
+            // at 48 kHz they give the coefficients printed in the standard
+            const double pi = juce::MathConstants<double>::pi;
+
+            // Stage 1: high shelf, +4 dB above ~1.7 kHz
+            double k = std::tan(pi * 1681.974450955533 / sampleRate);
+            double q = 0.7071752369554196;
+            const double highGain = std::pow(10.0, 3.999843853973347 / 20.0);
+            const double bandGain = std::pow(highGain, 0.4996667741545416);
+            double a0 = 1.0 + k / q + k * k;
+            shelf = { (highGain + bandGain * k / q + k * k) / a0, 2.0 * (k * k - highGain) / a0, (highGain - bandGain * k / q + k * k) / a0,
+                      2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+
+            // Stage 2: RLB high-pass at ~38 Hz, numerator left unnormalised as in the standard
+            k = std::tan(pi * 38.13547087602444 / sampleRate);
+            q = 0.5003270373238773;
+            a0 = 1.0 + k / q + k * k;
+            highPass = { 1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0, (1.0 - k / q + k * k) / a0 };
+        }
+
+        void process(const juce::AudioBuffer<float>& buffer, int start, int numSamples)
+        {
+            for (int i = start; i < start + numSamples; ++i) {
+                for (int channel = 0; channel < numChannels; ++channel) {
+                    const double x = buffer.getSample(channel, i);
+                    peak = juce::jmax(peak, std::abs(x));
+                    squares += x * x;
+
+                    const double weighted = highPass.process(shelf.process(x, shelfStates[channel]), highPassStates[channel]);
+                    stepEnergy += weighted * weighted;
+                }
+
+                ++numFrames;
+                if (++stepPosition == stepLength) {
+                    stepEnergies.push_back(stepEnergy / stepLength);
+                    stepEnergy = 0.0;
+                    stepPosition = 0;
+                }
+            }
+        }
+
+        // LUFS; -inf (as -200) when everything is gated out
+        double getIntegratedLoudness() const
+        {
+            std::vector<double> blocks;
+            for (size_t step = 3; step < stepEnergies.size(); ++step)
+                blocks.push_back(0.25 * (stepEnergies[step - 3] + stepEnergies[step - 2] + stepEnergies[step - 1] + stepEnergies[step]));
+
+            auto gatedLoudness = [&](double gate) {
+                double sum = 0.0;
+                int count = 0;
+                for (auto energy : blocks)
+                    if (toLoudness(energy) > gate) {
+                        sum += energy;
+                        ++count;
+                    }
+                return count > 0 ? toLoudness(sum / count) : -200.0;
+            };
+
+            const double ungated = gatedLoudness(-70.0);
+            return ungated <= -200.0 ? ungated : gatedLoudness(juce::jmax(-70.0, ungated - 10.0));
+        }
+
+        double getPeakDecibels() const { return juce::Decibels::gainToDecibels(peak, -200.0); }
+        double getRmsDecibels() const { return juce::Decibels::gainToDecibels(std::sqrt(squares / static_cast<double>(juce::jmax<juce::int64>(1, numFrames * numChannels))), -200.0); }
+
+    private:
+        static constexpr int maxChannels = 2;
+
+        struct Biquad
+        {
+            double b0, b1, b2, a1, a2;
+
+            double process(double x, double* state) const
+            {
+                const double y = b0 * x + state[0];
+                state[0] = b1 * x - a1 * y + state[1];
+                state[1] = b2 * x - a2 * y;
+                return y;
+            }
+        };
+
+        static double toLoudness(double energy) { return energy > 0.0 ? -0.691 + 10.0 * std::log10(energy) : -200.0; }
+
+        Biquad shelf {}, highPass {};
+        double shelfStates[maxChannels][2] = {}, highPassStates[maxChannels][2] = {};
+        int numChannels = 2;
+        int stepLength = 4800, stepPosition = 0;
+        double stepEnergy = 0.0;
+        std::vector<double> stepEnergies;
+        double peak = 0.0, squares = 0.0;
+        juce::int64 numFrames = 0;
+    };
+
+    //==============================================================================
+    // One point of the sweep grid: its own processor, output file and meter.
+    // The latency is the one prepareToPlay reports for the variant's settings;
+    // a variant whose latency changes while it renders fails, its trim is off.
+    struct SweepVariant
+    {
+        juce::String name;
+        juce::StringPairArray settings;
+        std::unique_ptr<KlipAudioProcessor> processor;
+        std::unique_ptr<juce::AudioFormatWriter> writer;
+        juce::File file;
+        LoudnessMeter meter;
+        juce::AudioBuffer<float> block;
+        int latency = 0;
+        juce::int64 consumed = 0; // processor output so far, latency included
+        juce::int64 written = 0;
+        double seconds = 0.0;
+        bool writeFailed = false;
+        bool latencyChanged = false;
+    };
+
+    juce::var describeMeter(const LoudnessMeter& meter)
+    {
+        auto* stats = new juce::DynamicObject();
+        stats->setProperty("integratedLufs", meter.getIntegratedLoudness());
+        stats->setProperty("peakDbfs", meter.getPeakDecibels());
+        stats->setProperty("rmsDbfs", meter.getRmsDecibels());
+        return juce::var(stats);
+    }
+
+    int runSweep(const juce::ArgumentList& arguments)
+    {
+        const char* const usage = "Usage: KlipCli sweep <input> <output dir> --grid id=v1,v2,... [--grid ...] [--set id=value ...]"
+                                  " [--block-size N] [--threads T]";
+        if (arguments.size() < 3)
+            return fail(usage);
+
+        const auto inputFile = arguments[1].resolveAsFile();
+        const auto outputDirectory = arguments[2].resolveAsFile();
+        if (! outputDirectory.createDirectory())
+            return fail("Can't create " + outputDirectory.getFullPathName());
+
+        const auto blockSizeOption = arguments.getValueForOption("--block-size");
+        const int blockSize = juce::jlimit(16, 65536, blockSizeOption.isEmpty() ? 512 : blockSizeOption.getIntValue());
+        const auto threadsOption = arguments.getValueForOption("--threads|-t");
+        int numThreads = threadsOption.isEmpty() ? juce::SystemStats::getNumCpus() : threadsOption.getIntValue();
+
+        // Grid axes and fixed settings, plain parameter values as with process --set
+        juce::StringArray gridIDs, fixedIDs;
+        std::vector<std::vector<float>> gridValues;
+        std::vector<float> fixedValues;
+        KlipAudioProcessor reference;
+
+        for (int i = 1; i + 1 < arguments.size(); ++i) {
+            const bool grid = arguments[i] == "--grid";
+            if (! grid && arguments[i] != "--set")
+                continue;
+
+            const auto assignment = arguments[++i].text;
+            const auto parameterID = assignment.upToFirstOccurrenceOf("=", false, false);
+            if (reference.getParameters().getParameter(parameterID) == nullptr)
+                return fail("Unknown parameter " + parameterID);
+
+            auto values = juce::StringArray::fromTokens(assignment.fromFirstOccurrenceOf("=", false, false), ",", "");
+            values.removeEmptyStrings();
+            if (values.isEmpty())
+                return fail("No values for " + parameterID);
+            if (grid) {
+                gridIDs.add(parameterID);
+                gridValues.emplace_back();
+                for (const auto& value : values)
+                    gridValues.back().push_back(value.getFloatValue());
+            }
+            else {
+                fixedIDs.add(parameterID);
+                fixedValues.push_back(values[0].getFloatValue());
+            }
+        }
+
+        if (gridIDs.isEmpty())
+            return fail(usage);
+
+        size_t numVariants = 1;
+        for (const auto& values : gridValues)
+            numVariants *= juce::jmax<size_t>(1, values.size());
+        if (numVariants > 4096)
+            return fail("The grid has " + juce::String(static_cast<juce::int64>(numVariants)) + " points, 4096 at most");
+
+        // Decoded once; every variant reads the same blocks
+        juce::AudioFormatManager formats;
+        formats.registerBasicFormats();
+        std::unique_ptr<juce::AudioFormatReader> reader(formats.createReaderFor(inputFile));
+        if (reader == nullptr)
+            return fail("Can't read " + inputFile.getFullPathName());
+
+        const auto decodeStart = Clock::now();
+        const int length = static_cast<int>(reader->lengthInSamples);
+        const double sampleRate = reader->sampleRate;
+        juce::AudioBuffer<float> input(2, length);
+        reader->read(&input, 0, length, 0, true, true);
+        const double decodeSeconds = std::chrono::duration<double>(Clock::now() - decodeStart).count();
+
+        LoudnessMeter inputMeter;
+        inputMeter.prepare(sampleRate, 2);
+        inputMeter.process(input, 0, length);
+
+        std::vector<SweepVariant> variants(numVariants);
+        for (size_t index = 0; index < numVariants; ++index) {
+            auto& variant = variants[index];
+            variant.processor = std::make_unique<KlipAudioProcessor>();
+            auto& processor = *variant.processor;
+
+            // Set before prepareToPlay, which builds what the variant uses
+            auto setParameter = [&](const juce::String& parameterID, float value) {
+                auto* parameter = processor.getParameters().getParameter(parameterID);
+                parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+            };
+
+            for (int fixed = 0; fixed < fixedIDs.size(); ++fixed)
+                setParameter(fixedIDs[fixed], fixedValues[static_cast<size_t>(fixed)]);
+
+            // Mixed radix: the first axis varies fastest
+            variant.name = inputFile.getFileNameWithoutExtension();
+            size_t remainder = index;
+            for (int axis = 0; axis < gridIDs.size(); ++axis) {
+                const auto& values = gridValues[static_cast<size_t>(axis)];
+                const float value = values[remainder % values.size()];
+                remainder /= values.size();
+
+                setParameter(gridIDs[axis], value);
+                variant.settings.set(gridIDs[axis], juce::String(value));
+                variant.name << "_" << gridIDs[axis] << "-" << juce::String(value);
+            }
+
+            processor.setNonRealtime(true);
+            processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+            processor.prepareToPlay(sampleRate, blockSize);
+            variant.latency = processor.getLatencySamples();
+
+            variant.file = outputDirectory.getChildFile(variant.name + ".wav");
+            variant.writer = createWavWriter(variant.file, sampleRate, 2);
+            if (variant.writer == nullptr)
+                return fail("Can't write " + variant.file.getFullPathName());
+
+            variant.meter.prepare(sampleRate, 2);
+            variant.block.setSize(2, blockSize);
+        }
+
+        // Each worker owns every numThreads-th variant and walks the input once,
+        // running all of its variants on a block while it's in cache
+        numThreads = juce::jlimit(1, static_cast<int>(numVariants), numThreads);
+        std::cerr << "Sweep: " << numVariants << " variants of " << length << " samples on " << numThreads << " threads" << std::endl;
+
+        const auto renderStart = Clock::now();
+        std::vector<std::thread> workers;
+        for (int thread = 0; thread < numThreads; ++thread) {
+            workers.emplace_back([&, thread] {
+                juce::MidiBuffer midi;
+
+                for (juce::int64 position = 0;; position += blockSize) {
+                    bool pending = false;
+
+                    for (size_t index = static_cast<size_t>(thread); index < numVariants; index += static_cast<size_t>(numThreads)) {
+                        auto& variant = variants[index];
+                        if (variant.written >= length)
+                            continue;
+                        pending = true;
+
+                        // Past the end of the input: zeros, flushing the latency out
+                        auto& block = variant.block;
+                        const int available = static_cast<int>(juce::jlimit<juce::int64>(0, blockSize, length - position));
+                        block.clear();
+                        for (int channel = 0; channel < 2; ++channel)
+                            block.copyFrom(channel, 0, input, channel, static_cast<int>(juce::jmin<juce::int64>(position, length)), available);
+
+                        const auto start = Clock::now();
+                        variant.processor->processBlock(block, midi);
+                        variant.seconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+                        variant.latencyChanged = variant.latencyChanged || variant.processor->getLatencySamples() != variant.latency;
+
+                        const int skip = static_cast<int>(juce::jlimit<juce::int64>(0, blockSize, variant.latency - variant.consumed));
+                        const int count = static_cast<int>(juce::jmin<juce::int64>(blockSize - skip, length - variant.written));
+                        variant.consumed += blockSize;
+                        if (count <= 0)
+                            continue;
+
+                        variant.meter.process(block, skip, count);
+                        variant.writeFailed = variant.writeFailed || ! variant.writer->writeFromAudioSampleBuffer(block, skip, count);
+                        variant.written += count;
+                    }
+
+                    if (! pending)
+                        break;
+                }
+            });
+        }
+
+        for (auto& worker : workers)
+            worker.join();
+        const double renderSeconds = std::chrono::duration<double>(Clock::now() - renderStart).count();
+
+        // Report: one entry per variant, next to the input's own stats
+        juce::Array<juce::var> entries;
+        double processorSeconds = 0.0;
+        bool failed = false;
+
+        for (auto& variant : variants) {
+            variant.writer.reset(); // flushes the file
+            failed = failed || variant.writeFailed || variant.latencyChanged;
+            processorSeconds += variant.seconds;
+            if (variant.latencyChanged)
+                std::cerr << variant.name << ": latency changed during the render, output and stats misaligned" << std::endl;
+
+            auto entry = describeMeter(variant.meter);
+            auto* object = entry.getDynamicObject();
+            object->setProperty("file", variant.file.getFileName());
+            object->setProperty("latency", variant.latency);
+            object->setProperty("seconds", variant.seconds);
+            object->setProperty("latencyChanged", variant.latencyChanged);
+
+            auto* settings = new juce::DynamicObject();
+            for (const auto& key : variant.settings.getAllKeys())
+                settings->setProperty(key, variant.settings[key].getFloatValue());
+            object->setProperty("settings", juce::var(settings));
+            entries.add(entry);
+
+            std::cout << variant.name.paddedRight(' ', 40) << juce::String(variant.meter.getIntegratedLoudness(), 2) << " LUFS  peak "
+                      << juce::String(variant.meter.getPeakDecibels(), 2) << " dBFS  rms " << juce::String(variant.meter.getRmsDecibels(), 2)
+                      << " dBFS" << std::endl;
+        }
+
+        auto* report = new juce::DynamicObject();
+        report->setProperty("input", inputFile.getFullPathName());
+        report->setProperty("sampleRate", sampleRate);
+        report->setProperty("length", length);
+        report->setProperty("blockSize", blockSize);
+        report->setProperty("threads", numThreads);
+        report->setProperty("decodeSeconds", decodeSeconds);
+        report->setProperty("renderSeconds", renderSeconds);
+        // Processing time summed over the variants: what N renders back to back would spend in the DSP
+        report->setProperty("processorSeconds", processorSeconds);
+        report->setProperty("inputStats", describeMeter(inputMeter));
+        report->setProperty("variants", entries);
+        outputDirectory.getChildFile("sweep.json").replaceWithText(juce::JSON::toString(juce::var(report)));
+
+        std::cout << numVariants << " variants in " << juce::String(renderSeconds, 2) << " s (decoded once in "
+                  << juce::String(decodeSeconds, 2) << " s, " << juce::String(processorSeconds, 2) << " s of processing)" << std::endl;
+        return failed ? 1 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const juce::ArgumentList arguments(argc, argv);
+
+    if (arguments.size() > 0 && arguments[0] == "process")
+        return runProcess(arguments);
+    if (arguments.size() > 0 && arguments[0] == "replay")
+        return runReplay(arguments);
+    if (arguments.size() > 0 && arguments[0] == "sweep")
+        return runSweep(arguments);
+
+    std::cerr << "Usage: KlipCli process <input> <output.wav> [--block-size N] [--set id=value ...] [--auto-threshold P]" << std::endl
+              << "       KlipCli replay <capture.klipcapture> [--repeat N] [--output out.wav]" << std::endl
+              << "       KlipCli sweep <input> <output dir> --grid id=v1,v2,... [--grid ...] [--set id=value ...] [--block-size N] [--threads T]" << std::endl;
+    return 1;
+}
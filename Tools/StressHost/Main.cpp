@@ -0,0 +1,386 @@
+/*
+  ==============================================================================
+
+    Main.cpp
+
+    Headless multi-instance host: builds N KlipAudioProcessor instances in one
+    process, drives them from T worker threads with a music-like test signal and
+    randomised parameters, and writes a JSON report (per-instance CPU, memory,
+    construction/prepareToPlay time, heap use in processBlock, interference).
+
+    Interference check: a probe instance with fixed parameters runs alongside
+    the others and must produce bit-identical blocks to the same instance run
+    alone beforehand. Any state shared between instances shows up as a mismatch.
+
+    Usage: KlipStressHost [--instances N] [--threads T] [--blocks B]
+                          [--block-size S] [--sample-rate R] [--output file.json]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include <chrono>
+#include <thread>
+#include "../../Source/PluginProcessor.h"
+#include "../../Source/AllocationGuard.h"
+#include "../../Source/SharedTableCache.h"
+
+#if JUCE_LINUX
+ #include <unistd.h>
+#elif JUCE_MAC
+ #include <mach/mach.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #if JUCE_MSVC
+  #pragma comment (lib, "psapi.lib")
+ #endif
+#endif
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Config
+    {
+        int instances = 64;
+        int threads = juce::jmax(1, juce::SystemStats::getNumCpus());
+        int blocks = 2000;
+        int blockSize = 512;
+        double sampleRate = 48000.0;
+        int randomiseEvery = 8; // blocks between parameter changes
+        int probeBlocks = 400;
+        juce::File output;
+    };
+
+    struct InstanceStats
+    {
+        double constructMicros = 0.0;
+        double prepareMicros = 0.0;
+        double totalNanos = 0.0;
+        double maxNanos = 0.0;
+        int blocks = 0;
+    };
+
+    // Resident set size of the process, 0 where the platform call isn't wired up.
+    size_t getResidentBytes()
+    {
+       #if JUCE_LINUX
+        // Second field of /proc/self/statm, in pages
+        const auto fields = juce::StringArray::fromTokens(juce::File("/proc/self/statm").loadFileAsString(), false);
+        return fields.size() > 1 ? static_cast<size_t>(fields[1].getLargeIntValue()) * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+       #elif JUCE_MAC
+        mach_task_basic_info info;
+        mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+        if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) == KERN_SUCCESS)
+            return static_cast<size_t>(info.resident_size);
+        return 0;
+       #elif JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+            return static_cast<size_t>(counters.WorkingSetSize);
+        return 0;
+       #else
+        return 0;
+       #endif
+    }
+
+    double microsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+    }
+
+    // Ten seconds of stereo test signal: a few partials with a slow envelope, a
+    // kick-like low burst every half second and some noise. Instances read it at
+    // different offsets so they don't all clip in lockstep.
+    juce::AudioBuffer<float> makeTestSignal(double sampleRate)
+    {
+        const int length = static_cast<int>(sampleRate * 10.0);
+        juce::AudioBuffer<float> signal(2, length);
+        juce::Random random(42);
+        const double twoPi = juce::MathConstants<double>::twoPi;
+
+        for (int i = 0; i < length; ++i) {
+            const double t = i / sampleRate;
+            const double envelope = 0.6 + 0.4 * std::sin(twoPi * 0.25 * t);
+            const double kickPhase = std::fmod(t, 0.5);
+            const double kick = std::exp(-kickPhase * 18.0) * std::sin(twoPi * (50.0 + 80.0 * std::exp(-kickPhase * 30.0)) * kickPhase);
+            const double tones = 0.3 * std::sin(twoPi * 110.0 * t) + 0.2 * std::sin(twoPi * 331.0 * t) + 0.1 * std::sin(twoPi * 1320.0 * t);
+
+            for (int channel = 0; channel < 2; ++channel) {
+                const double noise = 0.05 * (random.nextDouble() * 2.0 - 1.0);
+                const double width = channel == 0 ? 1.0 : 0.8;
+                signal.setSample(channel, i, static_cast<float>(envelope * (0.9 * kick + width * tones) + noise));
+            }
+        }
+
+        return signal;
+    }
+
+    void fillBlock(juce::AudioBuffer<float>& block, const juce::AudioBuffer<float>& signal, int position)
+    {
+        const int length = signal.getNumSamples();
+        for (int channel = 0; channel < 2; ++channel)
+            for (int i = 0; i < block.getNumSamples(); ++i)
+                block.setSample(channel, i, signal.getSample(channel, (position + i) % length));
+    }
+
+    void setParameter(KlipAudioProcessor& processor, const char* parameterID, float normalisedValue)
+    {
+        processor.getParameters().getParameter(parameterID)->setValueNotifyingHost(normalisedValue);
+    }
+
+    void randomiseParameters(KlipAudioProcessor& processor, juce::Random& random)
+    {
+        for (auto* parameterID : { "threshold", "clipType", "msProcessing", "kneeWidth", "dcCutoff" })
+            setParameter(processor, parameterID, random.nextFloat());
+
+        // Mostly time-domain, like real sessions
+        setParameter(processor, "engine", random.nextInt(8) == 0 ? 1.0f : 0.0f);
+    }
+
+    // The probe settings: everything away from the defaults so a leak has something to show
+    void setProbeParameters(KlipAudioProcessor& processor)
+    {
+        setParameter(processor, "threshold", 0.3f);
+        setParameter(processor, "clipType", 0.5f);
+        setParameter(processor, "msProcessing", 1.0f);
+        setParameter(processor, "kneeWidth", 0.7f);
+        setParameter(processor, "dcCutoff", 0.5f);
+    }
+
+    uint64_t hashBlock(const juce::AudioBuffer<float>& block)
+    {
+        // FNV-1a over the raw sample bits
+        uint64_t hash = 14695981039346656037ull;
+        for (int channel = 0; channel < block.getNumChannels(); ++channel) {
+            const auto* bytes = reinterpret_cast<const uint8_t*>(block.getReadPointer(channel));
+            for (size_t i = 0; i < sizeof(float) * static_cast<size_t>(block.getNumSamples()); ++i)
+                hash = (hash ^ bytes[i]) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::unique_ptr<KlipAudioProcessor> createInstance(const Config& config, InstanceStats& stats)
+    {
+        auto start = Clock::now();
+        auto processor = std::make_unique<KlipAudioProcessor>();
+        stats.constructMicros = microsSince(start);
+
+        start = Clock::now();
+        processor->setPlayConfigDetails(2, 2, config.sampleRate, config.blockSize);
+        processor->prepareToPlay(config.sampleRate, config.blockSize);
+        stats.prepareMicros = microsSince(start);
+
+        return processor;
+    }
+
+    std::vector<uint64_t> runProbeAlone(const Config& config, const juce::AudioBuffer<float>& signal)
+    {
+        InstanceStats unused;
+        auto probe = createInstance(config, unused);
+        setProbeParameters(*probe);
+
+        juce::AudioBuffer<float> block(2, config.blockSize);
+        juce::MidiBuffer midi;
+        std::vector<uint64_t> hashes;
+
+        for (int b = 0; b < config.probeBlocks; ++b) {
+            fillBlock(block, signal, b * config.blockSize);
+            probe->processBlock(block, midi);
+            hashes.push_back(hashBlock(block));
+        }
+
+        return hashes;
+    }
+
+    Config parseArguments(const juce::ArgumentList& arguments)
+    {
+        Config config;
+        auto intOption = [&](const char* option, int fallback) {
+            const auto value = arguments.getValueForOption(option);
+            return value.isEmpty() ? fallback : value.getIntValue();
+        };
+
+        config.instances = juce::jlimit(1, 4096, intOption("--instances|-n", config.instances));
+        config.threads = juce::jlimit(1, 256, intOption("--threads|-t", config.threads));
+        config.blocks = juce::jmax(1, intOption("--blocks|-b", config.blocks));
+        config.blockSize = juce::jlimit(16, 8192, intOption("--block-size", config.blockSize));
+        config.probeBlocks = juce::jmin(config.probeBlocks, config.blocks);
+
+        const auto sampleRate = arguments.getValueForOption("--sample-rate");
+        if (sampleRate.isNotEmpty())
+            config.sampleRate = sampleRate.getDoubleValue();
+
+        const auto output = arguments.getValueForOption("--output|-o");
+        if (output.isNotEmpty())
+            config.output = juce::File::getCurrentWorkingDirectory().getChildFile(output);
+
+        return config;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    const auto config = parseArguments(juce::ArgumentList(argc, argv));
+    const auto signal = makeTestSignal(config.sampleRate);
+
+    std::cerr << "Klip stress host: " << config.instances << " instances, " << config.threads << " threads, "
+              << config.blocks << " blocks of " << config.blockSize << " @ " << config.sampleRate << " Hz" << std::endl;
+
+    // Reference run before anything else exists
+    const auto probeReference = runProbeAlone(config, signal);
+
+    const size_t residentAtStart = getResidentBytes();
+    std::vector<InstanceStats> stats(static_cast<size_t>(config.instances) + 1);
+    std::vector<std::unique_ptr<KlipAudioProcessor>> instances;
+
+    for (int i = 0; i <= config.instances; ++i)
+        instances.push_back(createInstance(config, stats[static_cast<size_t>(i)]));
+
+    const size_t residentAfterPrepare = getResidentBytes();
+    const int sharedTables = SharedTableCache::getNumLiveTables();
+
+    // The last instance is the probe
+    const int probeIndex = config.instances;
+    setProbeParameters(*instances[static_cast<size_t>(probeIndex)]);
+    std::vector<uint64_t> probeHashes(static_cast<size_t>(config.probeBlocks), 0);
+
+    const int violationsBefore = ScopedAllocationGuard::getViolationCount();
+    const auto runStart = Clock::now();
+
+    std::vector<std::thread> workers;
+    for (int thread = 0; thread < config.threads; ++thread) {
+        workers.emplace_back([&, thread] {
+            juce::Random random(1000 + thread);
+            juce::AudioBuffer<float> block(2, config.blockSize);
+            juce::MidiBuffer midi;
+
+            for (int b = 0; b < config.blocks; ++b) {
+                for (int i = thread; i <= config.instances; i += config.threads) {
+                    auto& processor = *instances[static_cast<size_t>(i)];
+                    auto& instanceStats = stats[static_cast<size_t>(i)];
+                    const bool isProbe = i == probeIndex;
+
+                    if (! isProbe && b % config.randomiseEvery == 0)
+                        randomiseParameters(processor, random);
+
+                    const int position = isProbe ? b * config.blockSize : (b + i * 997) * config.blockSize;
+                    fillBlock(block, signal, position);
+
+                    const auto start = Clock::now();
+                    processor.processBlock(block, midi);
+                    const double nanos = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+                    instanceStats.totalNanos += nanos;
+                    instanceStats.maxNanos = juce::jmax(instanceStats.maxNanos, nanos);
+                    ++instanceStats.blocks;
+
+                    if (isProbe && b < config.probeBlocks)
+                        probeHashes[static_cast<size_t>(b)] = hashBlock(block);
+                }
+            }
+        });
+    }
+
+    for (auto& worker : workers)
+        worker.join();
+
+    const double wallSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+    // Grows past residentAfterPrepare by what instances built once the run enabled it
+    const size_t residentAfterRun = getResidentBytes();
+    const int allocations = ScopedAllocationGuard::getViolationCount() - violationsBefore;
+
+    // Interference
+    int mismatchedBlocks = 0;
+    int firstMismatch = -1;
+    for (int b = 0; b < config.probeBlocks; ++b) {
+        if (probeHashes[static_cast<size_t>(b)] != probeReference[static_cast<size_t>(b)]) {
+            ++mismatchedBlocks;
+            if (firstMismatch < 0)
+                firstMismatch = b;
+        }
+    }
+
+    // Report
+    const double blockBudgetNanos = 1.0e9 * config.blockSize / config.sampleRate;
+    double meanNanos = 0.0;
+    double worstNanos = 0.0;
+    double meanConstructMicros = 0.0;
+    double meanPrepareMicros = 0.0;
+    juce::Array<juce::var> perInstance;
+
+    for (int i = 0; i < config.instances; ++i) {
+        const auto& s = stats[static_cast<size_t>(i)];
+        const double mean = s.totalNanos / juce::jmax(1, s.blocks);
+        meanNanos += mean / config.instances;
+        meanConstructMicros += s.constructMicros / config.instances;
+        meanPrepareMicros += s.prepareMicros / config.instances;
+        worstNanos = juce::jmax(worstNanos, s.maxNanos);
+
+        auto* entry = new juce::DynamicObject();
+        entry->setProperty("index", i);
+        entry->setProperty("thread", i % config.threads);
+        entry->setProperty("constructMicros", s.constructMicros);
+        entry->setProperty("prepareMicros", s.prepareMicros);
+        entry->setProperty("meanNanosPerBlock", mean);
+        entry->setProperty("maxNanosPerBlock", s.maxNanos);
+        entry->setProperty("cpuPercent", 100.0 * mean / blockBudgetNanos);
+        perInstance.add(juce::var(entry));
+    }
+
+    auto* configObject = new juce::DynamicObject();
+    configObject->setProperty("instances", config.instances);
+    configObject->setProperty("threads", config.threads);
+    configObject->setProperty("blocks", config.blocks);
+    configObject->setProperty("blockSize", config.blockSize);
+    configObject->setProperty("sampleRate", config.sampleRate);
+    configObject->setProperty("kernels", juce::String(ClipKernels::get().name));
+    configObject->setProperty("cpu", juce::SystemStats::getCpuModel());
+    configObject->setProperty("numCpus", juce::SystemStats::getNumCpus());
+
+    const auto residentGrowth = static_cast<double>(residentAfterPrepare) - static_cast<double>(residentAtStart);
+    auto* summary = new juce::DynamicObject();
+    summary->setProperty("wallSeconds", wallSeconds);
+    summary->setProperty("audioSeconds", config.blocks * config.blockSize / config.sampleRate);
+    summary->setProperty("meanCpuPercentPerInstance", 100.0 * meanNanos / blockBudgetNanos);
+    summary->setProperty("worstBlockNanos", worstNanos);
+    summary->setProperty("blockBudgetNanos", blockBudgetNanos);
+    // Instances one machine keeps in real time at this load, all threads busy
+    summary->setProperty("estimatedMaxInstances", meanNanos > 0.0 ? static_cast<int>(config.threads * blockBudgetNanos / meanNanos) : 0);
+    summary->setProperty("residentBytesAtStart", static_cast<juce::int64>(residentAtStart));
+    summary->setProperty("residentBytesAfterPrepare", static_cast<juce::int64>(residentAfterPrepare));
+    summary->setProperty("residentBytesPerInstance", residentGrowth / (config.instances + 1));
+    summary->setProperty("residentBytesAfterRun", static_cast<juce::int64>(residentAfterRun));
+    summary->setProperty("meanConstructMicros", meanConstructMicros);
+    summary->setProperty("meanPrepareMicros", meanPrepareMicros);
+    // Same count for any number of instances with the same settings
+    summary->setProperty("sharedTables", sharedTables);
+    summary->setProperty("processBlockAllocations", allocations);
+
+    auto* interference = new juce::DynamicObject();
+    interference->setProperty("probeBlocks", config.probeBlocks);
+    interference->setProperty("mismatchedBlocks", mismatchedBlocks);
+    interference->setProperty("firstMismatch", firstMismatch);
+
+    auto* report = new juce::DynamicObject();
+    report->setProperty("config", juce::var(configObject));
+    report->setProperty("summary", juce::var(summary));
+    report->setProperty("interference", juce::var(interference));
+    report->setProperty("instances", perInstance);
+
+    const auto json = juce::JSON::toString(juce::var(report));
+    if (config.output == juce::File())
+        std::cout << json << std::endl;
+    else
+        config.output.replaceWithText(json);
+
+    std::cerr << "mean " << juce::String(100.0 * meanNanos / blockBudgetNanos, 3) << "% CPU per instance, "
+              << "~" << static_cast<int>(residentGrowth / (config.instances + 1) / 1024.0) << " KiB per idle instance, "
+              << juce::String(meanConstructMicros + meanPrepareMicros, 1) << " us to construct and prepare, "
+              << allocations << " allocations in processBlock, "
+              << mismatchedBlocks << " probe mismatches" << std::endl;
+
+    return allocations == 0 && mismatchedBlocks == 0 ? 0 : 1;
+}